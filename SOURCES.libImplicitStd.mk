@@ -4,10 +4,21 @@
 
 SOURCES_libImplicitStd :=
 SOURCES_libImplicitStd += src/UnattendedMode.cpp
+SOURCES_libImplicitStd += src/EnvironUtil.cpp
 SOURCES_libImplicitStd += src/AppSettings.cpp
+SOURCES_libImplicitStd += src/AppSettingsConcurrent.cpp
+SOURCES_libImplicitStd += src/AppSettingsShared.cpp
+SOURCES_libImplicitStd += src/SettingHandle.cpp
+SOURCES_libImplicitStd += src/SettingsBinding.cpp
+SOURCES_libImplicitStd += src/SettingsKeyIndex.cpp
+SOURCES_libImplicitStd += src/FlatStringMap.cpp
 SOURCES_libImplicitStd += src/ConfigParse.cpp
 SOURCES_libImplicitStd += src/fs.cpp
+SOURCES_libImplicitStd += src/CompactPath.cpp
+SOURCES_libImplicitStd += src/DirEnumerator.cpp
+SOURCES_libImplicitStd += src/DirWalker.cpp
 SOURCES_libImplicitStd += src/standardfilesystem.cpp
+SOURCES_libImplicitStd += src/cachingfilesystem.cpp
 SOURCES_libImplicitStd += src/StringBuilder.cpp
 SOURCES_libImplicitStd += src/StringUtil.cpp
 SOURCES_libImplicitStd += src/strtosj.cpp
@@ -22,6 +33,16 @@ endif
 
 SOURCES_libImplicitStd += src/filesystem.std.cpp
 SOURCES_libImplicitStd += src/posix_file.cpp
+SOURCES_libImplicitStd += src/AsyncFileIO.cpp
+SOURCES_libImplicitStd += src/MappedFile.cpp
+SOURCES_libImplicitStd += src/DirectFileReader.cpp
+SOURCES_libImplicitStd += src/BufferedFile.cpp
+SOURCES_libImplicitStd += src/InputStream.cpp
+SOURCES_libImplicitStd += src/VirtualFileSystem.cpp
+SOURCES_libImplicitStd += src/PackArchive.cpp
+SOURCES_libImplicitStd += src/MemoryFileSystem.cpp
+SOURCES_libImplicitStd += src/FileWatcher.cpp
+SOURCES_libImplicitStd += src/InotifyReader.cpp
 
 # HAS_DLSYM should only be set TRUE for Linux/Posix OS.
 ifeq ($(HAS_DLSYM),1)
@@ -0,0 +1,102 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// AsyncFileIO - asynchronous file operations with completion callbacks or futures.
+//
+// On Linux the operations are submitted to an io_uring, which allows many requests to be in flight at
+// once from a single thread (high queue depth is required to saturate NVMe). Elsewhere, or where io_uring
+// is unavailable (old kernels, seccomp sandboxes), operations are executed by a thread pool using the
+// synchronous posix_file.h calls. Both backends provide identical semantics.
+//
+// Results follow the io_uring convention: a non-negative value on success (bytes transferred, or the new
+// fd for open), or a negated errno on failure.
+//
+// Usage Notes:
+//   - callbacks are invoked on an internal completion thread (or pool thread), never from the submitting
+//     call. Keep them short; long-running work should be handed off elsewhere.
+//   - buffers and CStatInfo destinations must remain valid until the operation completes.
+//   - submission is thread safe. When more operations are in flight than the completion queue can hold,
+//     submission blocks until some complete. Callbacks may submit further operations, but should not
+//     do so when the queue may be full, since the completion thread would then wait on itself.
+//   - the destructor waits for all outstanding operations to complete.
+//   - pread/pwrite may complete short, same as their synchronous counterparts.
+
+#include "posix_file.h"
+
+#include <functional>
+#include <future>
+#include <memory>
+
+#if !PLATFORM_MSW
+#	include <sys/uio.h>
+#endif
+
+struct AsyncFileOp;
+class AsyncFileIOBackend;
+
+using AsyncFileCallback = std::function<void(intmax_t result)>;
+
+#if PLATFORM_MSW
+struct iovec {
+	void*	iov_base;
+	size_t	iov_len;
+};
+#endif
+
+struct AsyncFileIOOptions {
+	unsigned	queue_depth			= 256;		// io_uring submission queue size
+	int			fallback_threads	= 4;		// thread pool size when io_uring is not used
+	bool		force_fallback		= false;	// use the thread pool even where io_uring is available
+};
+
+class AsyncFileIO
+{
+protected:
+	std::unique_ptr<AsyncFileIOBackend>	m_backend;
+
+public:
+	AsyncFileIO(const AsyncFileIOOptions& options = {});
+	~AsyncFileIO();
+
+	AsyncFileIO(const AsyncFileIO&) = delete;
+	AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+	bool	using_io_uring	() const;
+
+	void	pread		(int fd, void* dest, size_t size, x_off_t offset, AsyncFileCallback cb);
+	void	pwrite		(int fd, const void* src, size_t size, x_off_t offset, AsyncFileCallback cb);
+	void	open		(const char* path, int flags, int mode, AsyncFileCallback cb);
+	void	close		(int fd, AsyncFileCallback cb);
+	void	fsync		(int fd, bool datasync, AsyncFileCallback cb);
+	void	statx		(const char* path, CStatInfo* dest, AsyncFileCallback cb);
+
+	std::future<intmax_t>	pread	(int fd, void* dest, size_t size, x_off_t offset);
+	std::future<intmax_t>	pwrite	(int fd, const void* src, size_t size, x_off_t offset);
+	std::future<intmax_t>	open	(const char* path, int flags, int mode);
+	std::future<intmax_t>	close	(int fd);
+	std::future<intmax_t>	fsync	(int fd, bool datasync);
+	std::future<intmax_t>	statx	(const char* path, CStatInfo* dest);
+
+	// Registered buffers and fixed files let the kernel skip per-operation page pinning and fd lookups.
+	// Each call replaces any previous registration, and must not be made while fixed operations are in
+	// flight. Returns 0 on success or a negated errno. The fallback backend accepts registrations so that
+	// callers need not special-case it.
+	int		register_buffers	(const iovec* buffers, unsigned count);
+	int		register_files		(const int* fds, unsigned count);
+	void	unregister_buffers	();
+	void	unregister_files	();
+
+	// fileIndex indexes the registered files, and [dest, dest+size) must lie within registered buffer
+	// bufferIndex.
+	void	pread_fixed		(int fileIndex, void* dest, size_t size, x_off_t offset, unsigned bufferIndex, AsyncFileCallback cb);
+	void	pwrite_fixed	(int fileIndex, const void* src, size_t size, x_off_t offset, unsigned bufferIndex, AsyncFileCallback cb);
+
+	// blocks until all operations submitted so far have completed and their callbacks have returned.
+	void	wait_idle		();
+
+protected:
+	void	_submit			(AsyncFileOp* op);
+
+	template<typename SubmitFunc>
+	std::future<intmax_t> _asFuture(SubmitFunc&& submit);
+};
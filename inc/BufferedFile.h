@@ -0,0 +1,146 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// BufferedReader / BufferedWriter - sequential file I/O on raw fds, without stdio.
+//
+// stdio takes a lock on every call and defaults to small (4K-8K) buffers, which caps throughput for
+// line-oriented parsing and bulk writes well below what the disk can provide. These classes read and
+// write in large chunks via posix_read/writev, and hand out views into their buffers rather than copying.
+//
+//     BufferedReader reader;
+//     if (reader.open(path)) {
+//         std::string_view line;
+//         while (reader.readLine(line)) { ... }
+//     }
+//
+// Usage Notes:
+//   - not thread safe. A BufferedWriter with background writes uses a thread internally, but the object
+//     itself must still be used from one thread at a time.
+//   - write errors are sticky: once a write fails, further writes are discarded and flush()/close()
+//     return FALSE. error() holds the errno of the first failure.
+//   - a BufferedWriter must be flushed or closed to guarantee that data reaches the fd. The destructor
+//     closes, but cannot report errors.
+
+#include "fs.h"
+#include "posix_file.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+struct BufferedReaderOptions {
+	size_t	buffer_size		= 256 * 1024;
+	bool	readahead		= true;		// advise the OS that the file will be read sequentially
+};
+
+class BufferedReader
+{
+protected:
+	std::unique_ptr<char[]>	m_buffer;
+	size_t		m_capacity	= 0;
+	size_t		m_pos		= 0;		// consume position within the buffer
+	size_t		m_end		= 0;		// end of valid data within the buffer
+	int			m_fd		= -1;
+	int			m_error		= 0;
+	bool		m_owns_fd	= false;
+	bool		m_eof		= false;	// the fd has reported end of file
+	BufferedReaderOptions	m_options;
+
+public:
+	BufferedReader(const BufferedReaderOptions& options = {});
+	~BufferedReader();
+
+	BufferedReader(const BufferedReader&) = delete;
+	BufferedReader& operator=(const BufferedReader&) = delete;
+
+	bool	open		(const fs::path& path);
+	bool	open		(const char* path);
+
+	// reads from an fd which is already open, from its current position. If takeOwnership, the fd is
+	// closed along with the reader.
+	void	attach		(int fd, bool takeOwnership = false);
+	void	close		();
+
+	bool	is_open		() const	{ return m_fd >= 0; }
+	int		error		() const	{ return m_error; }
+	int		fd			() const	{ return m_fd; }
+
+	// TRUE once all data has been consumed.
+	bool	eof			() const	{ return m_eof && m_pos == m_end; }
+
+	// reads up to size bytes. Returns the number of bytes read, which is less than size only at the end
+	// of the file, or -1 on error. Reads larger than the buffer bypass it.
+	intmax_t	read		(void* dest, size_t size);
+
+	// reads the next line, excluding its line ending (LF or CRLF). The view remains valid until the next
+	// call to any read method, and is NUL-terminated, so line.data() may be passed to C string functions.
+	// The last line of a file need not be terminated. Returns FALSE at end of file or on error.
+	bool		readLine	(std::string_view& line);
+
+protected:
+	bool		_fill		();
+	bool		_grow		(size_t minCapacity);
+};
+
+struct BufferedWriterOptions {
+	size_t	buffer_size		= 256 * 1024;
+
+	// writes are issued from a background thread, so that the caller can fill one buffer while the
+	// previous one is being written. Worthwhile when producing data is as costly as writing it.
+	bool	background		= false;
+};
+
+class BufferedWriter
+{
+protected:
+	std::unique_ptr<char[]>	m_buffer;
+	size_t		m_capacity	= 0;
+	size_t		m_used		= 0;
+	int			m_fd		= -1;
+	int			m_error		= 0;
+	bool		m_owns_fd	= false;
+	BufferedWriterOptions	m_options;
+
+	// background writes: m_pending holds a full buffer handed to the writer thread, which swaps it back
+	// empty once written.
+	std::unique_ptr<char[]>		m_pending;
+	size_t						m_pending_size	= 0;
+	int							m_pending_error	= 0;		// reported by the writer thread
+	bool						m_pending_busy	= false;
+	bool						m_stopping		= false;
+	std::mutex					m_mutex;
+	std::condition_variable		m_cv;
+	std::thread					m_thread;
+
+public:
+	BufferedWriter(const BufferedWriterOptions& options = {});
+	~BufferedWriter();
+
+	BufferedWriter(const BufferedWriter&) = delete;
+	BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+	bool	open		(const fs::path& path, int flags = O_WRONLY | O_CREAT | O_TRUNC, int mode = DEFFILEMODE);
+	bool	open		(const char* path, int flags = O_WRONLY | O_CREAT | O_TRUNC, int mode = DEFFILEMODE);
+	void	attach		(int fd, bool takeOwnership = false);
+
+	// flushes and closes. Returns FALSE if any write failed.
+	bool	close		();
+
+	bool	is_open		() const	{ return m_fd >= 0; }
+	int		error		() const	{ return m_error; }
+	int		fd			() const	{ return m_fd; }
+
+	bool	write		(const void* src, size_t size);
+	bool	write		(std::string_view str)		{ return write(str.data(), str.size()); }
+
+	// writes all buffered data to the fd, waiting for background writes to complete.
+	bool	flush		();
+
+protected:
+	bool	_writeAll		(const void* head, size_t headSize, const void* tail, size_t tailSize);
+	void	_setError		(int err);
+	void	_waitPending	();
+	void	_writerThread	();
+};
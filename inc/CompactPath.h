@@ -0,0 +1,180 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// fs::CompactPath - allocation-averse alternative to fs::path, for hot paths that build, inspect and open
+// many short-lived paths.
+//
+// Differences from fs::path:
+//   - the universal path is stored in an inline buffer. Only paths longer than kInlineCapacity touch the heap.
+//   - input that is already in universal form (no backslashes or drive/mount colons) is copied as-is,
+//     without going through PathFromString/ConvertFromMsw.
+//   - the native (libc) path is not computed on mutation. It is converted on demand, either into a caller-
+//     provided NativePathBuffer (typically on the stack) or into a lazily-cached string via c_str().
+//   - filename(), extension(), stem() and parent_path() return views into the path.
+//
+// On platforms where FILESYSTEM_NEEDS_OS_PATH is 0, the universal path is the native path, and native()
+// returns the inline buffer directly.
+//
+// Usage Notes:
+//   - c_str() caches the native path into the object, so it is not safe to call concurrently on a shared
+//     instance (on FILESYSTEM_NEEDS_OS_PATH platforms). Prefer native(NativePathBuffer&) in threaded code.
+//   - views returned by accessors are invalidated by any mutation of the path.
+
+#include "fs.h"
+
+#include <string_view>
+#include <cstring>
+
+#if !defined(FILESYSTEM_NATIVE_PATH_MAX)
+#	define FILESYSTEM_NATIVE_PATH_MAX	(1024)
+#endif
+
+namespace fs {
+
+struct NativePathBuffer {
+	char	data[FILESYSTEM_NATIVE_PATH_MAX];
+};
+
+class CompactPath
+{
+public:
+	static constexpr uint32_t kInlineCapacity = 95;		// excluding NUL terminator
+
+protected:
+	char*		m_data;				// points at m_inline, or heap storage
+	uint32_t	m_length	= 0;
+	uint32_t	m_capacity	= kInlineCapacity;
+	char		m_inline[kInlineCapacity + 1];
+
+#if FILESYSTEM_NEEDS_OS_PATH
+	mutable std::string	m_native;
+	mutable bool		m_native_valid = false;
+#endif
+
+	static constexpr char separator = '/';
+
+public:
+	CompactPath() {
+		m_data = m_inline;
+		m_inline[0] = 0;
+	}
+
+	CompactPath(char const* src) : CompactPath() {
+		assign(src);
+	}
+
+	CompactPath(std::string const& src) : CompactPath() {
+		assign(src);
+	}
+
+	CompactPath(std::string_view src) : CompactPath() {
+		assign(src);
+	}
+
+	CompactPath(fs::path const& src) : CompactPath() {
+		_assign_uni(src.uni_string());
+	}
+
+	CompactPath(CompactPath const& rhs) : CompactPath() {
+		_assign_uni(rhs.uni_view());
+	}
+
+	CompactPath(CompactPath&& rhs) : CompactPath() {
+		*this = std::move(rhs);
+	}
+
+	~CompactPath() {
+		if (m_data != m_inline) {
+			delete[] m_data;
+		}
+	}
+
+	CompactPath& operator=(CompactPath const& rhs) {
+		if (this != &rhs) {
+			_assign_uni(rhs.uni_view());
+		}
+		return *this;
+	}
+
+	CompactPath& operator=(CompactPath&& rhs);
+
+	CompactPath& operator=(char const* src)			{ return assign(src); }
+	CompactPath& operator=(std::string_view src)	{ return assign(src); }
+
+	// accepts universal or msw-style paths, same as fs::path.
+	CompactPath& assign(std::string_view src);
+
+	bool		empty		() const	{ return m_length == 0; }
+	size_t		length		() const	{ return m_length; }
+	bool		is_inline	() const	{ return m_data == m_inline; }
+	void		clear		();
+
+	CompactPath& append	(std::string_view comp);
+	CompactPath& concat	(std::string_view src);
+
+	CompactPath& operator /= (char const* comp)						{ return append(comp); }
+	CompactPath  operator /  (char const* comp)				const	{ return CompactPath(*this).append(comp); }
+	CompactPath& operator /= (std::string_view comp)				{ return append(comp); }
+	CompactPath& operator /= (CompactPath const& comp)				{ return append(comp.uni_view()); }
+	CompactPath  operator /  (std::string_view comp)		const	{ return CompactPath(*this).append(comp); }
+	CompactPath  operator /  (CompactPath const& comp)		const	{ return CompactPath(*this).append(comp.uni_view()); }
+	CompactPath& operator += (std::string_view src)					{ return concat(src); }
+	CompactPath  operator +  (std::string_view src)			const	{ return CompactPath(*this).concat(src); }
+
+	// see fs::path::components() and fs::path::normalize().
+	path_components		components	() const	{ return { uni_view() }; }
+	CompactPath&		normalize	();
+
+	std::string_view	filename	() const;
+	std::string_view	extension	() const;		// includes the leading '.'
+	std::string_view	stem		() const;
+	std::string_view	parent_path	() const;
+
+	bool is_absolute() const {
+		return m_length && m_data[0] == separator;
+	}
+
+	[[nodiscard]] std::string_view	uni_view	() const	{ return { m_data, m_length }; }
+	[[nodiscard]] char const*		uni_c_str	() const	{ return m_data; }
+	[[nodiscard]] std::string		uni_string	() const	{ return std::string(m_data, m_length); }
+	[[nodiscard]] fs::path			to_path		() const	{ return fs::path(m_data); }
+
+	// Returns the native path, converting into buf if needed. Returns nullptr if the converted path does
+	// not fit into the buffer.
+	[[nodiscard]] char const* native(NativePathBuffer& buf) const {
+#if FILESYSTEM_NEEDS_OS_PATH
+		if (ConvertToMsw(m_data, m_length, buf.data, sizeof(buf.data)) < 0) {
+			return nullptr;
+		}
+		return buf.data;
+#else
+		return m_data;
+#endif
+	}
+
+	// Returns the native path, caching the conversion in the object (see Usage Notes).
+	[[nodiscard]] char const* c_str() const;
+
+	// same hash as fs::path::hash(), computed on each call (not cached).
+	uint64_t hash() const { return PathHash(uni_view()); }
+
+	// case-insensitive, same as fs::path.
+	bool operator == (CompactPath const& rhs) const {
+		return m_length == rhs.m_length && strcasecmp(m_data, rhs.m_data) == 0;
+	}
+	bool operator <  (CompactPath const& rhs) const {
+		return strcasecmp(m_data, rhs.m_data) < 0;
+	}
+
+protected:
+	void	_reserve	(size_t length);
+	void	_assign_uni	(std::string_view uni);
+	bool	_aliases	(std::string_view src) const;
+	void	_invalidate_native() {
+#if FILESYSTEM_NEEDS_OS_PATH
+		m_native_valid = false;
+#endif
+	}
+};
+
+} // namespace fs
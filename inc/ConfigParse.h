@@ -8,6 +8,8 @@
 
 #include "fs.h"
 
+class BufferedReader;
+
 using ConfigParseAddFunc = std::function<void(const std::string&, const std::string&)>;
 
 struct ConfigParseContext {
@@ -15,8 +17,20 @@ struct ConfigParseContext {
 	int linenum;
 };
 
+// state carried from line to line within a file.
+struct ConfigParseState {
+	// current INI-style [section], which prefixes the lvalues of subsequent lines using dotted notation:
+	//    [cache]
+	//    --size = 30mib        ->  --cache.size = 30mib
+	// Each included file begins with no section.
+	std::string section;
+};
+
+// the overload without state parses the line on its own: a [section] header has no effect on later calls.
 extern bool ConfigParseLine(const char* readbuf, const ConfigParseAddFunc& push_item, ConfigParseContext const& ctx = {});
+extern bool ConfigParseLine(const char* readbuf, const ConfigParseAddFunc& push_item, ConfigParseContext const& ctx, ConfigParseState& state);
 extern bool ConfigParseFile(FILE* fp, const ConfigParseAddFunc& push_item, ConfigParseContext const& ctx = {});
+extern bool ConfigParseFile(BufferedReader& reader, const ConfigParseAddFunc& push_item, ConfigParseContext const& ctx = {});
 extern void ConfigParseArgs(int argc, const char* const argv[], const ConfigParseAddFunc& push_item);
 extern void ConfigParseArgs(int argc, const char* const argv[], char const* prefix, const ConfigParseAddFunc& push_item);
 
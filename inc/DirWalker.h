@@ -0,0 +1,74 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// Parallel recursive directory walker.
+//
+// Subdirectories are distributed across worker threads using per-thread work queues with stealing: each
+// worker processes its own queue depth-first and steals the oldest (shallowest) directories from other
+// workers when it runs dry. Listing is done via fs::DirEnumerator, so no stat calls are made except
+// where the filesystem does not report entry types, or when following symlinks.
+//
+// Filtering:
+//   - include and exclude are glob patterns (see StringUtil::globMatch) matched against the path relative
+//     to the root, eg. "textures/*.png".
+//   - a directory matching an exclude pattern is pruned along with its entire subtree.
+//   - directories which cannot contain matches for any include pattern, as determined by the literal
+//     prefix of each pattern (everything before the first wildcard), are pruned without being listed.
+//
+// Results are delivered either to a sink invoked concurrently from the worker threads, or collected and
+// returned in sorted order via WalkDirectorySorted().
+//
+// Usage Notes:
+//   - sinks are called concurrently. Use the threadIndex argument to address per-thread state without
+//     locking, see DirWalkThreadCount().
+//   - views passed to the sink are valid only for the duration of the call.
+//   - directories which cannot be opened (permissions, or removed during the walk) are skipped silently.
+
+#include "DirEnumerator.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+enum class SymlinkPolicy : uint8_t {
+	Ignore,			// symlinks are not reported
+	Report,			// symlinks are reported as DirEntryType::Symlink, and not descended into
+	Follow,			// symlinks are resolved and reported as their target type. Cycles are detected.
+};
+
+struct DirWalkOptions {
+	std::vector<std::string>	include;					// empty matches everything
+	std::vector<std::string>	exclude;
+	int							max_depth	= -1;			// entries directly under the root are depth 0. -1 for unlimited.
+	SymlinkPolicy				symlinks	= SymlinkPolicy::Report;
+	int							num_threads	= 0;			// 0 to use std::thread::hardware_concurrency()
+	bool						report_dirs	= false;		// report directories in addition to their contents
+};
+
+struct DirWalkEntry {
+	std::string_view	rel_path;		// relative to the root, NUL-terminated
+	std::string_view	name;			// last component of rel_path
+	DirEntryType		type;
+	int					depth;
+};
+
+struct DirWalkResult {
+	std::string			rel_path;
+	DirEntryType		type;
+};
+
+using DirWalkSink = std::function<void(int threadIndex, const DirWalkEntry& ent)>;
+
+// number of worker threads a walk with the given options will use, and thus the range of threadIndex.
+int			DirWalkThreadCount		(const DirWalkOptions& options);
+
+// Returns the number of entries reported, or -1 if the root could not be opened.
+intmax_t	WalkDirectoryParallel	(const fs::path& root, const DirWalkOptions& options, const DirWalkSink& sink);
+
+// Same as WalkDirectoryParallel, with results sorted by rel_path (bytewise) so that output does not
+// depend on thread scheduling. Returns an empty list if the root could not be opened.
+std::vector<DirWalkResult> WalkDirectorySorted(const fs::path& root, const DirWalkOptions& options);
+
+} // namespace fs
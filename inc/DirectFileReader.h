@@ -0,0 +1,74 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// DirectFileReader - reads files while bypassing the OS page cache (O_DIRECT).
+//
+// Intended for large one-shot reads (loading an archive, hashing a file, copying): read through the page
+// cache, such data evicts hot pages that other parts of the program rely upon, while gaining nothing
+// from being cached itself.
+//
+// O_DIRECT requires the buffer address, file offset and size of every read to be multiples of the device
+// block size. DirectFileReader accepts arbitrary reads: aligned portions go directly into the caller's
+// buffer, and unaligned heads and tails are staged through an internal aligned bounce buffer. Callers
+// wanting the fastest path should read into a DirectIOBuffer at aligned offsets.
+//
+// Usage Notes:
+//   - files smaller than direct_threshold are read through the page cache as usual, since direct reads
+//     cost a device round trip every time and only pay off for data larger than the cache can keep.
+//   - if the filesystem does not support direct I/O (tmpfs, some network and FUSE filesystems), reads
+//     fall back to regular buffered reads. is_direct() reports which mode is in effect.
+//   - on Mac, F_NOCACHE is used instead, which has no alignment requirements. Elsewhere reads are always
+//     buffered.
+//   - not thread safe, due to the shared bounce buffer. Use one reader per thread.
+
+#include "posix_file.h"
+#include "UniqueArray.h"
+
+#include <cstdint>
+
+// alignment satisfying the logical block size of all common devices (512 or 4096 bytes).
+static constexpr size_t kDirectIOAlignment = 4096;
+
+using DirectIOBuffer = UniqueArray<uint8_t, kDirectIOAlignment>;
+
+struct DirectFileReaderOptions {
+	size_t	direct_threshold	= 4 * 1024 * 1024;	// files smaller than this are read buffered
+	size_t	bounce_size			= 1024 * 1024;		// size of the bounce buffer for unaligned reads
+	bool	direct				= true;				// FALSE to always read buffered
+};
+
+class DirectFileReader
+{
+protected:
+	DirectFileReaderOptions		m_options;
+	DirectIOBuffer				m_bounce;
+	int			m_fd		= -1;
+	intmax_t	m_size		= 0;
+	bool		m_direct	= false;
+	int			m_error		= 0;		// errno of the last failed operation
+
+public:
+	DirectFileReader(const DirectFileReaderOptions& options = {});
+	~DirectFileReader();
+
+	DirectFileReader(const DirectFileReader&) = delete;
+	DirectFileReader& operator=(const DirectFileReader&) = delete;
+
+	bool		open		(const char* path);
+	void		close		();
+
+	bool		is_open		() const	{ return m_fd >= 0; }
+	bool		is_direct	() const	{ return m_direct; }
+	intmax_t	size		() const	{ return m_size; }		// file size at the time of opening
+	int			error		() const	{ return m_error; }
+	int			fd			() const	{ return m_fd; }
+
+	// reads up to size bytes at offset. Returns the number of bytes read (less than size only at the end
+	// of the file), or -1 on error.
+	intmax_t	read		(void* dest, size_t size, x_off_t offset);
+
+protected:
+	bool		_setDirect		(bool enable);
+	intmax_t	_pread			(void* dest, size_t size, x_off_t offset);
+	intmax_t	_readBounced	(uint8_t* dest, size_t size, x_off_t offset);
+};
@@ -1,8 +1,27 @@
 // Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
 #pragma once
 
+#include <string_view>
+#include <functional>
+
 extern bool DiscoverUnattendedSessionFromEnvironment();
 
+// Environment snapshot - an indexed copy of the process environment.
+//
+// getenv() is a linear scan of environ with a string compare per variable. The snapshot is built by a
+// single pass over environ on first use, after which lookups are a single hash probe. Intended for code
+// which probes many variables, or probes the same variables repeatedly.
+//
+// Usage Notes:
+//   - the snapshot does not observe setenv/putenv calls made after it was built. Call EnvironSnapshotRefresh
+//     to rebuild it. Refresh is not thread safe with respect to concurrent lookups.
+//   - returned values are NUL-terminated and remain valid until the next refresh.
+//   - on Windows, variable names are matched case-insensitively, same as getenv.
+extern void			EnvironSnapshotRefresh	();
+extern char const*	EnvironSnapshotGet		(std::string_view name);		// nullptr if not set, same as getenv
+extern bool			EnvironSnapshotLookup	(std::string_view name, std::string_view& outValue);
+extern void			EnvironSnapshotForEach	(std::function<void(std::string_view name, std::string_view value)> const& func);
+
 extern __selectany char const* const g_env_verbose_name;
 
 #if PLATFORM_MSW
@@ -0,0 +1,155 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// FileWatcher - reports changes to files as batches of CStatModInfo deltas, for hot-reloading.
+//
+// Files are registered individually (WatchFile) or as whole directory trees (WatchTree). The watcher
+// remembers the CStatModInfo of every file it covers, and when a file changes it delivers a FileChange
+// record holding both the previous and the current info, so that consumers can decide for themselves
+// whether a reload is needed (eg. size changed, or only the timestamp).
+//
+//     FileWatcher watcher([&](std::span<const FileChange> changes) {
+//         for (auto& change : changes) { ... reload change.path ... }
+//     });
+//     watcher.WatchTree("assets");
+//     watcher.WatchFile("settings.cfg");
+//
+// On Linux, changes are detected via inotify, so detection costs nothing while idle, and a change is
+// reported within milliseconds. Other platforms (or Linux, if inotify is unavailable) poll posix_stat for
+// every covered file at FileWatcherOptions::poll_interval. If inotify is available but a dir cannot be
+// watched (eg. the watch limit is exhausted), only the registrations covering that dir are polled, at the
+// same interval, until the watch can be established.
+//
+// Coalescing: editors and build tools typically produce bursts of events per save (truncate, several
+// writes, rename over the original). Events are gathered until the filesystem has been quiet for the
+// coalesce period (or max_delay has passed since the first event), then each affected file is stat'd once
+// and reported at most once per batch. Files which are created and removed within a batch, and changes
+// which leave CStatModInfo as it was, are not reported at all.
+//
+// Usage Notes:
+//   - the callback is invoked on the watcher's own thread, one batch at a time. Events arriving while the
+//     callback runs are queued (by the kernel, when using inotify) and delivered in the next batch.
+//   - watched files need not exist, nor need their dirs or the root of a watched tree: creation is reported
+//     as a change from non-existent.
+//   - when a watched dir is removed (or moved away), its files are reported as removed, and registrations
+//     depending on it remain in effect: its nearest existing ancestor is watched until the dir reappears,
+//     and the files within it are then reported as created.
+//   - files in a watched tree are reported as they are created, including files in new subdirectories.
+//     Only regular files are reported. Symlinks within a tree are not followed.
+//   - a file which is replaced via rename is reported as modified, since CStatModInfo includes the inode.
+//   - thread safe. Watch and Unwatch may be called from any thread, including the callback.
+
+#include "fs.h"
+#include "InotifyReader.h"
+#include "posix_file.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+enum class FileChangeKind : uint8_t {
+	Created,
+	Modified,
+	Removed,
+};
+
+struct FileChange {
+	fs::path		path;
+	FileChangeKind	kind;
+	CStatModInfo	old_info;		// zero if the file did not exist (Created)
+	CStatModInfo	new_info;		// zero if the file no longer exists (Removed)
+};
+
+struct FileWatcherOptions {
+	std::chrono::milliseconds	coalesce		= std::chrono::milliseconds(10);
+	std::chrono::milliseconds	max_delay		= std::chrono::milliseconds(100);	// bounds coalescing during continuous activity
+	std::chrono::milliseconds	poll_interval	= std::chrono::milliseconds(500);	// polling fallback only
+	bool						force_polling	= false;
+};
+
+class FileWatcher
+{
+public:
+	using WatchId	= int;
+	using Callback	= std::function<void(std::span<const FileChange> changes)>;
+
+	FileWatcher(Callback callback, const FileWatcherOptions& options = {});
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// returns an id for Unwatch. WatchTree returns -1 if dir exists but is not a directory.
+	WatchId		WatchFile		(const fs::path& path);
+	WatchId		WatchTree		(const fs::path& dir);
+
+	// stops watching. Watches are rebuilt from the remaining registrations, so this is slower than
+	// registering.
+	bool		Unwatch			(WatchId id);
+
+	// TRUE if changes are detected by polling rather than by notifications.
+	bool		IsPolling		() const	{ return m_polling; }
+
+	// number of files whose state is being tracked.
+	size_t		TrackedFiles	() const;
+
+protected:
+	struct Registration {
+		std::string		path;			// native, lexically normalized
+		bool			tree;
+		bool			armed	= false;	// the dir (tree root, or the file's parent) and all dirs within a tree are watched
+	};
+
+	struct FileState {
+		CStatModInfo	info;
+		bool			exists;
+	};
+
+	Callback						m_callback;
+	FileWatcherOptions				m_options;
+
+	mutable std::mutex				m_mutex;
+	std::unordered_map<WatchId, Registration>			m_registrations;
+	std::unordered_map<std::string, FileState>			m_files;		// native path -> last reported state
+	std::unordered_set<std::string>						m_explicit;		// paths registered via WatchFile
+	std::unordered_set<std::string>						m_pending;		// paths to re-stat in the next batch
+	WatchId							m_next_id	= 1;
+
+	// inotify: watch descriptor -> watched dir. tree_dirs are dirs within a watched tree, in which all
+	// entries are of interest, rather than only the entries in m_explicit. Ancestors watched on behalf of
+	// missing dirs remain watched until the next _rebuild.
+	std::unordered_map<int, std::string>	m_wd_dirs;
+	std::unordered_map<std::string, int>	m_dir_wds;
+	std::unordered_set<std::string>			m_tree_dirs;
+	std::unordered_set<std::string>			m_unwatchable;		// dirs whose watch failed, logged once
+
+	bool							m_polling		= false;
+	bool							m_stopping		= false;
+	InotifyReader					m_inotify;
+	std::condition_variable			m_cv;			// wakes the polling thread
+	std::thread						m_thread;
+
+	void		_track			(const std::string& path, bool report);
+	bool		_addTree		(const std::string& dir, bool report);
+	int			_addWatch		(const std::string& dir, bool tree);
+	bool		_arm			(Registration& reg, bool report);
+	bool		_rearm			(const std::string& dir);
+	bool		_dropWatches	(const std::string& dir, int ignoredWd);
+	bool		_hasUnarmed		() const;
+	void		_pollUnarmed	();
+	void		_rebuild		();
+	void		_wake			();
+	void		_collect		(std::vector<FileChange>& dest);
+	void		_rescan			();
+
+	void		_notifyThread	();
+	void		_pollThread		();
+	bool		_handleEvent	(int wd, uint32_t mask, const char* name);
+};
@@ -0,0 +1,110 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// FlatStringMap - open-addressing (linear probe) string->string hash table. Keys and values are stored
+// NUL-terminated in a single contiguous arena, and lookups are heterogeneous (std::string_view) so that
+// no temporary std::string is ever constructed just to perform a find().
+//
+// Intended for read-mostly lookup tables such as app settings and environment snapshots, where the node-
+// per-entry layout and strcmp-based tree walk of std::map show up in profiles.
+//
+// Lifetime rules:
+//   - views and entry pointers returned by find() are invalidated by any mutation of the map.
+//   - values are NUL-terminated, so value views may be passed directly to C APIs via data().
+//   - overwritten values and erased entries leave garbage in the arena. Garbage is reclaimed
+//     automatically by rehash, which is triggered when garbage exceeds the live data set.
+
+struct FlatStringMapSlot {
+	uint32_t	hash;
+	uint32_t	index;			// entry index + 1. 0 = empty slot, kFlatMapTombstone = erased.
+};
+
+struct FlatStringMapEntry {
+	uint32_t	hash;
+	uint32_t	key_offset;
+	uint32_t	key_length;
+	uint32_t	val_offset;
+	uint32_t	val_length;
+};
+
+static constexpr uint32_t kFlatMapTombstone = UINT32_MAX;
+static constexpr uint32_t kFlatMapNotFound  = UINT32_MAX;
+
+extern uint32_t FlatStringMapHash(std::string_view key);
+
+// Probes a slot table for the given key. Exposed as a free function so that serialized images of a
+// table (eg. shared memory segments) can be searched using the exact same rules as the live map.
+// Returns the index of the matching entry, or kFlatMapNotFound.
+extern uint32_t FlatStringMapProbe(
+	FlatStringMapSlot  const* slots, uint32_t slotMask,
+	FlatStringMapEntry const* entries, char const* arena,
+	std::string_view key, uint32_t hash
+);
+
+class FlatStringMap
+{
+public:
+	using Entry = FlatStringMapEntry;
+	using Slot  = FlatStringMapSlot;
+
+protected:
+	std::vector<Slot>	m_slots;			// power-of-two sized
+	std::vector<Entry>	m_entries;			// insertion order, erased entries have key_offset == kFlatMapTombstone
+	std::vector<char>	m_arena;
+
+	uint32_t			m_count			= 0;
+	uint32_t			m_tombstones	= 0;
+	uint32_t			m_garbage		= 0;	// unreferenced bytes in the arena
+
+public:
+	FlatStringMap() = default;
+
+	bool		empty	() const	{ return m_count == 0; }
+	size_t		size	() const	{ return m_count; }
+
+	void		clear	();
+	void		reserve	(size_t count);
+
+	Entry const*		find	(std::string_view key) const;
+	bool				contains(std::string_view key) const	{ return find(key) != nullptr; }
+	bool				lookup	(std::string_view key, std::string_view& outValue) const;
+
+	std::string_view	key_of	(Entry const& entry) const	{ return { m_arena.data() + entry.key_offset, entry.key_length }; }
+	std::string_view	value_of(Entry const& entry) const	{ return { m_arena.data() + entry.val_offset, entry.val_length }; }
+
+	// returns TRUE if the map was modified (new key or different value).
+	bool		set		(std::string_view key, std::string_view value);
+
+	// returns TRUE if the key existed.
+	bool		erase	(std::string_view key);
+
+	// func(std::string_view key, std::string_view value) -- visits entries in insertion order.
+	template<typename Func>
+	void forEach(Func&& func) const {
+		for (auto const& entry : m_entries) {
+			if (entry.key_offset == kFlatMapTombstone) continue;
+			func(key_of(entry), value_of(entry));
+		}
+	}
+
+	// raw access for serializers. Entries may contain erased items (key_offset == kFlatMapTombstone)
+	// unless compact() is called first.
+	Slot  const*	slots		() const	{ return m_slots.empty() ? nullptr : m_slots.data(); }
+	uint32_t		slot_mask	() const	{ return m_slots.empty() ? 0 : uint32_t(m_slots.size() - 1); }
+	Entry const*	entries		() const	{ return m_entries.data(); }
+	size_t			entry_count	() const	{ return m_entries.size(); }
+	char const*		arena		() const	{ return m_arena.data(); }
+	size_t			arena_size	() const	{ return m_arena.size(); }
+
+	// drops erased entries and stale values from the arena.
+	void		compact	();
+
+protected:
+	uint32_t	_append	(std::string_view str);
+	void		_rehash	(size_t slotCount);
+	void		_insert_slot(uint32_t hash, uint32_t entryIndex);
+};
@@ -0,0 +1,78 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// InotifyReader - the inotify descriptor, wake pipe and event loop shared by FileWatcher and
+// CachingFileSystem, along with the path helpers both use to map watched dirs and event names back to
+// native paths.
+//
+// The owning thread blocks in wait(), which returns once events are queued, another thread calls wake(),
+// or the timeout expires. Queued events are then consumed via readEvents():
+//
+//     InotifyReader reader;
+//     if (reader.open("MyWatcher")) {
+//         reader.addWatch(dir.c_str(), IN_CREATE | IN_DELETE);
+//         InotifyReady ready;
+//         while (reader.wait(-1, ready) && !ready.woken) {
+//             reader.readEvents([&](int wd, uint32_t mask, const char* name) { ... });
+//         }
+//     }
+//
+// Usage Notes:
+//   - Linux only. Elsewhere open() fails, and callers are expected to fall back on polling or on not
+//     caching at all.
+//   - wake() may be called from any thread. Everything else belongs to the thread running the loop, except
+//     addWatch/removeWatch, which the kernel serializes.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// native path of the directory containing the given (lexically normalized) path.
+extern std::string	native_parent_dir	(const std::string& path);
+
+// native path of an entry within dir. Entries of "." are named without a dir prefix, same as lexically
+// normalized relative paths, so that event paths match the keys they were registered under.
+extern std::string	native_child_path	(const std::string& dir, std::string_view name);
+
+struct InotifyReady {
+	bool	events;		// events are queued, see readEvents()
+	bool	woken;		// wake() was called
+};
+
+class InotifyReader
+{
+public:
+	// name is NULL for events which concern the watched dir itself.
+	using EventFunc = std::function<void(int wd, uint32_t mask, const char* name)>;
+
+protected:
+	const char*		m_owner			= "InotifyReader";		// for error messages
+	int				m_fd			= -1;
+	int				m_wake_pipe[2]	= { -1, -1 };
+
+public:
+	InotifyReader() = default;
+	~InotifyReader();
+
+	InotifyReader(const InotifyReader&) = delete;
+	InotifyReader& operator=(const InotifyReader&) = delete;
+
+	// owner names the caller in error messages. Returns FALSE (and logs why) if inotify is unavailable.
+	bool	open		(const char* owner);
+	void	close		();
+	bool	is_open		() const	{ return m_fd >= 0; }
+
+	// returns the watch descriptor, or -1 with errno set.
+	int		addWatch	(const char* dir, uint32_t mask);
+	void	removeWatch	(int wd);
+
+	void	wake		();
+
+	// waits up to timeoutMs (-1 for no timeout). Returns FALSE (and logs why) if waiting failed, in which
+	// case no further events can be received. A signal interrupting the wait is reported as a timeout.
+	bool	wait		(int timeoutMs, InotifyReady& ready);
+
+	// calls func for every queued event, without blocking. Returns the number of events.
+	size_t	readEvents	(const EventFunc& func);
+};
@@ -0,0 +1,266 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// fs::InputStream - sequential byte input with zero-copy access, for decoders and parsers.
+//
+// Every stream exposes a window of bytes which are directly addressable in memory. read(), peek() and
+// the typed read<T>() are inline and non-virtual while the request fits within the window, so the common
+// case costs a bounds check and a memcpy (or nothing at all, for peek). Only when the window is exhausted
+// does the stream make a virtual call to refill it.
+//
+// For memory-backed streams (MemoryStream, MappedStream, EmbeddedStream) the window is the entire data,
+// so they never refill: decoders read directly from mapped or embedded memory. FdStream reads a file
+// through an internal buffer, which serves as its window.
+//
+//     fs::MappedStream stream(path);
+//     Header hdr;
+//     if (stream.read(hdr)) {
+//         auto payload = stream.peek(hdr.size);      // zero-copy view into the mapping
+//         if (payload.size() == hdr.size) { ... }
+//         stream.consume(payload.size());
+//     }
+//
+// Templated code taking a concrete stream type (eg. `template<typename Stream> Decode(Stream& s)`) has no
+// indirection at all, since the concrete stream classes are final.
+//
+// Usage Notes:
+//   - spans returned by peek() are valid until the next call to any non-const method of the stream. For
+//     memory-backed streams they remain valid for the lifetime of the stream.
+//   - peek(n) may return fewer than n bytes only at the end of the stream.
+//   - not thread safe.
+
+#include "fs.h"
+#include "MappedFile.h"
+#include "posix_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+namespace fs {
+
+class InputStream
+{
+protected:
+	const uint8_t*	m_begin		= nullptr;		// window: [m_begin, m_end), with the read position at m_cur
+	const uint8_t*	m_cur		= nullptr;
+	const uint8_t*	m_end		= nullptr;
+	intmax_t		m_base_pos	= 0;			// stream position of m_begin
+
+public:
+	virtual ~InputStream() = default;
+
+	// total size of the stream in bytes, or -1 if not known (pipes).
+	virtual intmax_t	size		() const = 0;
+
+	intmax_t	tell		() const	{ return m_base_pos + (m_cur - m_begin); }
+	size_t		available	() const	{ return (size_t)(m_end - m_cur); }
+
+	// reads up to dest.size() bytes, returning the number read. Less than requested only at the end of
+	// the stream or on error.
+	size_t read(std::span<uint8_t> dest) {
+		if (expect_true(dest.size() <= available())) {
+			memcpy(dest.data(), m_cur, dest.size());
+			m_cur += dest.size();
+			return dest.size();
+		}
+		return _readSlow(dest);
+	}
+
+	// reads a trivially copyable object. Returns FALSE (and consumes what remained) if the stream ends
+	// first.
+	template<typename T>
+	bool read(T& dest) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		if (expect_true(sizeof(T) <= available())) {
+			memcpy(&dest, m_cur, sizeof(T));
+			m_cur += sizeof(T);
+			return true;
+		}
+		return _readSlow({ (uint8_t*)&dest, sizeof(T) }) == sizeof(T);
+	}
+
+	// returns a view of the next n bytes without consuming them.
+	std::span<const uint8_t> peek(size_t n) {
+		if (expect_true(n <= available())) {
+			return { m_cur, n };
+		}
+		auto avail = _underflow(n);
+		return { m_cur, std::min(n, avail) };
+	}
+
+	// consumes n bytes previously returned by peek(). n is clamped to available().
+	void consume(size_t n) {
+		m_cur += std::min(n, available());
+	}
+
+	// skips up to n bytes, returning the number skipped.
+	size_t skip(size_t n) {
+		if (expect_true(n <= available())) {
+			m_cur += n;
+			return n;
+		}
+		return _skipSlow(n);
+	}
+
+	bool seek(intmax_t pos) {
+		if (pos >= m_base_pos && pos <= m_base_pos + (m_end - m_begin)) {
+			m_cur = m_begin + (pos - m_base_pos);
+			return true;
+		}
+		return _seek(pos);
+	}
+
+	bool eof() {
+		return !available() && !_underflow(1);
+	}
+
+protected:
+	size_t		_readSlow		(std::span<uint8_t> dest);
+	size_t		_skipSlow		(size_t n);
+
+	// makes at least want bytes available in the window, if the stream holds that many. May move the
+	// window. Returns the number of bytes available.
+	virtual size_t	_underflow	(size_t want) = 0;
+
+	// reads into dest once the window has been exhausted. The default refills the window repeatedly.
+	virtual size_t	_readMore	(uint8_t* dest, size_t size);
+
+	// repositions outside of the current window.
+	virtual bool	_seek		(intmax_t pos) = 0;
+};
+
+// Reads from memory owned by someone else, which must outlive the stream.
+class MemoryStream : public InputStream
+{
+public:
+	MemoryStream() = default;
+	MemoryStream(const void* data, size_t size)		{ reset(data, size); }
+	MemoryStream(std::string_view data)				{ reset(data.data(), data.size()); }
+
+	void reset(const void* data, size_t size) {
+		m_begin		= (const uint8_t*)data;
+		m_cur		= m_begin;
+		m_end		= m_begin + size;
+		m_base_pos	= 0;
+	}
+
+	intmax_t size() const override	{ return m_end - m_begin; }
+
+	// the entire contents of the stream.
+	std::span<const uint8_t> data() const	{ return { m_begin, (size_t)(m_end - m_begin) }; }
+
+protected:
+	size_t	_underflow	(size_t) override		{ return available(); }
+	size_t	_readMore	(uint8_t*, size_t) override	{ return 0; }
+	bool	_seek		(intmax_t) override		{ return false; }
+};
+
+// Reads memory which is kept alive by a shared owner, eg. a buffer which may be replaced or removed from
+// its container while the stream is open.
+class SharedMemoryStream final : public MemoryStream
+{
+protected:
+	std::shared_ptr<const void>	m_owner;
+
+public:
+	SharedMemoryStream(std::shared_ptr<const void> owner, const void* data, size_t size)
+		: m_owner(std::move(owner))
+	{
+		reset(data, size);
+	}
+};
+
+// Reads a memory-mapped file. The stream holds a reference to the mapping.
+class MappedStream final : public MemoryStream
+{
+protected:
+	MappedFile	m_file;
+
+public:
+	MappedStream() = default;
+	MappedStream(const fs::path& path, MapAdvice advice = MapAdvice::Sequential)	{ open(path, advice); }
+	MappedStream(MappedFile file)													{ reset(std::move(file)); }
+
+	bool open(const fs::path& path, MapAdvice advice = MapAdvice::Sequential) {
+		MappedFile file;
+		file.open(path, { MapAccess::ReadOnly, advice });
+		reset(std::move(file));
+		return m_file.is_open();
+	}
+
+	void reset(MappedFile file) {
+		m_file = std::move(file);
+		MemoryStream::reset(m_file.data(), m_file.size());
+	}
+
+	bool				is_open	() const	{ return m_file.is_open(); }
+	const MappedFile&	file	() const	{ return m_file; }
+};
+
+// Reads binary data embedded in the executable, see EmbeddedBinaryData.h.
+//
+//     EmbeddedBinaryDataImport(foo_txt);
+//     fs::EmbeddedStream stream(EmbeddedBinaryDataSpan(foo_txt));
+//
+class EmbeddedStream final : public MemoryStream
+{
+public:
+	EmbeddedStream(std::span<const uint8_t> blob)		{ reset(blob.data(), blob.size()); }
+	EmbeddedStream(const void* start, const void* end)	{ reset(start, (const uint8_t*)end - (const uint8_t*)start); }
+
+#if PLATFORM_MSW
+	// loads an RCDATA resource by name. The stream is empty if the resource does not exist.
+	EmbeddedStream(const std::string& resourceName);
+#endif
+};
+
+// Reads an fd through an internal buffer, which grows as needed to satisfy peek().
+class FdStream final : public InputStream
+{
+public:
+	static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+protected:
+	std::unique_ptr<uint8_t[]>	m_buffer;
+	size_t		m_capacity;
+	intmax_t	m_file_pos	= 0;		// fd position corresponding to m_end
+	intmax_t	m_size		= -1;
+	int			m_fd		= -1;
+	int			m_error		= 0;
+	bool		m_owns_fd	= false;
+	bool		m_seekable	= false;	// FALSE for pipes and sockets, which are read with read() rather than pread()
+
+public:
+	FdStream(size_t bufferSize = kDefaultBufferSize);
+	FdStream(const fs::path& path, size_t bufferSize = kDefaultBufferSize);
+	~FdStream() override;
+
+	FdStream(const FdStream&) = delete;
+	FdStream& operator=(const FdStream&) = delete;
+
+	bool	open		(const fs::path& path);
+
+	// reads from the fd's current position. If takeOwnership, the fd is closed along with the stream.
+	void	attach		(int fd, bool takeOwnership = false);
+	void	close		();
+
+	bool	is_open		() const	{ return m_fd >= 0; }
+	int		error		() const	{ return m_error; }
+
+	intmax_t size() const override	{ return m_size; }
+
+protected:
+	intmax_t	_fdRead		(uint8_t* dest, size_t size);
+	size_t		_underflow	(size_t want) override;
+	size_t		_readMore	(uint8_t* dest, size_t size) override;
+	bool		_seek		(intmax_t pos) override;
+};
+
+} // namespace fs
+
+// Evaluates to a std::span over an embedded binary imported via EmbeddedBinaryDataImport(name).
+#define EmbeddedBinaryDataSpan(name) \
+	std::span<const uint8_t>((const uint8_t*)_binary_##name##_start, (const uint8_t*)_binary_##name##_end)
@@ -0,0 +1,108 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// MappedFile - memory-mapped file contents, served zero-copy from the OS page cache.
+//
+// Intended for large read-mostly files (assets, archives, config) which would otherwise be copied into
+// heap buffers. Pages are faulted in on first access, unless populate is requested.
+//
+//     MappedFile file;
+//     if (file.open(path, { MapAccess::ReadOnly, MapAdvice::Sequential })) {
+//         parse(file.view());
+//     }
+//
+// MappedFile is a reference-counted handle: copies and subviews share a single mapping, which is unmapped
+// when the last handle referring to it is released. Handles may be copied and released from any thread.
+//
+// Usage Notes:
+//   - an empty file maps successfully, with size() == 0 and data() == nullptr.
+//   - ReadWrite mappings are shared with the file: writes reach the file (see flush()). The file size is
+//     fixed at the time of mapping, so files which need to grow must be resized before mapping. CopyOnWrite
+//     mappings are writable, but changes are private to the process.
+//   - truncating a file while it is mapped elsewhere leaves pages beyond the new end inaccessible (SIGBUS
+//     on POSIX). Mapped files should be replaced via rename rather than rewritten in place.
+//   - the file handle is closed once the mapping is established; the mapping keeps the file alive.
+
+#include "fs.h"
+#include "posix_file.h"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+enum class MapAccess : uint8_t {
+	ReadOnly,
+	ReadWrite,
+	CopyOnWrite,
+};
+
+enum class MapAdvice : uint8_t {
+	Normal,
+	Sequential,		// aggressive readahead, pages may be dropped soon after access
+	Random,			// disables readahead
+	WillNeed,		// start reading the range into the page cache now
+	DontNeed,		// range won't be accessed soon, its pages may be reclaimed (discards CopyOnWrite changes)
+	HugePage,		// back the range with transparent huge pages where supported (Linux only)
+};
+
+struct MappedFileOptions {
+	MapAccess	access		= MapAccess::ReadOnly;
+	MapAdvice	advice		= MapAdvice::Normal;
+	bool		populate	= false;		// prefault the whole mapping (MAP_POPULATE), avoids faults on first access
+	x_off_t		offset		= 0;			// need not be page aligned
+	size_t		length		= 0;			// 0 to map through the end of the file
+};
+
+struct MappedRegion;
+
+class MappedFile
+{
+public:
+	static constexpr size_t npos = size_t(-1);
+
+protected:
+	std::shared_ptr<MappedRegion>	m_region;
+	uint8_t*	m_data		= nullptr;
+	size_t		m_size		= 0;
+	int			m_error		= 0;		// errno of the last failed open/map
+
+public:
+	MappedFile() = default;
+	MappedFile(const fs::path& path, const MappedFileOptions& options = {}) { open(path, options); }
+
+	bool		open		(const fs::path& path, const MappedFileOptions& options = {});
+	bool		open		(const char* path, const MappedFileOptions& options = {});
+
+	// maps a file which is already open. The fd is not taken over, and may be closed after mapping.
+	bool		map			(int fd, const MappedFileOptions& options = {});
+
+	// releases this handle's reference to the mapping.
+	void		close		();
+
+	bool		is_open		() const		{ return m_region != nullptr; }
+	explicit	operator bool() const		{ return is_open(); }
+	int			error		() const		{ return m_error; }
+
+	const uint8_t*		data		() const	{ return m_data; }
+	size_t				size		() const	{ return m_size; }
+	std::string_view	view		() const	{ return { (const char*)m_data, m_size }; }
+	bool				writable	() const;
+
+	// asserts that the mapping is writable (ReadWrite or CopyOnWrite).
+	uint8_t*	mutable_data() const;
+
+	// returns a handle to [offset, offset+length) of this view, sharing the same mapping. The range is
+	// clamped to the bounds of this view.
+	MappedFile	subview		(size_t offset, size_t length = npos) const;
+
+	// applies an access hint to [offset, offset+length) of this view. Hints are advisory: returns FALSE if
+	// the OS rejected the hint, which callers are generally free to ignore.
+	bool		advise		(MapAdvice advice, size_t offset = 0, size_t length = npos) const;
+
+	// writes modified pages of a ReadWrite mapping back to the file. If async, the writeback is only
+	// scheduled.
+	bool		flush		(bool async = false) const;
+
+	// number of handles (including subviews) sharing this mapping.
+	long		use_count	() const		{ return m_region.use_count(); }
+};
@@ -0,0 +1,148 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// MemoryFileSystem - in-memory FileSystemInterface for tests and benchmarks.
+//
+// Holds a tree of directories and files, and reports CStatInfo for them the way a host filesystem would:
+// regular/directory modes, sizes, timestamps (directory mtimes change as entries are added and removed),
+// and a device and inode number per node. Each operation can be configured with a latency and with
+// injected failures, and is counted, so that code built on FileSystemInterface can be measured against a
+// slow or unreliable device reproducibly, on any machine.
+//
+//     MemoryFileSystem memfs;
+//     memfs.AddSyntheticTree("/assets", 3, 4, 16, 1024);
+//     memfs.SetOpConfig(MemFsOp::Stat, { .latency = std::chrono::microseconds(80) });
+//
+//     CachingFileSystem cache(&memfs, CachingFileSystem::kDefaultMaxEntries, CacheInvalidation::Manual);
+//     ... run the workload against cache ...
+//     auto counters = memfs.GetCounters();       // how many stats reached the "device"
+//
+// Paths are universal paths, and are case-sensitive like the Linux host filesystem. A leading slash is
+// optional: "a/b" and "/a/b" name the same node. Directory listings are sorted by name, so that listing
+// order does not vary between runs.
+//
+// Failure injection: a failing operation behaves as if the file did not exist (Stat returns a
+// non-existent CStatInfo, Exists returns FALSE, listings are empty and Open returns nullptr), which is
+// all FileSystemInterface can express. Failures are decided by a deterministic sequence seeded via
+// SetSeed(), so a single-threaded workload fails the same calls on every run.
+//
+// Usage Notes:
+//   - thread safe. Latency is applied without holding any lock, so concurrent operations overlap the
+//     way requests to a real device do.
+//   - streams returned by Open() remain valid if the file is later replaced or removed.
+
+#include "filesysteminterface.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+enum class MemFsOp : uint8_t {
+	Stat,
+	Exists,
+	List,			// VisitDirectoryContents
+	Open,
+	Count
+};
+
+struct MemFsOpConfig {
+	std::chrono::nanoseconds	latency			= {};	// added to every call
+	std::chrono::nanoseconds	jitter			= {};	// extra latency, uniformly distributed in [0, jitter)
+
+	// busy-wait rather than sleep. Sleeps are accurate to tens of microseconds at best, so short
+	// latencies need spinning, at the cost of occupying a core (which real I/O does not).
+	bool						spin			= false;
+
+	double						failure_rate	= 0;	// probability that a call fails, 0 to 1
+	uint32_t					fail_every		= 0;	// fail every Nth call (deterministic), 0 to disable
+};
+
+struct MemFsOpCounters {
+	uint64_t	calls;
+	uint64_t	failures;
+	uint64_t	latency_ns;		// total latency injected
+};
+
+struct MemFsCounters {
+	MemFsOpCounters		ops[(int)MemFsOp::Count];
+
+	const MemFsOpCounters&	operator[](MemFsOp op) const	{ return ops[(int)op]; }
+};
+
+class MemoryFileSystem : public FileSystemInterface
+{
+public:
+	// called for every operation which was not failed by the op config. Returns TRUE to fail it. Called
+	// without any lock held, so it may call back into the filesystem (which invokes it again).
+	using FailurePredicate = std::function<bool(MemFsOp op, const fs::path& path)>;
+
+	MemoryFileSystem();
+	~MemoryFileSystem() override;
+
+	MemoryFileSystem(const MemoryFileSystem&) = delete;
+	MemoryFileSystem& operator=(const MemoryFileSystem&) = delete;
+
+	// creates or replaces a file, creating its parent directories as needed. Returns FALSE if the path or
+	// one of its parents is an existing node of the wrong type.
+	bool		WriteFile			(const fs::path& path, std::string data);
+	bool		CreateDirectories	(const fs::path& path);
+
+	// removes a file, or a directory along with its contents.
+	bool		Remove				(const fs::path& path);
+	void		Clear				();
+
+	// populates root with a tree of the given depth, where every directory holds dirsPerDir subdirectories
+	// ("d0", "d1", ...) and filesPerDir files ("f0.bin", ...) of fileSize bytes. Returns the number of files
+	// created.
+	size_t		AddSyntheticTree	(const fs::path& root, int depth, int dirsPerDir, int filesPerDir, size_t fileSize);
+
+	void		SetOpConfig			(MemFsOp op, const MemFsOpConfig& config);
+	void		SetAllOpConfigs		(const MemFsOpConfig& config);
+	void		SetFailurePredicate	(FailurePredicate predicate);
+	void		SetSeed				(uint64_t seed);
+
+	MemFsCounters	GetCounters		() const;
+	void			ResetCounters	();
+
+	CStatInfo	Stat					(const fs::path& path) override;
+	bool		Exists					(const fs::path& path) override;
+	void		VisitDirectoryContents	(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) override;
+	std::unique_ptr<fs::InputStream> Open(const fs::path& path) override;
+
+protected:
+	struct Node {
+		CStatInfo								stat;
+		std::shared_ptr<const std::string>		data;			// files only
+		std::map<std::string, std::unique_ptr<Node>, std::less<>>	children;		// directories only
+	};
+
+	struct OpState {
+		MemFsOpConfig				config;
+		std::atomic<uint64_t>		calls		= 0;
+		std::atomic<uint64_t>		failures	= 0;
+		std::atomic<uint64_t>		latency_ns	= 0;
+	};
+
+	mutable std::shared_mutex		m_mutex;
+	std::unique_ptr<Node>			m_root;
+	uint64_t						m_dev;
+	uint64_t						m_next_ino	= 1;
+
+	OpState							m_ops[(int)MemFsOp::Count];
+	std::shared_ptr<const FailurePredicate>	m_predicate;		// shared, so that _begin can call it without the lock
+	std::atomic<uint64_t>			m_seed;
+	std::atomic<uint64_t>			m_draws		= 0;		// position in the failure/jitter sequence
+
+	std::unique_ptr<Node>	_newNode	(uint32_t mode);
+	Node*		_find			(const fs::path& path) const;
+	Node*		_makeDirs		(const fs::path& path, bool includeLeaf);
+	bool		_begin			(MemFsOp op, const fs::path& path);
+	uint64_t	_draw			();
+	static void	_touch			(Node& node);
+};
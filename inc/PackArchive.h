@@ -0,0 +1,181 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// PackArchive - read-only archive of many small files, for loading without a syscall per file.
+//
+// A pack is a single file which is memory-mapped whole. Files are looked up by name in an index sorted by
+// name hash (binary search, no allocation), and their contents are returned as views directly into the
+// mapping. Compared to open/read/close per file, this removes three syscalls and a copy per file, and
+// lets the OS read ahead across files which are used together.
+//
+// Layout (all integers little-endian):
+//
+//     PackHeader                  64 bytes
+//     payloads                    each aligned to kPackAlignment, in the order added to the builder
+//     PackEntry[entry_count]      sorted by (name_hash, name)
+//     names                       NUL-terminated, referenced by PackEntry::name_offset
+//
+// Names are universal paths relative to the archive root ("textures/sky.png"), and are looked up
+// case-insensitively, same as fs::path. Each payload carries a CRC-32C checksum, which is verified on
+// request (see PackOpenOptions and verify()), since verifying on every access would defeat the purpose of
+// a zero-copy view. The index itself is always verified when the archive is opened.
+//
+// PackArchive implements FileSystemInterface, so a pack can be mounted into a VirtualFileSystem or used
+// anywhere a filesystem is expected. Directories are implied by the names in the archive.
+//
+//     auto pack = std::make_shared<PackArchive>();
+//     if (pack->open("data/assets.pack")) {
+//         vfs.Mount("rom:", pack);
+//     }
+//
+// Packs are created with PackBuilder, or with the packtool utility (`make packtool`).
+//
+// Usage Notes:
+//   - thread safe once open. open() and close() must not race with other methods.
+//   - views returned by view() and streams returned by Open() remain valid after close(), since they hold
+//     a reference to the mapping.
+
+#include "filesysteminterface.h"
+#include "MappedFile.h"
+#include "VirtualFileSystem.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+static constexpr char		kPackMagic[8]		= { 'I', 'C', 'Y', 'P', 'A', 'C', 'K', 0 };
+static constexpr uint32_t	kPackVersion		= 1;
+static constexpr size_t		kPackAlignment		= 64;			// payload alignment, a cache line
+
+struct PackHeader {
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	entry_count;
+	uint64_t	index_offset;		// PackEntry[entry_count]
+	uint64_t	names_offset;
+	uint64_t	names_size;
+	uint64_t	data_offset;		// first payload
+	uint64_t	file_size;			// detects truncated archives
+	uint32_t	index_checksum;		// PackChecksum of the index followed by the names
+	uint32_t	flags;
+};
+static_assert(sizeof(PackHeader) == 64);
+
+struct PackEntry {
+	uint64_t	name_hash;			// fs::PathHash of the name
+	uint64_t	offset;				// of the payload, from the start of the archive
+	uint64_t	size;
+	uint32_t	name_offset;		// within the names
+	uint16_t	name_length;		// excluding the NUL terminator
+	uint16_t	flags;
+	uint32_t	checksum;			// PackChecksum of the payload
+	uint32_t	reserved;
+};
+static_assert(sizeof(PackEntry) == 40);
+
+// CRC-32C (Castagnoli). Pass a previous result as seed to checksum data incrementally.
+uint32_t PackChecksum(const void* data, size_t size, uint32_t seed = 0);
+
+struct PackOpenOptions {
+	bool		verify_payloads	= false;	// verify all payload checksums on open, which reads the whole archive
+	bool		populate		= false;	// prefault the whole mapping, see MappedFileOptions
+};
+
+class PackArchive : public FileSystemInterface
+{
+protected:
+	MappedFile					m_file;
+	const PackHeader*			m_header	= nullptr;
+	std::span<const PackEntry>	m_entries;
+	const char*					m_names		= nullptr;
+	time_t						m_time		= 0;		// modification time of the archive, reported for all entries
+
+	// dir -> names of its entries, built on first use by the directory queries. Views point into the names
+	// table of the mapping. The root is "".
+	using NameSet = std::unordered_set<std::string_view, VfsKeyHash, VfsKeyEqual>;
+	std::unordered_map<std::string_view, NameSet, VfsKeyHash, VfsKeyEqual>	m_dirs;
+	std::mutex					m_dirs_mutex;
+	std::atomic<bool>			m_dirs_built	= false;
+
+public:
+	PackArchive() = default;
+	PackArchive(const fs::path& path, const PackOpenOptions& options = {})		{ open(path, options); }
+	~PackArchive() override = default;
+
+	PackArchive(const PackArchive&) = delete;
+	PackArchive& operator=(const PackArchive&) = delete;
+
+	// maps and validates the archive. Returns FALSE (and logs the reason) if the file cannot be mapped or
+	// is not a valid pack.
+	bool		open			(const fs::path& path, const PackOpenOptions& options = {});
+	void		close			();
+	bool		is_open			() const	{ return m_header != nullptr; }
+
+	std::span<const PackEntry>	entries		() const	{ return m_entries; }
+	const MappedFile&			file		() const	{ return m_file; }
+
+	// returns nullptr if the archive has no file with the given name.
+	const PackEntry*			find		(std::string_view name) const;
+	std::string_view			name		(const PackEntry& entry) const	{ return { m_names + entry.name_offset, entry.name_length }; }
+	std::span<const uint8_t>	view		(const PackEntry& entry) const	{ return { m_file.data() + entry.offset, (size_t)entry.size }; }
+
+	// returns TRUE if the payload matches its checksum.
+	bool		verify			(const PackEntry& entry) const;
+	bool		verify_all		() const;
+
+	CStatInfo	Stat					(const fs::path& path) override;
+	bool		Exists					(const fs::path& path) override;
+	void		VisitDirectoryContents	(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) override;
+
+	// returns a stream which reads the payload in place, and holds a reference to the mapping.
+	std::unique_ptr<fs::InputStream> Open(const fs::path& path) override;
+
+protected:
+	bool		_validate		(const fs::path& path);
+	void		_buildDirs		();
+};
+
+// Writes a pack archive. Files are added by name, either from the host filesystem or from memory, and
+// are only read when write() is called. Adding a name which has already been added replaces it.
+//
+//     PackBuilder builder;
+//     builder.addDirectory("build/assets");
+//     builder.addFile("version.txt", versionString);
+//     if (!builder.write("assets.pack")) { ... }
+//
+class PackBuilder
+{
+protected:
+	struct Source {
+		std::string		name;
+		fs::path		host_path;		// empty if the data is in memory
+		std::string		data;
+	};
+
+	std::vector<Source>		m_sources;
+	std::unordered_map<std::string, size_t, VfsKeyHash, VfsKeyEqual>	m_by_name;		// -> index within m_sources
+
+public:
+	// adds a file from the host filesystem, to be stored under the given name.
+	bool		addHostFile		(std::string_view name, const fs::path& hostPath);
+	bool		addFile			(std::string_view name, std::string data);
+
+	// adds all files beneath hostDir, named by their path relative to hostDir and prefixed with prefix (if
+	// not empty). Returns the number of files added, or -1 if the directory could not be read.
+	intmax_t	addDirectory	(const fs::path& hostDir, std::string_view prefix = {});
+
+	size_t		size			() const	{ return m_sources.size(); }
+
+	// writes the archive. Returns FALSE (and logs the reason) on failure, in which case the output file
+	// is removed.
+	bool		write			(const fs::path& path) const;
+
+protected:
+	Source*		_add			(std::string_view name);
+};
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <memory>
+#include <new>
 
 template<typename T>
 class _UniqueArray_const_iterator
@@ -197,22 +198,52 @@ public:
 	}
 };
 
+template<typename T, size_t Alignment>
+struct _UniqueArray_deleter {
+	void operator()(T* ptr) const {
+		if constexpr (Alignment == 0) {
+			delete[] ptr;
+		}
+		else {
+			::operator delete[](ptr, std::align_val_t(Alignment));
+		}
+	}
+};
+
 // A heap-allocated fixed-sized array of trivially default constructable objects. Uses unique_ptr
 // internally to manage the array allocation. Can also think of this as a fixed-size array for
 // situations where the size isn't known at compile time.
 //
 // Intended for use in place of std::vector, where the size is fixed and zero-fill initialization
 // isn't desirable (which is usually always the case for any fixed pre-sized array situation).
-template<typename T>
+//
+// A non-zero Alignment aligns the start of the array to that many bytes (a power of two), beyond what
+// alignof(T) would give. Required by O_DIRECT and other DMA-style I/O, see DirectIOBuffer.
+template<typename T, size_t Alignment = 0>
 struct UniqueArray {
-	std::unique_ptr<T[]> m_data;
+	static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two.");
+	static_assert(Alignment == 0 || Alignment >= alignof(T), "Alignment must be at least alignof(T).");
+
+	std::unique_ptr<T[], _UniqueArray_deleter<T, Alignment>> m_data;
 	size_t m_size;
 
-	UniqueArray(size_t size) : m_data(new T[size]) {
+	UniqueArray(size_t size) : m_data(_alloc(size)) {
 		static_assert(std::is_trivially_default_constructible<T>());
 		m_size = size;
 	}
 
+	static T* _alloc(size_t size) {
+		if constexpr (Alignment == 0) {
+			return new T[size];
+		}
+		else {
+			// raw storage: trivially constructible T needs no construction, and trivially destructible T
+			// (required below) needs no destruction, so no array cookie is involved.
+			static_assert(std::is_trivially_destructible<T>());
+			return (T*)::operator new[](size * sizeof(T), std::align_val_t(Alignment));
+		}
+	}
+
 	T* data() {
 		return m_data.get();
 	}
@@ -0,0 +1,167 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// VirtualFileSystem - a mount table which routes paths to FileSystemInterface backends.
+//
+// Mount points are path prefixes, either mount-style names (`rom:`, `assets:/textures`) or host-style
+// paths (`/opt/game/data`). A path is served by the mounts whose mount point is a prefix of it (compared
+// component-wise and case-insensitively, same as fs::path), with the remainder of the path passed to the
+// backend relative to the mount's backend root:
+//
+//     VirtualFileSystem vfs;
+//     vfs.MountHostDirectory("rom:", "/opt/game/data");
+//     vfs.Mount("rom:", hotAssets, {}, { .priority = 10 });        // overlays rom: with in-memory assets
+//     auto stream = vfs.Open("rom:/textures/sky.png");
+//
+// Overlay rules: mounts covering a path are consulted in order of priority (highest first), then by
+// depth of mount point (deepest first), then most recently mounted first. The first mount whose backend
+// has the file serves it. An exclusive mount stops the search even when it lacks the file, hiding the
+// mounts beneath it. Directory listings merge the contents of all consulted mounts.
+//
+// Paths not covered by any mount are passed unchanged to the fallback filesystem (StandardFileSystem by
+// default), so a VirtualFileSystem can be dropped in wherever a FileSystemInterface is used without
+// changing call sites.
+//
+// Lookup is indexed by the first component of the mount point (`rom:` or `/opt`), so resolution cost
+// does not grow with the number of unrelated mounts.
+//
+// Usage Notes:
+//   - thread safe. Backends are called while holding a shared lock on the mount table, so Mount and
+//     Unmount wait for in-progress queries, and backends must not call back into the VFS.
+//   - Open() returns whatever stream type the backend provides: memory-backed mounts (BlobFileSystem, pack
+//     archives) read in place, and host directories are memory-mapped.
+
+#include "filesysteminterface.h"
+
+#include <ctime>
+#include <memory>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// case-insensitive hash and equality for path components and keys, consistent with fs::path comparisons.
+struct VfsKeyHash {
+	using is_transparent = void;
+	size_t operator()(std::string_view key) const { return (size_t)fs::PathHash(key); }
+};
+
+struct VfsKeyEqual {
+	using is_transparent = void;
+	bool operator()(std::string_view a, std::string_view b) const;
+};
+
+using VfsNameSet = std::unordered_set<std::string, VfsKeyHash, VfsKeyEqual>;
+
+// normalizes a path for lookup within a backend which is keyed by relative names (BlobFileSystem,
+// PackArchive): leading slashes are removed and the path is lexically normalized. The root is "".
+std::string VfsRelativeKey(std::string_view path);
+
+struct VfsMountOptions {
+	int		priority	= 0;
+	bool	exclusive	= false;	// paths under this mount are never passed on to lower mounts
+};
+
+class VirtualFileSystem : public FileSystemInterface
+{
+public:
+	using MountId = int;
+
+	VirtualFileSystem();
+	~VirtualFileSystem() override;
+
+	VirtualFileSystem(const VirtualFileSystem&) = delete;
+	VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+
+	// mounts backend at mountPoint. Paths beneath the mount point are passed to the backend as
+	// backendRoot/remainder, or as the bare remainder if backendRoot is empty. Returns an id for Unmount,
+	// or -1 if the mount point is empty.
+	MountId		Mount				(std::string_view mountPoint, std::shared_ptr<FileSystemInterface> backend, const fs::path& backendRoot = {}, const VfsMountOptions& options = {});
+
+	// as above, but the backend is not owned and must outlive the mount.
+	MountId		Mount				(std::string_view mountPoint, FileSystemInterface& backend, const fs::path& backendRoot = {}, const VfsMountOptions& options = {});
+
+	MountId		MountHostDirectory	(std::string_view mountPoint, const fs::path& hostDir, const VfsMountOptions& options = {});
+	bool		Unmount				(MountId id);
+
+	// sets the filesystem for paths which are not covered by any mount. nullptr makes such paths
+	// nonexistent.
+	void		SetFallback			(std::shared_ptr<FileSystemInterface> fallback);
+
+	CStatInfo	Stat					(const fs::path& path) override;
+	bool		Exists					(const fs::path& path) override;
+	void		VisitDirectoryContents	(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) override;
+	std::unique_ptr<fs::InputStream> Open(const fs::path& path) override;
+
+	// finds the backend and backend path which would serve path. Returns FALSE if no backend has it.
+	bool		Resolve				(const fs::path& path, std::shared_ptr<FileSystemInterface>& backend, fs::path& backendPath);
+
+protected:
+	struct MountEntry {
+		MountId						id;
+		std::string					key;			// index key: first component of the mount point, or '/' and the first component if rooted
+		std::vector<std::string>	prefix;			// remaining components of the mount point
+		std::shared_ptr<FileSystemInterface>	backend;
+		fs::path					backend_root;
+		VfsMountOptions				options;
+	};
+
+	// candidate mounts for a path, in the order they are consulted.
+	struct Candidate {
+		const MountEntry*	mount;
+		fs::path			backend_path;
+	};
+
+	mutable std::shared_mutex		m_mutex;
+	std::unordered_map<std::string, std::vector<std::unique_ptr<MountEntry>>, VfsKeyHash, VfsKeyEqual>	m_mounts;
+	std::shared_ptr<FileSystemInterface>	m_fallback;
+	MountId							m_next_id = 1;
+
+	// collects the mounts covering path, in the order they are consulted. Returns FALSE if no mount covers
+	// the path, in which case the fallback applies. If mountDirs is given, it receives the next component
+	// of any mount points beneath the path, which exist as (virtual) directories even if no backend has them.
+	bool		_candidates		(const fs::path& path, std::vector<Candidate>& dest, VfsNameSet* mountDirs = nullptr) const;
+};
+
+// Read-only FileSystemInterface over in-memory blobs, for serving hot assets and data embedded in the
+// executable. Directories are implied by the paths of the files added. Paths are relative to the
+// filesystem root, eg. "textures/sky.png" (a leading slash is ignored).
+//
+//     EmbeddedBinaryDataImport(sky_png);
+//     auto blobs = std::make_shared<BlobFileSystem>();
+//     blobs->AddFile("textures/sky.png", EmbeddedBinaryDataSpan(sky_png));
+//     vfs.Mount("rom:", blobs, {}, { .priority = 10 });
+//
+class BlobFileSystem : public FileSystemInterface
+{
+public:
+	// borrows data, which must outlive the filesystem (eg. embedded data).
+	void		AddFile			(std::string_view path, std::span<const uint8_t> data);
+
+	// takes ownership of data. Streams opened on the file keep it alive, even if it is later replaced or
+	// removed.
+	void		AddFile			(std::string_view path, std::string data);
+
+	bool		RemoveFile		(std::string_view path);
+
+	CStatInfo	Stat					(const fs::path& path) override;
+	bool		Exists					(const fs::path& path) override;
+	void		VisitDirectoryContents	(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) override;
+	std::unique_ptr<fs::InputStream> Open(const fs::path& path) override;
+
+protected:
+	struct Blob {
+		std::span<const uint8_t>			data;
+		std::shared_ptr<const std::string>	owned;
+	};
+
+	mutable std::shared_mutex		m_mutex;
+	std::unordered_map<std::string, Blob, VfsKeyHash, VfsKeyEqual>			m_files;
+	std::unordered_map<std::string, VfsNameSet, VfsKeyHash, VfsKeyEqual>	m_dirs;		// dir -> names of its entries, "" is the root
+	time_t							m_created = time(nullptr);
+
+	void				_addFile	(std::string_view path, Blob&& blob);
+};
@@ -0,0 +1,140 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+#include "filesysteminterface.h"
+#include "InotifyReader.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * FileSystemInterface which memoizes Stat, Exists and VisitDirectoryContents results of another
+ * FileSystemInterface (StandardFileSystem by default).
+ *
+ * Cached results are invalidated via inotify: stat results are covered by a watch on the parent
+ * directory, and directory listings (and directory stats) by a watch on the directory itself. Watches are reference counted
+ * by the cache entries that depend on them, and removed when the last such entry is evicted. Events
+ * are consumed on a background thread, so queries that hit the cache make no syscalls.
+ *
+ * The cache holds at most maxEntries paths, evicting least-recently-used entries beyond that.
+ *
+ * Usage Notes:
+ *   - paths are lexically normalized before lookup, so different spellings of the same path share an
+ *     entry. Relative paths are keyed as given, so the cache must not outlive a change of working dir.
+ *   - keys are case-sensitive, unlike fs::path comparisons, since the host filesystem may be.
+ *   - results whose directory cannot be watched (inotify watch limit, missing parent directory, or
+ *     platforms without inotify) are not cached, and are always forwarded to the backing filesystem.
+ *   - backing filesystems which inotify cannot observe (eg. MemoryFileSystem) can be cached with
+ *     CacheInvalidation::Manual, in which case results are kept until Invalidate() or InvalidateAll().
+ *   - invalidation is asynchronous: a change made by another process becomes visible once its inotify
+ *     event has been processed, typically within microseconds.
+ *   - thread safe.
+ */
+enum class CacheInvalidation : uint8_t {
+	Inotify,		// results are invalidated by change notifications from the host filesystem
+	Manual,			// results are invalidated only by Invalidate() and InvalidateAll()
+};
+
+class CachingFileSystem : public FileSystemInterface {
+public:
+	static constexpr size_t kDefaultMaxEntries = 16384;
+
+	struct CacheStats {
+		uint64_t	hits;
+		uint64_t	misses;
+		uint64_t	invalidations;
+		uint64_t	evictions;
+		size_t		entries;
+		size_t		watches;
+	};
+
+	// backing may be nullptr, in which case a StandardFileSystem is used. A non-null backing filesystem
+	// is not owned, and must outlive the cache.
+	CachingFileSystem(FileSystemInterface* backing = nullptr, size_t maxEntries = kDefaultMaxEntries, CacheInvalidation invalidation = CacheInvalidation::Inotify);
+	~CachingFileSystem();
+
+	CachingFileSystem(const CachingFileSystem&) = delete;
+	CachingFileSystem& operator=(const CachingFileSystem&) = delete;
+
+	CStatInfo Stat(const fs::path& path) override;
+	bool Exists(const fs::path& path) override;
+	void VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) override;
+
+	// not cached: forwarded to the backing filesystem. File contents are already cached by the OS.
+	std::unique_ptr<fs::InputStream> Open(const fs::path& path) override;
+
+	void		Invalidate		(const fs::path& path);
+	void		InvalidateAll	();
+	CacheStats	GetCacheStats	() const;
+
+	// TRUE if results are being cached: with CacheInvalidation::Inotify, only if change notifications
+	// are available.
+	bool		IsCaching		() const	{ return m_caching; }
+
+protected:
+	struct KeyHash {
+		size_t operator()(const std::string& key) const { return (size_t)fs::PathHash(key); }
+	};
+
+	struct Entry {
+		std::list<std::string>::iterator	lru;
+		int						stat_wd		= -1;	// watch on the parent dir, covers stat/exists
+		int						list_wd		= -1;	// watch on the dir itself, covers the listing and dir stat
+		bool					has_stat	= false;
+		bool					has_exists	= false;
+		bool					has_listing	= false;
+		bool					exists		= false;
+		CStatInfo				stat		= {};
+		std::vector<fs::path>	listing;
+	};
+
+	struct Watch {
+		std::vector<std::string>	dirs;		// native paths, more than one if reached via symlinks
+		int							refs = 0;
+		uint64_t					generation = 0;		// m_generation as of the watch's creation or latest event
+	};
+
+	std::unique_ptr<FileSystemInterface>	m_owned_backing;
+	FileSystemInterface*					m_backing;
+	size_t									m_max_entries;
+
+	mutable std::mutex								m_mutex;
+	std::unordered_map<std::string, Entry, KeyHash>	m_entries;
+	std::list<std::string>							m_lru;			// most recently used at the front
+	std::unordered_map<int, Watch>					m_watches;		// by watch descriptor
+	std::unordered_map<std::string, int, KeyHash>	m_watch_dirs;	// dir -> watch descriptor
+	uint64_t										m_generation = 0;	// incremented by every invalidation
+	uint64_t										m_reset_generation = 0;	// m_generation as of the latest Invalidate/InvalidateAll
+
+	uint64_t		m_hits			= 0;
+	uint64_t		m_misses		= 0;
+	uint64_t		m_invalidations	= 0;
+	uint64_t		m_evictions		= 0;
+
+	std::atomic<bool>	m_caching	= false;		// cleared by the event thread if it fails
+	bool			m_manual		= false;		// CacheInvalidation::Manual
+	InotifyReader	m_inotify;
+	std::thread		m_event_thread;
+
+	std::string		_makeKey		(const fs::path& path) const;
+	Entry*			_touch			(const std::string& key);
+	Entry&			_emplace		(const std::string& key);
+	int				_acquireWatch	(const std::string& dir);
+	void			_releaseWatch	(int wd);
+	bool			_watchUnchanged	(int wd, uint64_t generation) const;
+	void			_erase			(const std::string& key);
+	void			_eraseByWatch	(int wd);
+	void			_eraseAll		();
+	void			_evictExcess	();
+	void			_eventThread	();
+	void			_handleEvent	(int wd, uint32_t mask, const char* name);
+
+	template<typename T, typename WatchSelfFunc, typename ReadFunc, typename FetchFunc, typename StoreFunc>
+	T				_cachedQuery	(const fs::path& path, bool watchParent, WatchSelfFunc&& watchSelf, ReadFunc&& read, FetchFunc&& fetch, StoreFunc&& store);
+};
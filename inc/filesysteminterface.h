@@ -3,15 +3,23 @@
 
 #include "fs.h"
 #include "posix_file.h"
+#include "InputStream.h"
 
 #include <functional>
+#include <memory>
 
 /**
  * Interface for interfacing with the file system abstractly.
  */
 class FileSystemInterface {
 public:
+	virtual ~FileSystemInterface() = default;
+
 	virtual CStatInfo Stat(const fs::path& path) = 0;
 	virtual bool Exists(const fs::path& path) = 0;
 	virtual void VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) = 0;
+
+	// opens a file for reading. Returns nullptr if the file does not exist, or if the filesystem does
+	// not support reading file contents. Memory-backed filesystems return streams which read in place.
+	virtual std::unique_ptr<fs::InputStream> Open(const fs::path& path) { return nullptr; }
 };
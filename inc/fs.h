@@ -4,6 +4,8 @@
 #include <vector>
 #include <functional>
 #include <string>
+#include <string_view>
+#include <algorithm>
 
 #include "StringUtil.h"
 
@@ -39,6 +41,8 @@
 
 namespace fs {
 
+// Deprecated: every read and seek is an indirect call through std::function. Use fs::InputStream (see
+// InputStream.h), which reads from memory-backed sources with no indirection.
 struct ReadSeekInterface {
 	std::function<intmax_t(void* dest, intmax_t size)>    read;
 	std::function<intmax_t(intmax_t pos, uint8_t whence)> seek;
@@ -55,6 +59,7 @@ std::string ConvertToMswMixed	(const std::string& unix_path, int maxMountLength)
 std::string ConvertToMsw		(const std::string& unix_path);
 std::string ConvertToMswNative	(const std::string& unix_path);
 std::string ConvertToMswMixed	(const std::string& unix_path);
+intptr_t	ConvertToMsw		(const char* unix_path, size_t length, char* dest, size_t destSize);	// returns -1 if dest is too small
 std::string PathFromString		(const char* path, int maxMountLength=FILESYSTEM_MOUNT_NAME_LENGTH);
 
 bool		exists				(const path& path);
@@ -77,6 +82,90 @@ std::vector<path>	recursive_directory_iterator(const path& path);
 inline std::string PathFromString		(const char8_t* path) { return PathFromString((char*)path); }
 #endif
 
+// Iterates the components of a universal path as views, without allocating. A leading slash is reported
+// as its own component ("/"), same as path::split_path(). Duplicate separators are skipped.
+class path_component_iterator
+{
+protected:
+	std::string_view	m_path;
+	size_t				m_pos;
+	std::string_view	m_current;
+
+	void _advance() {
+		if (m_pos == 0 && !m_path.empty() && m_path[0] == '/') {
+			m_current = m_path.substr(0, 1);
+			m_pos = 1;
+			return;
+		}
+		auto start = m_path.find_first_not_of('/', m_pos);
+		if (start == m_path.npos) {
+			m_pos = m_path.npos;
+			m_current = {};
+			return;
+		}
+		auto end = std::min(m_path.find('/', start), m_path.size());
+		m_current = m_path.substr(start, end - start);
+		m_pos = end;
+	}
+
+public:
+	using value_type		= std::string_view;
+	using difference_type	= ptrdiff_t;
+
+	path_component_iterator() {
+		m_pos = std::string_view::npos;
+	}
+
+	path_component_iterator(std::string_view uni_path) {
+		m_path	= uni_path;
+		m_pos	= 0;
+		_advance();
+	}
+
+	std::string_view	operator*	() const	{ return m_current; }
+	std::string_view const* operator->() const	{ return &m_current; }
+
+	path_component_iterator& operator++() {
+		_advance();
+		return *this;
+	}
+
+	bool operator==(path_component_iterator const& rhs) const { return m_pos == rhs.m_pos; }
+	bool operator!=(path_component_iterator const& rhs) const { return m_pos != rhs.m_pos; }
+};
+
+struct path_components {
+	std::string_view uni_path;
+
+	path_component_iterator begin() const	{ return path_component_iterator(uni_path); }
+	path_component_iterator end  () const	{ return {}; }
+};
+
+// Lexically normalizes a universal path in-place: collapses duplicate separators, removes '.' components,
+// and resolves '..' against the preceding component. Does not touch the filesystem, so symlinks are not
+// considered. A leading '//' (network path) and a leading mount name ('rom:') are roots, which '..' never
+// pops. Backslashes are treated as separators on
+// platforms where they cannot be part of a filename (Windows). An empty result is returned as '.'.
+// Returns the new length. The buffer is not NUL-terminated by this function.
+size_t		LexicallyNormalize	(char* uni_path, size_t length);
+
+// Case-folded 64-bit FNV-1a hash of a universal path, consistent with the case-insensitive comparison
+// operators of fs::path (ASCII folding, same as strcasecmp in the C locale). Pass a previous result as
+// seed to hash a path incrementally, eg. hash(a + b) == PathHash(b, PathHash(a)).
+static constexpr uint64_t kPathHashSeed = 0xcbf29ce484222325ull;
+
+inline uint64_t PathHash(std::string_view uni_path, uint64_t seed = kPathHashSeed) {
+	uint64_t hash = seed;
+	for (char ch : uni_path) {
+		uint8_t c = (uint8_t)ch;
+		if (c >= 'A' && c <= 'Z') {
+			c |= 0x20;
+		}
+		hash = (hash ^ c) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
 extern std::string s_app0_dir;		// prepended to all relative paths when they are converted to libc-consumable strings.
 extern void setAppRoot(std::string src);
 
@@ -87,6 +176,7 @@ protected:
 #if FILESYSTEM_NEEDS_OS_PATH
 	std::string		libc_path_;			// native path expected by libc and such
 #endif
+	uint64_t		hash_ = kPathHashSeed;	// PathHash(uni_path_), maintained alongside libc_path_
 
 	static const uint8_t separator = '/';
 
@@ -158,8 +248,12 @@ public:
 #if PLATFORM_SCE || PLATFORM_MSW
 		libc_path_.clear();
 #endif
+		hash_ = kPathHashSeed;
 	}
 
+	// case-folded hash of the universal path, see PathHash. Paths which compare equal have equal hashes.
+	uint64_t hash() const { return hash_; }
+
 	path& append(const std::string& comp);
 	path& concat(const std::string& src);
 
@@ -202,43 +296,59 @@ public:
 		return *this;
 	}
 
+	// view variants of filename(), extension() and parent_path(), which avoid constructing strings.
+	// Views are invalidated by any mutation of the path.
+	std::string_view filename_view() const {
+		std::string_view view = uni_path_;
+		auto pos = view.find_last_of(separator);
+		return (pos == view.npos) ? view : view.substr(pos + 1);
+	}
+
+	std::string_view extension_view() const {
+		auto fn = filename_view();
+		if (fn.find_first_not_of('.') == fn.npos) {
+			return {};
+		}
+		auto pos = fn.find_last_of('.');
+		return (pos == fn.npos) ? std::string_view{} : fn.substr(pos);
+	}
+
+	std::string_view parent_path_view() const {
+		std::string_view view = uni_path_;
+		auto pos = view.find_last_of(separator);
+		return (pos == view.npos) ? view : view.substr(0, pos);
+	}
+
+	// iterates the path components as views, see path_component_iterator.
+	path_components components() const {
+		return { uni_path_ };
+	}
+
 	/**
 	 * Returns a list of the path components.
+	 * Prefer components(), which does not allocate.
 	 */
 	std::vector<std::string> split_path() const {
-		if (uni_path_.empty()) {
-			return {};
-		}
-
 		std::vector<std::string> result;
-		size_t index = 0;
-
-		// Absolute path
-		if (uni_path_[0] == '/') {
-			result.push_back("/");
-			index++;
+		for (auto comp : components()) {
+			result.emplace_back(comp);
 		}
+		return result;
+	}
 
-		char delims[2] = { (char)separator, 0 };
-
-		for (;;) {
-			if (auto pos = uni_path_.find(separator, index); pos != std::string::npos) {
-				std::string token = StringUtil::trim(uni_path_.substr(index, pos-index), delims);
-				if (!token.empty()) {
-					result.emplace_back(std::move(token));
-				}
-				index = pos + 1;
-			}
-			else {
-				auto token = StringUtil::trim(uni_path_.substr(index));
-				if (!token.empty()) {
-					result.emplace_back(std::move(token));
-				}
-				break;
-			}
-		}
+	// Lexically normalized copy of this path, see LexicallyNormalize. Prefer normalized paths for
+	// use as cache keys, so that different spellings of the same path produce the same key.
+	path lexically_normal() const {
+		return path(*this).normalize();
+	}
 
-		return result;
+	// in-place variant of lexically_normal().
+	path& normalize() {
+		if (!uni_path_.empty()) {
+			uni_path_.resize(LexicallyNormalize(uni_path_.data(), uni_path_.size()));
+			update_native_path();
+		}
+		return *this;
 	}
 
 
@@ -325,4 +435,20 @@ protected:
 	void update_native_path();
 };
 
+// hash and equality functors for unordered containers keyed by path, eg.
+//   std::unordered_map<fs::path, T, fs::path_hash, fs::path_equal>
+// std::hash<fs::path> is also provided, and is equivalent to path_hash.
+struct path_hash {
+	size_t operator()(const path& p) const { return (size_t)p.hash(); }
+};
+
+struct path_equal {
+	bool operator()(const path& a, const path& b) const { return a == b; }
+};
+
 } // namespace fs
+
+template<>
+struct std::hash<fs::path> {
+	size_t operator()(const fs::path& p) const { return (size_t)p.hash(); }
+};
@@ -9,11 +9,17 @@
 #include "StdStringEmpty.h"
 #include "StringTokenizer.h"
 
+#include <atomic>
 #include <string>
 #include <optional>
 #include <algorithm>
 #include <limits>
 #include <vector>
+#include <unordered_map>
+
+namespace fs {
+	class path;
+}
 
 // helper for C++17's compound (assignment;conditional) style if() statements. Always returns TRUE. Example:
 //   if (auto path = appGetSetting("--assets-dir"); TakeStringOrDefault(path, "assets")) { }
@@ -65,9 +71,54 @@ namespace icyAppSettingsIfc
 {
 	// Caller is responsible for thread locking.
 
+	// Incremented every time the contents of the settings store change. Typed lookups (appGetSettingOpt,
+	// appEmplaceSetting, appGetSettingBool) cache their converted results per-thread and only re-parse
+	// the setting string when this value has changed since the result was cached.
+	extern std::atomic<uint64_t> g_generation;
+
+	inline uint64_t		appGetSettingsGeneration() { return g_generation.load(std::memory_order_acquire); }
+
+	// Settings are stored in layers, listed here from lowest to highest precedence. Lookups never probe
+	// the layers: they read a merged view which is updated incrementally whenever a layer changes.
+	// appSetSetting writes the Runtime layer, which overrides all others. appRemoveSetting removes the key
+	// from every layer, so that the setting no longer exists (use appRemoveSettingLayer to remove only an
+	// override, and reveal the value beneath it).
+	enum class SettingsLayer : uint8_t {
+		Defaults,
+		ConfigFile,
+		Environment,
+		CommandLine,
+		Runtime,
+	};
+
+	static constexpr int kNumSettingsLayers = int(SettingsLayer::Runtime) + 1;
+
+	extern char const*	SettingsLayerName		(SettingsLayer layer);
+
+	extern void			appSetSettingLayer		(SettingsLayer layer, std::string_view lvalue, std::string_view rvalue);
+	extern void			appRemoveSettingLayer	(SettingsLayer layer, std::string_view lvalue);
+	extern void			appClearSettingsLayer	(SettingsLayer layer);
+
+	// returns the layer which provides the effective value of the setting, or nullopt if the setting
+	// doesn't exist. Intended for diagnostics, as it probes each layer in turn.
+	extern std::optional<SettingsLayer> appGetSettingProvenance(std::string_view name);
+
+	// Imports environment variables beginning with prefix into the Environment layer, using the environment
+	// snapshot (see EnvironUtil.h). Names are mapped to switches by dropping the prefix, lowercasing,
+	// and converting '__' to '.' and '_' to '-':   APP_FOO_BAR=1 -> --foo-bar=1,  APP_CACHE__SIZE=1 -> --cache.size=1
+	// Returns the number of variables imported.
+	extern int			appImportSettingsFromEnvironment(std::string_view prefix);
+
+	// Parses a config file (see ConfigParse.h) into the ConfigFile layer, and command line arguments into the
+	// CommandLine layer. Positional arguments (those after '--') are ignored. Returns FALSE if the file could not be opened or
+	// has errors (items parsed before the error are kept).
+	extern bool			appLoadSettingsFile			(const fs::path& path);
+	extern void			appLoadSettingsArgs			(int argc, const char* const argv[]);
+
 	extern void			appSetSetting			(const std::string& lvalue, std::string rvalue);
 	extern void			appRemoveSetting		(const std::string& lvalue);
 	extern std::string  appGetSetting			(StdStringTempArg name);
+	extern std::string_view appGetSettingView	(StdStringTempArg name);		// view is valid until the next appSetSetting/appRemoveSetting
 	extern std::string  appGetSettingLwr		(StdStringTempArg name);
 	extern bool			appGetSetting			(const std::string& name, std::string& value);
 	extern bool			appHasSetting			(const std::string& name);
@@ -81,37 +132,82 @@ namespace icyAppSettingsIfc
 	template<typename T>
 	StdOptionString<T> ConvertFromString(std::string const& rval);
 
+	namespace _template_impl {
+		template<typename T>
+		struct TypedSettingCacheEntry {
+			uint64_t			generation;
+			StdOptionString<T>	value;
+		};
+
+		struct TypedSettingCacheHash {
+			using is_transparent = void;
+			size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+		};
+
+		extern std::string_view SettingNameView(StdStringTempArg name);
+
+		// Returns the cached result of fetch() for the given setting, re-running fetch() only if the settings
+		// generation has changed since the last time it was run. The cache is thread-local so that typed reads
+		// do not add any write-sharing beyond what the caller already does when reading the settings store.
+		// Tag allows callers with differing conversion rules for the same T to keep separate caches.
+		// The cache is bounded, so that callers which build setting names dynamically cannot grow it forever.
+		static constexpr size_t kTypedSettingCacheMax = 256;
+
+		template<typename T, typename Tag=T, typename Fetch>
+		StdOptionString<T> const& CachedSettingLookup(StdStringTempArg name, Fetch&& fetch) {
+			static thread_local std::unordered_map<std::string, TypedSettingCacheEntry<T>, TypedSettingCacheHash, std::equal_to<>> s_cache;
+
+			// read the generation before fetching so that a write which races the fetch leaves the entry stale.
+			auto generation = appGetSettingsGeneration();
+			auto key = SettingNameView(name);
+			auto it  = s_cache.find(key);
+			if (it == s_cache.end()) {
+				if (s_cache.size() >= kTypedSettingCacheMax) {
+					// stale entries go first, which includes those of settings removed since they were cached.
+					std::erase_if(s_cache, [&](auto const& item) { return item.second.generation != generation; });
+					if (s_cache.size() >= kTypedSettingCacheMax) {
+						s_cache.clear();
+					}
+				}
+				it = s_cache.emplace(std::string(key), TypedSettingCacheEntry<T>{ generation, fetch() }).first;
+			}
+			elif (it->second.generation != generation) {
+				it->second = { generation, fetch() };
+			}
+			return it->second.value;
+		}
+
+		template<typename T>
+		StdOptionString<T> const& CachedSettingConvert(StdStringTempArg name) {
+			return CachedSettingLookup<T>(name, [&]() -> StdOptionString<T> {
+				auto rval = appGetSetting(name);
+				if (rval.empty()) {
+					return {};
+				}
+				return icyAppSettingsIfc::ConvertFromString<T>(rval);
+			});
+		}
+	}
+
 	template<typename T>
 	StdOptionString<T> appGetSettingOpt(StdStringTempArg name) {
-		auto rval = appGetSetting(name);
-		if (rval.empty()) {
-			return {};
-		}
-		return icyAppSettingsIfc::ConvertFromString<T>(rval);
+		return _template_impl::CachedSettingConvert<T>(name);
 	}
 
 	template<typename T>
 	bool appEmplaceSetting(StdStringTempArg name, T& outDest, T const& defValue) {
-		auto rval = appGetSetting(name);
-		if (rval.empty()) {
-			outDest = defValue;
-			return false;
-		}
-		auto cvtResult = icyAppSettingsIfc::ConvertFromString<T>(rval);
+		auto const& cvtResult = _template_impl::CachedSettingConvert<T>(name);
 		if (!cvtResult) {
 			outDest = defValue;
 			return false;
 		}
-		return cvtResult.value();
+		outDest = cvtResult.value();
+		return true;
 	}
 
 	template<typename T>
 	bool appEmplaceSetting(StdStringTempArg name, T& outDest) {
-		auto rval = appGetSetting(name);
-		if (rval.empty()) {
-			return false;
-		}
-		auto cvtResult = icyAppSettingsIfc::ConvertFromString<T>(rval);
+		auto const& cvtResult = _template_impl::CachedSettingConvert<T>(name);
 		if (!cvtResult) {
 			return false;
 		}
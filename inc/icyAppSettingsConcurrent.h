@@ -0,0 +1,73 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// Lock-free (RCU-style) read access to app settings.
+//
+// The regular appGetSetting API requires callers to lock around the settings store. This interface is
+// intended for worker threads that read settings continuously while some other thread may be writing:
+//
+//   - writers mutate g_map inside appUpdateSettings(), which serializes writers and then publishes an
+//     immutable copy of the store (a snapshot) with a single atomic pointer swap.
+//   - readers enter a read epoch, load the current snapshot pointer, and read from it. Readers never
+//     block and never write to any shared cacheline other than their own epoch record.
+//   - replaced snapshots are freed by the writer once every reader that could have observed them has
+//     left its read epoch.
+//
+// Snapshots are only published by appUpdateSettings and appPublishSettingsSnapshot. Settings written
+// through appSetSetting directly (eg. during startup config parsing) become visible to concurrent readers
+// after the next publish.
+
+#include "icyAppSettingsBase.h"
+#include "icyAppSettingsShared.h"
+#include "FlatStringMap.h"
+
+#include <functional>
+
+namespace icyAppSettingsIfc
+{
+	struct SettingsSnapshot {
+		FlatStringMap	map;
+		uint64_t		generation;
+	};
+
+	// Copies the current contents of the settings store into a new snapshot and publishes it.
+	extern void appPublishSettingsSnapshot();
+
+	// Runs writer() under the settings writer lock, and publishes a new snapshot afterward if writer()
+	// modified the store. writer() should use appSetSetting/appRemoveSetting.
+	extern void appUpdateSettings(std::function<void()> const& writer);
+
+	// RAII read epoch. The snapshot exposed by the guard remains valid for the lifetime of the guard,
+	// even if writers publish newer snapshots in the meantime. Guards may be nested on the same thread.
+	class SettingsReadGuard {
+	private:
+		SettingsReadGuard(SettingsReadGuard const&) = delete;
+		SettingsReadGuard& operator=(SettingsReadGuard const&) = delete;
+
+	protected:
+		SettingsSnapshot const* m_snapshot;
+
+	public:
+		SettingsReadGuard();
+		~SettingsReadGuard();
+
+		// returns nullptr if no snapshot has been published yet.
+		SettingsSnapshot const* snapshot() const { return m_snapshot; }
+
+		// falls back on the attached shared segment, which is immutable for as long as it is attached.
+		bool lookup(std::string_view name, std::string_view& outValue) const {
+			return (m_snapshot && m_snapshot->map.lookup(name, outValue)) || appLookupSettingShared(name, outValue);
+		}
+
+		std::string_view get(std::string_view name) const {
+			std::string_view result;
+			lookup(name, result);
+			return result;
+		}
+	};
+
+	// convenience wrappers which copy the result out of a short-lived read guard.
+	extern std::string	appGetSettingConcurrent	(StdStringTempArg name);
+	extern bool			appGetSettingConcurrent	(std::string_view name, std::string& value);
+	extern bool			appHasSettingConcurrent	(std::string_view name);
+}
@@ -2,15 +2,39 @@
 #pragma once
 
 #include "icyAppSettingsBase.h"
+#include "FlatStringMap.h"
 #include <map>
 #include <optional>
 
 
 namespace icyAppSettingsIfc
 {
-	extern std::map<std::string, std::string> g_map;
+	// Merged view of all settings layers. Treat as read-only: modifications should go through
+	// appSetSettingLayer, otherwise they will be lost the next time the key is re-merged, and typed
+	// lookups and SettingHandles will not observe them.
+	extern FlatStringMap g_map;
+
+	// looks up the effective value of a setting: the merged view, falling back on the attached shared
+	// segment (if any). Code which reads g_map directly will not see shared settings.
+	extern bool appLookupSetting(std::string_view name, std::string_view& outValue);
+
+	// Increments g_generation and records the change in the settings change journal. Use the 'All' variant
+	// for changes which affect an unknown set of keys.
+	extern void _bumpSettingsGeneration		(std::string_view key);
+	extern void _bumpSettingsGenerationAll	();
+
+	// Retrieves the FlatStringMapHash of each key changed after the given generation (may contain duplicates).
+	// Returns FALSE if the journal no longer covers that generation, in which case any key may have changed.
+	extern bool _getSettingsChangedSince	(uint64_t generation, std::vector<uint32_t>& outHashes);
+
+	// maintains the hierarchical key index used by icyAppSettingsQuery.h. Called when a key enters or
+	// leaves the set of effective settings (merged view plus shared segment).
+	extern void _indexSettingKey			(std::string_view key);
+	extern void _unindexSettingKey			(std::string_view key);
+
+	extern StdOptionString<bool> _getSettingBool(FlatStringMap const& map, const std::string& name);
 
 	// used by Xem Tooling to implement a custom multi-tier settings system.
-	// (todo: probably a better way to implement that system than this, which is a bit sloppy/rushed)
+	// (prefer SettingsLayer and appSetSettingLayer for new code)
 	extern StdOptionString<bool> _getSettingBool(std::map<std::string, std::string> const& map, const std::string& name);
 }
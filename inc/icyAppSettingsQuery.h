@@ -0,0 +1,49 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// Prefix and glob enumeration of settings keys.
+//
+// Settings keys are indexed hierarchically by their dot-separated segments, eg. '--cache.disk.size' is
+// stored as '--cache' -> 'disk' -> 'size'. The index is maintained incrementally as keys are added and
+// removed, so enumerating a prefix costs O(prefix segments + matches) rather than O(total settings).
+//
+// Config files can produce dotted keys by way of INI-style [section] headers, see ConfigParseLine.
+//
+// Usage Notes:
+//   - keys are visited in segment order: sorted by segment, parents before children.
+//   - callbacks must not modify settings.
+//   - same thread locking rules as the rest of the settings API apply.
+
+#include "icyAppSettingsBase.h"
+
+#include <functional>
+
+namespace icyAppSettingsIfc
+{
+	using SettingsVisitFunc = std::function<void(std::string_view key, std::string_view value)>;
+
+	// A glob pattern (see StringUtil::globMatch) split into its literal prefix and the remainder. The
+	// prefix is used to narrow the search via the key index before the pattern is applied.
+	class CompiledSettingsGlob {
+	protected:
+		std::string		m_pattern;
+		size_t			m_literal_length;
+
+	public:
+		CompiledSettingsGlob(std::string_view pattern);
+
+		bool				matches			(std::string const& key) const;
+		std::string_view	literal_prefix	() const	{ return { m_pattern.data(), m_literal_length }; }
+		std::string const&	pattern			() const	{ return m_pattern; }
+		bool				is_literal		() const	{ return m_literal_length == m_pattern.size(); }
+	};
+
+	// visits all settings whose key begins with prefix. Returns the number of settings visited.
+	extern int	appForEachSettingWithPrefix	(std::string_view prefix, SettingsVisitFunc const& func);
+	extern int	appForEachSettingMatching	(CompiledSettingsGlob const& glob, SettingsVisitFunc const& func);
+
+	// visits the immediate child segments of a dotted key, eg. the plugin names under '--plugins'. The
+	// parent itself need not be a setting. Pass an empty parent to visit top-level segments.
+	// isSetting is TRUE if the child is itself a setting (as opposed to only being a parent of settings).
+	extern int	appForEachSettingChild		(std::string_view parent, std::function<void(std::string_view segment, bool isSetting)> const& func);
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// Shared-memory settings segment for multi-process deployments.
+//
+// A parent process parses its configuration as usual, and then publishes the merged settings store into a
+// read-only segment: a serialized FlatStringMap (slot table, entry table and string arena) behind a small
+// header. Worker processes map the segment and serve appGetSetting* straight out of it, without parsing
+// any config and without holding a private copy of the store.
+//
+// The segment sits beneath the local settings layers: any setting written locally by the worker (via
+// appSetSetting or appSetSettingLayer) takes precedence over the shared value.
+//
+// Two transports are supported:
+//   - memfd: appPublishSettingsSharedMemory() returns a sealed, inheritable fd. Pass it to children
+//     by fork/exec (the fd number can be handed over via kSettingsSharedFdEnvVar).
+//   - file:  appPublishSettingsSharedFile() writes the image to a path, which children map by name.
+//
+// Usage Notes:
+//   - same thread locking rules as the rest of the settings API apply to attach/detach.
+//   - views returned by lookups into the segment remain valid until appDetachSettingsShared().
+//   - appGetSettingProvenance() only reports local layers, so settings served from the segment report nullopt.
+
+#include "icyAppSettingsBase.h"
+
+namespace icyAppSettingsIfc
+{
+	// environment variable read by appAttachSettingsSharedFromEnvironment().
+	static constexpr char kSettingsSharedFdEnvVar[] = "ICY_SETTINGS_SHARED_FD";
+
+	// returns an fd to a sealed memfd holding the current settings, or -1 on error (or if unsupported
+	// by the platform). The fd is not close-on-exec, so that it survives into exec'd children.
+	extern int	appPublishSettingsSharedMemory	();
+
+	// writes the current settings to the given path. The file is replaced atomically (rename), so
+	// children which map an older version of it are unaffected.
+	extern bool	appPublishSettingsSharedFile	(char const* path);
+
+	// maps a settings segment and uses it as the base for all settings lookups. Any previously attached
+	// segment is detached first. The caller retains ownership of fd.
+	extern bool	appAttachSettingsShared			(int fd);
+	extern bool	appAttachSettingsSharedFile		(char const* path);
+
+	// attaches to the fd named by kSettingsSharedFdEnvVar, if set. Returns FALSE if the variable is not
+	// set or the segment could not be attached.
+	extern bool	appAttachSettingsSharedFromEnvironment();
+
+	extern void	appDetachSettingsShared			();
+	extern bool	appIsSettingsSharedAttached		();
+
+	// looks up a setting in the attached segment only, ignoring local layers.
+	extern bool	appLookupSettingShared			(std::string_view name, std::string_view& outValue);
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// SettingHandle<T> - pre-resolved, pre-converted access to a single setting.
+//
+// Intended for settings that are read in inner loops, where even a hashed string lookup is too much.
+// Declare the handle at namespace scope:
+//
+//     static SettingHandle<int> s_threads { "--threads", 4 };
+//
+// The handle registers itself with the settings system during static init. Whenever appSetSetting/
+// appRemoveSetting touches the handle's key, the new value is converted once and stored in the handle.
+// Reading the handle is then a plain load of the converted value.
+//
+// Usage Notes:
+//   - the name must have static lifetime (a string literal, typically).
+//   - a removed or unparsable setting reverts the handle to its default value.
+//   - same thread locking rules as the rest of the settings API apply: writers must not race readers.
+
+#include "icyAppSettingsBase.h"
+
+namespace icyAppSettingsIfc
+{
+	class SettingHandleBase {
+	private:
+		SettingHandleBase(SettingHandleBase const&) = delete;
+		SettingHandleBase& operator=(SettingHandleBase const&) = delete;
+
+	protected:
+		char const*		m_name;
+		bool			m_registered;
+
+		SettingHandleBase(char const* name);
+		~SettingHandleBase();
+
+		// Must be called by the derived constructor once the handle is ready to accept values.
+		void _register();
+
+	public:
+		// rval is nullptr if the setting has been removed.
+		virtual void _refresh(std::string_view const* rval) = 0;
+
+		char const*		name() const	{ return m_name; }
+	};
+
+	// invoked by the settings store whenever a key is written or removed.
+	extern void _notifySettingHandles(std::string_view name, std::string_view const* rval);
+
+	template<typename T>
+	class SettingHandle : public SettingHandleBase {
+	protected:
+		T		m_value;
+		T		m_default;
+		bool	m_isSet = false;
+
+	public:
+		SettingHandle(char const* name, T const& defValue = T{})
+			: SettingHandleBase(name)
+			, m_value(defValue)
+			, m_default(defValue)
+		{
+			_register();
+		}
+
+		void _refresh(std::string_view const* rval) override {
+			if (!rval) {
+				m_value = m_default;
+				m_isSet = false;
+				return;
+			}
+
+			m_isSet = true;
+			if constexpr (std::is_same_v<T, std::string>) {
+				m_value = *rval;
+			}
+			else {
+				auto cvt = icyAppSettingsIfc::ConvertFromString<T>(std::string(*rval));
+				m_value = cvt.value_or(m_default);
+			}
+		}
+
+		T const&	get		() const	{ return m_value; }
+		T const&	operator*() const	{ return m_value; }
+		T const*	operator->() const	{ return &m_value; }
+		operator	T const& () const	{ return m_value; }
+
+		// TRUE if the setting exists in the store (regardless of whether it parsed successfully).
+		bool		isSet	() const	{ return m_isSet; }
+	};
+}
+
+using icyAppSettingsIfc::SettingHandle;
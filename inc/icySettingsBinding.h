@@ -0,0 +1,149 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+#pragma once
+
+// Struct binding - fill a plain struct of tuning parameters from the settings store in one call.
+//
+// Describe the struct's fields and their setting names once, at namespace scope:
+//
+//     struct RenderTuning {
+//         int      threads    = 4;
+//         float    lod_bias   = 0.0f;
+//         std::string shader_dir;
+//     };
+//
+//     SETTINGS_STRUCT_BEGIN(RenderTuning)
+//         SETTINGS_FIELD(threads,    "--render-threads")
+//         SETTINGS_FIELD(lod_bias,   "--lod-bias")
+//         SETTINGS_FIELD(shader_dir, "--shader-dir")
+//     SETTINGS_STRUCT_END()
+//
+// Then either fill a struct directly with appLoadSettingsStruct(), or hold a SettingsBinding<T> which
+// loads the struct once and afterward refills only the fields whose settings have changed:
+//
+//     static SettingsBinding<RenderTuning> s_tuning;
+//     s_tuning.refresh();         // cheap no-op when no settings have changed
+//     s_tuning->threads;
+//
+// Fields are converted with ConvertFromString. A setting which is missing, or rejected by the conversion,
+// resets the field to its default value, which is the value held by a default-constructed T. A setting
+// which is present with an empty value follows the switch convention: bool fields become TRUE (a bare
+// --switch), string fields become empty, and numeric fields reset to their default.
+//
+// Usage Notes:
+//   - T must be default-constructible and copy-assignable, and its fields must be types supported by
+//     ConvertFromString<T>, or std::string.
+//   - same thread locking rules as the rest of the settings API apply.
+
+#include "icyAppSettingsBase.h"
+
+#include <cstddef>
+
+namespace icyAppSettingsIfc
+{
+	struct SettingFieldDesc {
+		char const*	name;
+		size_t		offset;
+
+		// assigns the field from rval, or from the matching field of the defaults struct if rval is nullptr or
+		// cannot be converted. Returns TRUE if the field was set from rval.
+		bool (*assign)(void* field, void const* defField, std::string_view const* rval);
+	};
+
+	// specialized by SETTINGS_STRUCT_BEGIN/END.
+	template<typename T>
+	struct SettingsFieldTable;
+
+	namespace _template_impl {
+		template<typename F>
+		bool AssignSettingField(void* field, void const* defField, std::string_view const* rval) {
+			// an empty value is still a value: a bare --switch is TRUE for bool fields, and an empty string
+			// for string fields. ConvertFromString decides for everything else.
+			auto& dest = *(F*)field;
+			if (rval) {
+				if constexpr (std::is_same_v<F, std::string>) {
+					dest = *rval;
+					return true;
+				}
+				else {
+					auto cvt = icyAppSettingsIfc::ConvertFromString<F>(std::string(*rval));
+					if (cvt.has_value() && cvt->first.has_value()) {
+						dest = *cvt->first;
+						return true;
+					}
+				}
+			}
+			dest = *(F const*)defField;
+			return false;
+		}
+
+		struct SettingsFieldSpan {
+			SettingFieldDesc const*	fields;
+			size_t					count;
+			uint32_t const*			hashes;		// FlatStringMapHash of each field name
+		};
+
+		extern uint32_t const*	HashSettingFields		(SettingFieldDesc const* fields, size_t count);
+		extern int				FillSettingsStruct		(void* dest, void const* defaults, SettingsFieldSpan const& span);
+		extern int				RefillSettingsStruct	(void* dest, void const* defaults, SettingsFieldSpan const& span, uint64_t& inoutGeneration);
+
+		template<typename T>
+		SettingsFieldSpan const& GetSettingsFieldSpan() {
+			using Table = SettingsFieldTable<T>;
+			static SettingsFieldSpan const s_span = {
+				Table::fields, std::size(Table::fields),
+				HashSettingFields(Table::fields, std::size(Table::fields))
+			};
+			return s_span;
+		}
+	}
+
+	// Fills every bound field of dest from the settings store. Returns the number of fields that were set
+	// from a setting (as opposed to being reset to their default).
+	template<typename T>
+	int appLoadSettingsStruct(T& dest) {
+		static T const s_defaults {};
+		return _template_impl::FillSettingsStruct(&dest, &s_defaults, _template_impl::GetSettingsFieldSpan<T>());
+	}
+
+	template<typename T>
+	class SettingsBinding {
+	protected:
+		T			m_value;
+		T			m_defaults;
+		uint64_t	m_generation;
+
+	public:
+		SettingsBinding() {
+			m_generation = appGetSettingsGeneration();
+			_template_impl::FillSettingsStruct(&m_value, &m_defaults, _template_impl::GetSettingsFieldSpan<T>());
+		}
+
+		// Refills fields whose settings have changed since the last fill. Returns the number of fields that
+		// were reassigned (fields affected by a change may still end up with the same value as before).
+		int refresh() {
+			if (expect_true(m_generation == appGetSettingsGeneration())) {
+				return 0;
+			}
+			return _template_impl::RefillSettingsStruct(&m_value, &m_defaults, _template_impl::GetSettingsFieldSpan<T>(), m_generation);
+		}
+
+		T const&	get		() const	{ return m_value; }
+		T const&	operator*() const	{ return m_value; }
+		T const*	operator->() const	{ return &m_value; }
+	};
+}
+
+using icyAppSettingsIfc::SettingsBinding;
+using icyAppSettingsIfc::appLoadSettingsStruct;
+
+#define SETTINGS_STRUCT_BEGIN(type)																\
+	template<> struct icyAppSettingsIfc::SettingsFieldTable<type> {								\
+		using _Struct_ = type;																	\
+		static inline SettingFieldDesc const fields[] = {
+
+#define SETTINGS_FIELD(member, name)															\
+			{ name, offsetof(_Struct_, member), &icyAppSettingsIfc::_template_impl::AssignSettingField<decltype(_Struct_::member)> },
+
+#define SETTINGS_STRUCT_END()																	\
+		};																						\
+	};
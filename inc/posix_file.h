@@ -17,6 +17,7 @@ using x_off_t = intmax_t;
 
 	// windows POSIX libs are lacking the fancy new pread() function. >_<
 	extern size_t _pread(int fd, void* dest, size_t count, x_off_t pos);
+	extern size_t _pwrite(int fd, const void* src, size_t count, x_off_t pos);
 
 	// Windows has this asinine non-standard notion of text mode POSIX files and, worse, makes the
 	// non-standard behavior the DEFAULT behavior.  What the bloody hell, Microsoft?  Your're drunk.
@@ -25,11 +26,13 @@ using x_off_t = intmax_t;
 #	define posix_open(fn,flags,mode)   _open(fn,(flags) | _O_BINARY, mode)
 #	define posix_read   _read
 #	define posix_pread  _pread
+#	define posix_pwrite _pwrite
 #	define posix_write  _write
 #	define posix_close  _close
 #	define posix_lseek  _lseeki64
 #	define posix_unlink _unlink
 #	define O_DIRECT		(0)		// does not exist on windows
+	inline constexpr int posix_O_DIRECT = 0;
 #	define DEFFILEMODE  (_S_IREAD | _S_IWRITE)
 
 #else	// assume POSIX compliant as the fallback.
@@ -41,11 +44,22 @@ using x_off_t = intmax_t;
 #	define posix_open   open
 #	define posix_read   read
 #	define posix_pread  pread
+#	define posix_pwrite pwrite
 #	define posix_write  write
 #	define posix_close  close
 #	define posix_lseek  lseek
 #	define posix_unlink unlink
 
+	// O_DIRECT requires buffers, offsets and sizes aligned to the device block size, which most callers
+	// don't provide, so it is forced to 0 and passing it is harmless. Code which does align its I/O (see
+	// DirectFileReader) opts in via posix_O_DIRECT, which is 0 where the platform has no such flag (Mac
+	// uses fcntl F_NOCACHE instead).
+#	if defined(O_DIRECT)
+	inline constexpr int posix_O_DIRECT = O_DIRECT;
+#	else
+	inline constexpr int posix_O_DIRECT = 0;
+#	endif
+
 #   undef O_DIRECT
 #   define O_DIRECT 0 // requires 512-byte alignment, must refactor target buffers first
 
@@ -55,9 +69,14 @@ struct CStatInfo;
 
 // Modification info: abbreviated form of stat that excludes things not relevant to whether a file
 // should be reloaded or not.
+// Includes file identity (device and inode), so that a file replaced via rename is detected as
+// modified even if its size and timestamp match. Identity is zero on platforms which do not report it.
 struct CStatModInfo {
 	intmax_t    st_size;
 	time_t      time_modified;
+	int32_t     time_modified_nsec	= 0;
+	uint64_t    st_dev				= 0;
+	uint64_t    st_ino				= 0;
 };
 
 // Lightweight helper class for POSIX stat, just to put things in a little more friendly container.
@@ -70,12 +89,20 @@ struct CStatInfo
 	time_t      time_modified;
 	time_t      time_changed;		// file contents -OR- mode changed.
 
+	// sub-second part of the above timestamps, zero where the platform/filesystem doesn't provide it.
+	int32_t     time_accessed_nsec	= 0;
+	int32_t     time_modified_nsec	= 0;
+	int32_t     time_changed_nsec	= 0;
+
+	uint64_t    st_dev				= 0;
+	uint64_t    st_ino				= 0;
+
 	operator CStatModInfo() const {
-		return { st_size, time_modified };
+		return getModificationInfo();
 	}
 
 	CStatModInfo getModificationInfo() const {
-		return { st_size, time_modified };
+		return { st_size, time_modified, time_modified_nsec, st_dev, st_ino };
 	}
 
 	bool IsFile     () const;
@@ -88,7 +115,12 @@ struct CStatInfo
 			(st_size		== r.st_size			) &&
 			(time_accessed	== r.time_accessed		) &&
 			(time_modified	== r.time_modified		) &&
-			(time_changed	== r.time_changed		)
+			(time_changed	== r.time_changed		) &&
+			(time_accessed_nsec	== r.time_accessed_nsec	) &&
+			(time_modified_nsec	== r.time_modified_nsec	) &&
+			(time_changed_nsec	== r.time_changed_nsec	) &&
+			(st_dev			== r.st_dev				) &&
+			(st_ino			== r.st_ino				)
 		);
 	}
 
@@ -101,21 +133,30 @@ struct CStatInfo
 inline bool operator==(const CStatInfo& lval, const CStatModInfo& rval)  {
 	return (
 		(lval.st_size		== rval.st_size			) &&
-		(lval.time_modified	== rval.time_modified	)
+		(lval.time_modified	== rval.time_modified	) &&
+		(lval.time_modified_nsec == rval.time_modified_nsec) &&
+		(lval.st_dev		== rval.st_dev			) &&
+		(lval.st_ino		== rval.st_ino			)
 	);
 }
 
 inline bool operator==(const CStatModInfo& lval, const CStatInfo& rval)  {
 	return (
 		(lval.st_size		== rval.st_size			) &&
-		(lval.time_modified	== rval.time_modified	)
+		(lval.time_modified	== rval.time_modified	) &&
+		(lval.time_modified_nsec == rval.time_modified_nsec) &&
+		(lval.st_dev		== rval.st_dev			) &&
+		(lval.st_ino		== rval.st_ino			)
 	);
 }
 
 inline bool operator==(const CStatModInfo& lval, const CStatModInfo& rval)  {
 	return (
 		(lval.st_size		== rval.st_size			) &&
-		(lval.time_modified	== rval.time_modified	)
+		(lval.time_modified	== rval.time_modified	) &&
+		(lval.time_modified_nsec == rval.time_modified_nsec) &&
+		(lval.st_dev		== rval.st_dev			) &&
+		(lval.st_ino		== rval.st_ino			)
 	);
 }
 
@@ -136,3 +177,16 @@ inline bool operator!=(const CStatModInfo& lval, const CStatModInfo& rval) {
 extern int				posix_link		(const char* existing_file, const char* link);
 extern CStatInfo		posix_fstat		(int fd);
 extern CStatInfo		posix_stat		(const char* fullpath);
+
+// Stats many paths at once. dest[i] receives the result for paths[i], or a zeroed CStatInfo if the path
+// does not exist. Work is spread across numThreads threads (0 to choose automatically based on count).
+// Symlinks are followed, same as posix_stat. Returns the number of paths which exist.
+extern intmax_t			posix_stat_batch(const char* const* paths, size_t count, CStatInfo* dest, int numThreads = 0);
+
+#if PLATFORM_LINUX
+// fields requested by posix_stat_batch and the async statx of AsyncFileIO: everything CStatInfo holds.
+#	define kPosixStatxMask	(STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_ATIME | STATX_MTIME | STATX_CTIME | STATX_INO)
+
+struct statx;
+extern CStatInfo		posix_statx_to_info(const struct statx& stx);
+#endif
@@ -11,4 +11,7 @@ public:
 	CStatInfo Stat(const fs::path& path) override;
 	bool Exists(const fs::path& path) override;
 	void VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) override;
+
+	// regular files are memory-mapped (see MappedStream), other files are read via FdStream.
+	std::unique_ptr<fs::InputStream> Open(const fs::path& path) override;
 };
@@ -3,10 +3,46 @@
 #include "StringUtil.h"
 #include "StringTokenizer.h"
 #include "fs.h"
+#include "CompactPath.h"
+#include "FlatStringMap.h"
+#include "icyAppSettingsMap.h"
+#include "icySettingHandle.h"
+#include "icyAppSettingsShared.h"
+#include "icySettingsBinding.h"
+#include "ConfigParse.h"
+#include "DirWalker.h"
+#include "AsyncFileIO.h"
+#include "VirtualFileSystem.h"
+#include "PackArchive.h"
+#include "icyAppSettingsConcurrent.h"
+#include "icyAppSettingsQuery.h"
+#include "EnvironUtil.h"
+#include "DirEnumerator.h"
+#include "cachingfilesystem.h"
+#include "MemoryFileSystem.h"
+#include "MappedFile.h"
+#include "DirectFileReader.h"
+#include "BufferedFile.h"
+#include "InputStream.h"
+#include "FileWatcher.h"
 
 #include "msw-app-console-init.h"
 #include "StringUtil.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// checks which are not verified by diffing the output: failures are printed, and fail the exit code.
+static int s_test_failures = 0;
+
+#define TEST_CHECK(cond)	((cond) ? (void)0 : (void)(printf("FAIL: %s(%d): %s\n", __FILE__, __LINE__, #cond), ++s_test_failures))
+
 static const char* parse_inputs[] = {
     "",
     "--lvalue=rvalue1",
@@ -112,9 +148,1526 @@ static const char* path_absmount_inputs[] = {
     "rom:/one/two\\three"                 ,
 };
 
+static void test_lexically_normal() {
+	struct Case { const char* input; const char* expect; };
+	static const Case cases[] = {
+		{ "/..",						"/"					},
+		{ "/../../etc/passwd",			"/etc/passwd"		},
+		{ "../a/../..",					"../.."				},
+		{ "a/./b//c/..",				"a/b"				},
+		{ "rom:",						"rom:"				},
+		{ "rom:/",						"rom:/"				},
+		{ "rom:/..",					"rom:/"				},
+		{ "rom:/../../etc/passwd",		"rom:/etc/passwd"	},
+		{ "rom:/sub/../../x",			"rom:/x"			},
+		{ "rom://a/./b/..",				"rom:/a"			},
+		{ "c:/one/../two",				"c:/two"			},
+		{ ":/..",						"."					},		// not a mount name: just a relative component
+	};
+	for (auto const& item : cases) {
+		std::string buf = item.input;
+		buf.resize(fs::LexicallyNormalize(buf.data(), buf.size()));
+		if (buf != item.expect) {
+			printf("FAIL: LexicallyNormalize('%s') = '%s', expected '%s'\n", item.input, buf.c_str(), item.expect);
+			++s_test_failures;
+		}
+	}
+}
+
+static void test_compact_path() {
+	struct Case { const char* base; const char* comp; const char* expect; };
+	static const Case cases[] = {
+		{ "",			"/",		"/"			},
+		{ "/rom",		"/",		"/"			},		// a rooted component replaces the path, even the bare root
+		{ "one/two",	"/",		"/"			},
+		{ "one/two",	"//",		"/"			},
+		{ "/",			"x",		"/x"		},
+		{ "/",			"x/",		"/x"		},
+		{ "/rom",		"x/",		"/rom/x"	},
+		{ "one/two",	"/abs/",	"/abs"		},
+		{ "one",		"",			"one"		},
+	};
+	for (auto const& item : cases) {
+		auto actual = std::string((fs::CompactPath(item.base) / item.comp).uni_view());
+		if (actual != item.expect) {
+			printf("FAIL: CompactPath('%s') / '%s' = '%s', expected '%s'\n", item.base, item.comp, actual.c_str(), item.expect);
+			++s_test_failures;
+		}
+	}
+	TEST_CHECK(fs::CompactPath("/").uni_view() == "/");
+	TEST_CHECK(fs::CompactPath("/rom/").uni_view() == "/rom");
+}
+
+static void test_flat_string_map() {
+	using namespace icyAppSettingsIfc;
+	std::string_view val;
+
+	// set/get/overwrite
+	FlatStringMap map;
+	TEST_CHECK(!map.lookup("alpha", val));
+	TEST_CHECK( map.set("alpha", "1"));
+	TEST_CHECK(!map.set("alpha", "1"));					// same value is not a modification
+	TEST_CHECK( map.lookup("alpha", val) && val == "1");
+	TEST_CHECK( map.set("alpha", "a longer value"));		// grows: appended to the arena
+	TEST_CHECK( map.lookup("alpha", val) && val == "a longer value");
+	TEST_CHECK( map.set("alpha", "2"));					// shrinks: overwritten in place
+	TEST_CHECK( map.lookup("alpha", val) && val == "2" && val.data()[val.size()] == 0);
+	TEST_CHECK( map.set("", "empty key") && map.lookup("", val) && val == "empty key");
+	TEST_CHECK( map.set("novalue", "") && map.lookup("novalue", val) && val.empty());
+	TEST_CHECK( map.size() == 3);
+
+	// erase leaves tombstones, which must neither end probe chains nor be found.
+	map.clear();
+	for (int i = 0; i < 10; ++i) {
+		map.set("key" + std::to_string(i), std::to_string(i));
+	}
+	for (int i = 1; i < 10; i += 2) {
+		TEST_CHECK(map.erase("key" + std::to_string(i)));
+	}
+	TEST_CHECK(!map.erase("key1"));
+	TEST_CHECK(map.size() == 5);
+	for (int i = 0; i < 10; ++i) {
+		bool found = map.lookup("key" + std::to_string(i), val);
+		TEST_CHECK(found == !(i & 1));
+		TEST_CHECK(!found || val == std::to_string(i));
+	}
+	for (int i = 1; i < 10; i += 2) {
+		TEST_CHECK(map.set("key" + std::to_string(i), "again"));		// reuses tombstoned slots
+	}
+	TEST_CHECK(map.size() == 10);
+	TEST_CHECK(map.lookup("key7", val) && val == "again");
+
+	int visited = 0;
+	map.forEach([&](std::string_view, std::string_view) { ++visited; });
+	TEST_CHECK(visited == 10);
+
+	// rehash past 75% load, and repeated erase/insert churn which fills the table with tombstones.
+	map.clear();
+	for (int i = 0; i < 1000; ++i) {
+		map.set("grow." + std::to_string(i), std::to_string(i * 3));
+	}
+	TEST_CHECK(map.size() == 1000);
+	TEST_CHECK((map.slot_mask() + 1) * 3 >= map.size() * 4);
+	for (int i = 0; i < 1000; ++i) {
+		TEST_CHECK(map.lookup("grow." + std::to_string(i), val) && val == std::to_string(i * 3));
+	}
+	for (int i = 0; i < 5000; ++i) {
+		map.set("churn", std::to_string(i));
+		map.erase("churn");
+		map.set("churn." + std::to_string(i), "x");
+		map.erase("churn." + std::to_string(i));
+	}
+	TEST_CHECK(map.size() == 1000 && !map.contains("churn") && !map.contains("churn.4999"));
+
+	// keys and values which alias the map's own arena must survive the arena being reallocated.
+	map.clear();
+	map.set("seed", "value");
+	for (int i = 0; i < 200; ++i) {
+		auto* prev = map.find(i ? "copy" + std::to_string(i - 1) : "seed");
+		TEST_CHECK(prev && map.set("copy" + std::to_string(i), map.value_of(*prev)));
+	}
+	TEST_CHECK(map.lookup("copy199", val) && val == "value");
+	auto* seed = map.find("seed");
+	TEST_CHECK(seed && map.set(map.key_of(*seed), std::string(300, 'z')));
+	seed = map.find("seed");
+	TEST_CHECK(seed && map.set(map.value_of(*seed), map.key_of(*seed)));
+	TEST_CHECK(map.lookup(std::string(300, 'z'), val) && val == "seed");
+
+	// the public settings API over g_map.
+	appSetSetting("test.flatmap.a", "first");
+	appSetSetting("test.flatmap.b", std::string(appGetSettingView("test.flatmap.a")));
+	TEST_CHECK(appGetSetting("test.flatmap.b") == "first");
+	appSetSetting("test.flatmap.a", "second");
+	TEST_CHECK(appGetSetting("test.flatmap.a") == "second" && appGetSetting("test.flatmap.b") == "first");
+	TEST_CHECK(g_map.contains("test.flatmap.a"));
+	appRemoveSetting("test.flatmap.a");
+	appRemoveSetting("test.flatmap.b");
+	TEST_CHECK(!appHasSetting("test.flatmap.a") && !appHasSetting("test.flatmap.b"));
+}
+
+static void test_typed_settings() {
+	using namespace icyAppSettingsIfc;
+
+	// more distinct names than the typed cache holds, so that it is pruned along the way.
+	for (int i = 0; i < 600; ++i) {
+		auto name = "test.typed." + std::to_string(i);
+		appSetSetting(name, std::to_string(i));
+		TEST_CHECK(appGetSettingOpt<int>(name).value_or(-1) == i);
+	}
+	for (int i = 0; i < 600; i += 7) {
+		auto name = "test.typed." + std::to_string(i);
+		TEST_CHECK(appGetSettingOpt<int>(name).value_or(-1) == i);
+		appSetSetting(name, "-5");
+		TEST_CHECK(appGetSettingOpt<int>(name).value_or(-1) == -5);
+		appRemoveSetting(name);
+		TEST_CHECK(!appGetSettingOpt<int>(name));
+	}
+	for (int i = 0; i < 600; ++i) {
+		appRemoveSetting("test.typed." + std::to_string(i));
+	}
+
+	// handles are refreshed by writes to their key, including handles which share a key.
+	SettingHandle<int> handleA { "test.handle", 3 };
+	{
+		SettingHandle<int> handleB { "test.handle", 4 };
+		appSetSetting("test.handle", "10");
+		TEST_CHECK(*handleA == 10 && *handleB == 10 && handleA.isSet());
+	}
+	appSetSetting("test.handle", "11");		// handleB is gone, and must no longer be notified
+	TEST_CHECK(*handleA == 11);
+	appRemoveSetting("test.handle");
+	TEST_CHECK(*handleA == 3 && !handleA.isSet());
+}
+
+// scratch files are created in the working directory, and removed by the tests which create them.
+static std::string test_tmp_path(const char* name) {
+	return std::string("tests_main.") + name + ".tmp";
+}
+
+static void test_config_parse_sections() {
+	std::vector<std::string> items;
+	auto push = [&](const std::string& lvalue, const std::string& rvalue) { items.push_back(lvalue + "=" + rvalue); };
+
+	// sections carry over through an explicit state, and never through the context.
+	ConfigParseState state;
+	TEST_CHECK(ConfigParseLine("[cache]", push, {}, state));
+	TEST_CHECK(ConfigParseLine("--size = 30", push, {}, state));
+	TEST_CHECK(ConfigParseLine("[cache.disk]", push, {}, state));
+	TEST_CHECK(ConfigParseLine("path = /tmp", push, {}, state));
+	TEST_CHECK(ConfigParseLine("[cache]", push));
+	TEST_CHECK(ConfigParseLine("--plain = 1", push));
+	TEST_CHECK(items.size() == 3);
+	TEST_CHECK(items.size() == 3 && items[0] == "--cache.size=30" && items[1] == "cache.disk.path=/tmp" && items[2] == "--plain=1");
+	TEST_CHECK(!ConfigParseLine("[unterminated", push, {}, state));
+}
+
+static void test_settings_layers() {
+	using namespace icyAppSettingsIfc;
+
+	{
+		auto* fp = fopen(test_tmp_path("settings").c_str(), "wb");
+		fputs("--test.layer.a = file\n[test.layer]\n--b = file\n--c = file\n", fp);
+		fclose(fp);
+	}
+	TEST_CHECK(appLoadSettingsFile(test_tmp_path("settings")));
+	remove(test_tmp_path("settings").c_str());
+	TEST_CHECK(appGetSetting("--test.layer.b") == "file");
+	TEST_CHECK(appGetSettingProvenance("--test.layer.a") == SettingsLayer::ConfigFile);
+
+	const char* args[] = { "--test.layer.b=cli", "--test.layer.c", "cli", "--", "positional" };
+	appLoadSettingsArgs(5, args);
+	TEST_CHECK(appGetSetting("--test.layer.b") == "cli" && appGetSetting("--test.layer.c") == "cli");
+	TEST_CHECK(appGetSettingProvenance("--test.layer.b") == SettingsLayer::CommandLine);
+	TEST_CHECK(!appHasSetting("positional"));
+
+	// runtime overrides, and removing an override reveals the value beneath it.
+	appSetSetting("--test.layer.b", "runtime");
+	TEST_CHECK(appGetSetting("--test.layer.b") == "runtime");
+	appRemoveSettingLayer(SettingsLayer::Runtime, "--test.layer.b");
+	TEST_CHECK(appGetSetting("--test.layer.b") == "cli");
+
+	// appRemoveSetting removes the setting outright, whichever layers provide it.
+	appSetSetting("--test.layer.c", "runtime");
+	appRemoveSetting("--test.layer.c");
+	appRemoveSetting("--test.layer.a");
+	TEST_CHECK(!appHasSetting("--test.layer.c") && !appGetSettingProvenance("--test.layer.c"));
+	TEST_CHECK(!appHasSetting("--test.layer.a"));
+	TEST_CHECK(appGetSetting("--test.layer.b") == "cli");
+
+	appClearSettingsLayer(SettingsLayer::CommandLine);
+	TEST_CHECK(appGetSetting("--test.layer.b") == "file");
+	appClearSettingsLayer(SettingsLayer::ConfigFile);
+	TEST_CHECK(!appHasSetting("--test.layer.b"));
+}
+
+struct TestTuning {
+	bool		verbose		= false;
+	int			threads		= 4;
+	std::string	label		= "default";
+};
+
+SETTINGS_STRUCT_BEGIN(TestTuning)
+	SETTINGS_FIELD(verbose,	"--test.tuning.verbose")
+	SETTINGS_FIELD(threads,	"--test.tuning.threads")
+	SETTINGS_FIELD(label,	"--test.tuning.label")
+SETTINGS_STRUCT_END()
+
+static void test_settings_binding() {
+	using namespace icyAppSettingsIfc;
+
+	SettingsBinding<TestTuning> tuning;
+	TEST_CHECK(!tuning->verbose && tuning->threads == 4 && tuning->label == "default");
+
+	// present but empty: a bare switch is TRUE, strings are empty, numbers fall back to their default.
+	appSetSetting("--test.tuning.verbose", "");
+	appSetSetting("--test.tuning.threads", "");
+	appSetSetting("--test.tuning.label", "");
+	tuning.refresh();
+	TEST_CHECK(tuning->verbose && tuning->threads == 4 && tuning->label.empty());
+
+	appSetSetting("--test.tuning.verbose", "0");
+	appSetSetting("--test.tuning.threads", "16");
+	tuning.refresh();
+	TEST_CHECK(!tuning->verbose && tuning->threads == 16);
+
+	appRemoveSetting("--test.tuning.verbose");
+	appRemoveSetting("--test.tuning.threads");
+	appRemoveSetting("--test.tuning.label");
+	tuning.refresh();
+	TEST_CHECK(!tuning->verbose && tuning->threads == 4 && tuning->label == "default");
+}
+
+static void test_settings_shared() {
+#if PLATFORM_POSIX
+	using namespace icyAppSettingsIfc;
+
+	auto path = test_tmp_path("shared");
+	appSetSetting("--test.shared.a", "one");
+	TEST_CHECK(appPublishSettingsSharedFile(path.c_str()));
+	appRemoveSetting("--test.shared.a");
+
+	TEST_CHECK(appAttachSettingsSharedFile(path.c_str()));
+	TEST_CHECK(appGetSetting("--test.shared.a") == "one");
+	TEST_CHECK(!appHasSetting("--test.shared.missing"));
+	appDetachSettingsShared();
+	TEST_CHECK(!appHasSetting("--test.shared.a"));
+
+	// a segment whose slots are all tombstones would make every miss probe forever, and must be rejected.
+	// (layout: see SettingsSharedHeader in AppSettingsShared.cpp)
+	std::string image;
+	if (auto* fp = fopen(path.c_str(), "rb")) {
+		char buf[4096];
+		while (auto len = fread(buf, 1, sizeof(buf), fp)) {
+			image.append(buf, len);
+		}
+		fclose(fp);
+	}
+	uint32_t slotCount = 0;
+	uint64_t slotsOffset = 0;
+	TEST_CHECK(image.size() >= 24);
+	if (image.size() >= 24) {
+		memcpy(&slotCount, image.data() + 8, 4);
+		memcpy(&slotsOffset, image.data() + 16, 8);
+	}
+	TEST_CHECK(slotCount && slotsOffset + slotCount * 8 <= image.size());
+	if (slotCount && slotsOffset + slotCount * 8 <= image.size()) {
+		for (uint32_t i = 0; i < slotCount; ++i) {
+			memset(image.data() + slotsOffset + i * 8 + 4, 0xff, 4);
+		}
+		auto* fp = fopen(path.c_str(), "wb");
+		fwrite(image.data(), 1, image.size(), fp);
+		fclose(fp);
+		TEST_CHECK(!appAttachSettingsSharedFile(path.c_str()));
+		TEST_CHECK(!appIsSettingsSharedAttached());
+	}
+	remove(path.c_str());
+#endif
+}
+
+static void test_dir_walker() {
+	// a narrow tree walked with more threads than directories, so that most workers idle and must be
+	// woken for each new directory and again when the walk completes.
+	auto root = fs::path(test_tmp_path("walk"));
+	fs::remove_all(root);
+	fs::create_directory(root);
+	std::vector<std::string> expected;
+	std::string rel;
+	for (int depth = 0; depth < 6; ++depth) {
+		rel += rel.empty() ? "d" : "/d";
+		fs::create_directory(root / rel);
+		expected.push_back(rel);
+		for (int i = 0; i < 3; ++i) {
+			auto name = rel + "/f" + std::to_string(i);
+			if (auto* fp = fopen((root / name).c_str(), "wb")) {
+				fclose(fp);
+			}
+			expected.push_back(name);
+		}
+	}
+	std::sort(expected.begin(), expected.end());
+
+	fs::DirWalkOptions options;
+	options.num_threads = 8;
+	options.report_dirs = true;
+	for (int pass = 0; pass < 20; ++pass) {
+		auto results = fs::WalkDirectorySorted(root, options);
+		TEST_CHECK(results.size() == expected.size());
+		if (results.size() != expected.size()) {
+			break;
+		}
+		for (size_t i = 0; i < results.size(); ++i) {
+			TEST_CHECK(results[i].rel_path == expected[i]);
+		}
+	}
+	TEST_CHECK(fs::WalkDirectorySorted(root / "missing", options).empty());
+	fs::remove_all(root);
+}
+
+struct AsyncFileIOResults {
+	intmax_t	open, write, fsync, statx, read, missing, close;
+	intmax_t	size;
+	bool		read_matches;
+	int			burst_ok;
+	bool		burst_matches;
+};
+
+static AsyncFileIOResults run_async_file_io(AsyncFileIO& aio, const std::string& path) {
+	static constexpr int kBlockSize  = 1024;
+	static constexpr int kBlockCount = 64;
+
+	AsyncFileIOResults res = {};
+	std::vector<char> data(kBlockSize * kBlockCount);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = char(i * 7 + i / kBlockSize);
+	}
+
+	CStatInfo st = {};
+	int fd  = (int)(res.open = aio.open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644).get());
+	res.write	= aio.pwrite(fd, data.data(), data.size(), 0).get();
+	res.fsync	= aio.fsync(fd, false).get();
+	res.statx	= aio.statx(path.c_str(), &st).get();
+	res.size	= st.st_size;
+	res.missing	= aio.statx((path + ".missing").c_str(), &st).get();
+
+	std::vector<char> readback(data.size());
+	res.read = aio.pread(fd, readback.data(), readback.size(), 0).get();
+	res.read_matches = (readback == data);
+
+	// more reads in flight than the queue depth, so that submission must wait on completions.
+	std::vector<char> burst(data.size());
+	std::atomic<int> burstOk = 0;
+	for (int i = 0; i < kBlockCount; ++i) {
+		aio.pread(fd, burst.data() + i * kBlockSize, kBlockSize, i * kBlockSize, [&](intmax_t result) {
+			burstOk += (result == kBlockSize);
+		});
+	}
+	aio.wait_idle();
+	res.burst_ok = burstOk;
+	res.burst_matches = (burst == data);
+
+	res.close = aio.close(fd).get();
+	remove(path.c_str());
+	return res;
+}
+
+static void test_async_file_io() {
+	AsyncFileIOOptions options;
+	options.queue_depth = 8;
+	options.fallback_threads = 2;
+
+	options.force_fallback = true;
+	AsyncFileIO fallback(options);
+	TEST_CHECK(!fallback.using_io_uring());
+	auto expect = run_async_file_io(fallback, test_tmp_path("aio.fallback"));
+
+	TEST_CHECK(expect.open >= 0);
+	TEST_CHECK(expect.write == 64 * 1024);
+	TEST_CHECK(expect.fsync == 0);
+	TEST_CHECK(expect.statx == 0 && expect.size == 64 * 1024);
+	TEST_CHECK(expect.missing == -ENOENT);
+	TEST_CHECK(expect.read == 64 * 1024 && expect.read_matches);
+	TEST_CHECK(expect.burst_ok == 64 && expect.burst_matches);
+	TEST_CHECK(expect.close == 0);
+
+	// the default backend (io_uring where available) must produce identical results.
+	options.force_fallback = false;
+	AsyncFileIO native(options);
+	auto got = run_async_file_io(native, test_tmp_path("aio.native"));
+
+	TEST_CHECK((got.open >= 0) == (expect.open >= 0));
+	TEST_CHECK(got.write == expect.write);
+	TEST_CHECK(got.fsync == expect.fsync);
+	TEST_CHECK(got.statx == expect.statx && got.size == expect.size);
+	TEST_CHECK(got.missing == expect.missing);
+	TEST_CHECK(got.read == expect.read && got.read_matches);
+	TEST_CHECK(got.burst_ok == expect.burst_ok && got.burst_matches);
+	TEST_CHECK(got.close == expect.close);
+}
+
+static std::string vfs_read(VirtualFileSystem& vfs, const fs::path& path) {
+	auto stream = vfs.Open(path);
+	if (!stream) {
+		return "<missing>";
+	}
+	std::string text(stream->size(), 0);
+	text.resize(stream->read({ (uint8_t*)text.data(), text.size() }));
+	return text;
+}
+
+static void test_vfs_resolve() {
+	auto low  = std::make_shared<BlobFileSystem>();
+	auto high = std::make_shared<BlobFileSystem>();
+	auto deep = std::make_shared<BlobFileSystem>();
+	auto late = std::make_shared<BlobFileSystem>();
+	auto wall = std::make_shared<BlobFileSystem>();
+	low->AddFile("a.txt",			std::string("low"));
+	low->AddFile("only_low.txt",	std::string("low"));
+	low->AddFile("sub/a.txt",		std::string("low"));
+	low->AddFile("sub/b.txt",		std::string("low"));
+	low->AddFile("hidden/x.txt",	std::string("low"));
+	high->AddFile("a.txt",			std::string("high"));
+	deep->AddFile("a.txt",			std::string("deep"));
+	late->AddFile("b.txt",			std::string("late"));
+
+	VirtualFileSystem vfs;
+	vfs.SetFallback(nullptr);
+	vfs.Mount("rom:",			low);
+	vfs.Mount("rom:",			high, {}, { .priority = 10 });
+	vfs.Mount("rom:/sub",		deep);
+	vfs.Mount("rom:/sub",		late);
+	vfs.Mount("rom:/hidden",	wall, {}, { .exclusive = true });
+
+	// priority first, then deepest mount point, then most recently mounted.
+	TEST_CHECK(vfs_read(vfs, "rom:/a.txt")			== "high");
+	TEST_CHECK(vfs_read(vfs, "rom:/only_low.txt")	== "low");
+	TEST_CHECK(vfs_read(vfs, "rom:/sub/a.txt")		== "deep");
+	TEST_CHECK(vfs_read(vfs, "rom:/sub/b.txt")		== "late");
+
+	std::shared_ptr<FileSystemInterface> backend;
+	fs::path backendPath;
+	TEST_CHECK(vfs.Resolve("rom:/sub/a.txt", backend, backendPath) && backend == deep && backendPath == "a.txt");
+	TEST_CHECK(vfs.Resolve("rom:/only_low.txt", backend, backendPath) && backend == low);
+
+	// an exclusive mount hides the mounts beneath it, even where it lacks the file.
+	TEST_CHECK(!vfs.Exists("rom:/hidden/x.txt"));
+	TEST_CHECK(vfs_read(vfs, "rom:/hidden/x.txt") == "<missing>");
+	TEST_CHECK(!vfs.Resolve("rom:/hidden/x.txt", backend, backendPath));
+
+	// '..' is clamped at the mount point, and never escapes to the fallback.
+	TEST_CHECK(vfs_read(vfs, "rom:/../a.txt")				== "high");
+	TEST_CHECK(vfs_read(vfs, "rom:/../../only_low.txt")		== "low");
+	TEST_CHECK(vfs_read(vfs, "rom:/sub/../a.txt")			== "high");
+	TEST_CHECK(vfs_read(vfs, "rom:/sub/../../sub/a.txt")	== "deep");
+	TEST_CHECK(vfs_read(vfs, "rom:/hidden/../only_low.txt")	== "low");
+	TEST_CHECK(vfs.Resolve("rom:/sub/../../../a.txt", backend, backendPath) && backend == high && backendPath == "a.txt");
+
+	auto hostDir = fs::path(test_tmp_path("vfs"));
+	fs::remove_all(hostDir);
+	fs::create_directory(hostDir);
+	if (auto* fp = fopen((hostDir / "host.txt").c_str(), "wb")) {
+		fputs("host", fp);
+		fclose(fp);
+	}
+	vfs.MountHostDirectory("game:", fs::absolute(hostDir));
+	TEST_CHECK(vfs_read(vfs, "game:/host.txt")				== "host");
+	TEST_CHECK(vfs_read(vfs, "game:/../host.txt")			== "host");
+	TEST_CHECK(vfs_read(vfs, "game:/../../" + hostDir.filename() + "/host.txt") == "<missing>");
+	fs::remove_all(hostDir);
+}
+
+static std::string test_read_file(const std::string& path) {
+	std::string image;
+	if (auto* fp = fopen(path.c_str(), "rb")) {
+		char buf[4096];
+		while (auto len = fread(buf, 1, sizeof(buf), fp)) {
+			image.append(buf, len);
+		}
+		fclose(fp);
+	}
+	return image;
+}
+
+static void test_write_file(const std::string& path, const std::string& image) {
+	if (auto* fp = fopen(path.c_str(), "wb")) {
+		fwrite(image.data(), 1, image.size(), fp);
+		fclose(fp);
+	}
+}
+
+static void test_pack_archive() {
+	std::string binary;
+	for (int i = 0; i < 5000; ++i) {
+		binary += char(i * 31);
+	}
+
+	auto path = test_tmp_path("pack");
+	PackBuilder builder;
+	builder.addFile("textures/Sky.png",	binary);
+	builder.addFile("readme.txt",		"hello pack");
+	builder.addFile("empty.bin",		"");
+	builder.addFile("a/b/c.txt",		"nested");
+	TEST_CHECK(builder.write(path));
+
+	{
+		PackArchive pack;
+		TEST_CHECK(pack.open(path));
+		TEST_CHECK(pack.entries().size() == 4);
+
+		auto* sky = pack.find("textures/Sky.png");
+		TEST_CHECK(sky && pack.name(*sky) == "textures/Sky.png");
+		TEST_CHECK(pack.find("TEXTURES/sky.PNG") == sky);
+		TEST_CHECK(pack.find("Textures/Sky.png") == sky);
+		TEST_CHECK(!pack.find("textures/sky.jpg"));
+		TEST_CHECK(!pack.find("textures"));
+
+		if (sky) {
+			auto view = pack.view(*sky);
+			TEST_CHECK(std::string_view((const char*)view.data(), view.size()) == binary);
+			TEST_CHECK((uintptr_t(view.data()) % kPackAlignment) == 0);
+		}
+		if (auto* readme = pack.find("README.TXT")) {
+			auto view = pack.view(*readme);
+			TEST_CHECK(std::string_view((const char*)view.data(), view.size()) == "hello pack");
+		}
+		else {
+			TEST_CHECK(!"README.TXT not found");
+		}
+		auto* empty = pack.find("empty.bin");
+		TEST_CHECK(empty && pack.view(*empty).empty());
+		TEST_CHECK(pack.find("a/b/c.txt") && pack.Exists("a/b") && pack.Stat("a").IsDir());
+
+		TEST_CHECK(pack.verify_all());
+	}
+
+	auto image = test_read_file(path);
+	PackHeader header = {};
+	TEST_CHECK(image.size() >= sizeof(header));
+	if (image.size() < sizeof(header)) {
+		remove(path.c_str());
+		return;
+	}
+	memcpy(&header, image.data(), sizeof(header));
+
+	// a damaged payload is caught by verify, not by open (which only verifies the index).
+	{
+		auto damaged = image;
+		auto* sky = (const PackEntry*)nullptr;
+		PackArchive pack;
+		if (pack.open(path)) {
+			sky = pack.find("textures/Sky.png");
+		}
+		TEST_CHECK(sky);
+		if (sky) {
+			damaged[sky->offset + 100] ^= 0x01;
+		}
+		pack.close();
+		test_write_file(path, damaged);
+
+		TEST_CHECK(pack.open(path));
+		TEST_CHECK(!pack.verify_all());
+		pack.close();
+		TEST_CHECK(!pack.open(path, { .verify_payloads = true }));
+	}
+
+	// a truncated archive is rejected.
+	test_write_file(path, image.substr(0, image.size() - 1));
+	TEST_CHECK(!PackArchive().open(path));
+	test_write_file(path, image.substr(0, header.index_offset));
+	TEST_CHECK(!PackArchive().open(path));
+
+	// a flipped byte in the index, or in the names, fails the index checksum.
+	{
+		auto damaged = image;
+		damaged[header.index_offset + sizeof(PackEntry) + 8] ^= 0x10;
+		test_write_file(path, damaged);
+		TEST_CHECK(!PackArchive().open(path));
+
+		damaged = image;
+		damaged[header.names_offset] ^= 0x20;
+		test_write_file(path, damaged);
+		TEST_CHECK(!PackArchive().open(path));
+	}
+
+	// and the undamaged image still opens.
+	test_write_file(path, image);
+	TEST_CHECK(PackArchive().open(path));
+	remove(path.c_str());
+}
+
+static void test_settings_concurrent() {
+	using namespace icyAppSettingsIfc;
+
+	// readers must only ever see complete values, and both keys of one update together, while the writer
+	// replaces snapshots (and reclaims old ones) underneath them.
+	static constexpr int kUpdates = 2000;
+	auto valueFor = [](int i) { return std::string(i % 50 + 1, char('a' + i % 26)); };
+
+	appUpdateSettings([&] {
+		appSetSetting("--test.conc.a", valueFor(0));
+		appSetSetting("--test.conc.b", "0");
+	});
+
+	std::atomic<bool> done = false;
+	std::atomic<int> badReads = 0;
+	std::atomic<int> reads = 0;
+	auto reader = [&] {
+		int lastSeen = 0;
+		while (!done) {
+			SettingsReadGuard guard;
+			auto a = guard.get("--test.conc.a");
+			auto b = guard.get("--test.conc.b");
+			int i = atoi(std::string(b).c_str());
+			if (a != valueFor(i) || i < lastSeen) {
+				++badReads;
+			}
+			lastSeen = i;
+			++reads;
+		}
+	};
+
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; ++t) {
+		readers.emplace_back(reader);
+	}
+	for (int i = 1; i <= kUpdates; ++i) {
+		appUpdateSettings([&] {
+			appSetSetting("--test.conc.a", valueFor(i));
+			appSetSetting("--test.conc.b", std::to_string(i));
+		});
+	}
+	done = true;
+	for (auto& thread : readers) {
+		thread.join();
+	}
+
+	TEST_CHECK(badReads == 0);
+	TEST_CHECK(reads > 0);
+	TEST_CHECK(appGetSettingConcurrent("--test.conc.a") == valueFor(kUpdates));
+	TEST_CHECK(appGetSettingConcurrent("--test.conc.b") == std::to_string(kUpdates));
+
+	appUpdateSettings([&] {
+		appRemoveSetting("--test.conc.a");
+		appRemoveSetting("--test.conc.b");
+	});
+	TEST_CHECK(!appHasSettingConcurrent("--test.conc.a"));
+}
+
+static void test_settings_query() {
+	using namespace icyAppSettingsIfc;
+
+	appSetSetting("--qry.cache.size",		"30");
+	appSetSetting("--qry.cache.disk.path",	"/tmp");
+	appSetSetting("--qry.cache.disk.size",	"1");
+	appSetSetting("--qry.cachex",			"x");
+	appSetSetting("--qry.net.port",			"80");
+
+	auto collect = [](auto&& query) {
+		std::string keys;
+		query([&](std::string_view key, std::string_view value) {
+			keys += std::string(key) + "=" + std::string(value) + ";";
+		});
+		return keys;
+	};
+	auto withPrefix = [&](std::string_view prefix) {
+		return collect([&](auto const& func) { appForEachSettingWithPrefix(prefix, func); });
+	};
+	auto matching = [&](std::string_view pattern) {
+		return collect([&](auto const& func) { appForEachSettingMatching(CompiledSettingsGlob(pattern), func); });
+	};
+
+	// keys are visited in segment order, parents before children. The last segment of a prefix is partial.
+	TEST_CHECK(withPrefix("--qry.cache")	== "--qry.cache.disk.path=/tmp;--qry.cache.disk.size=1;--qry.cache.size=30;--qry.cachex=x;");
+	TEST_CHECK(withPrefix("--qry.cache.")	== "--qry.cache.disk.path=/tmp;--qry.cache.disk.size=1;--qry.cache.size=30;");
+	TEST_CHECK(withPrefix("--qry.n")		== "--qry.net.port=80;");
+	TEST_CHECK(withPrefix("--qry.none")		== "");
+
+	CompiledSettingsGlob glob("--qry.*.size");
+	TEST_CHECK(glob.literal_prefix() == "--qry." && !glob.is_literal());
+	TEST_CHECK(glob.matches("--qry.cache.size") && !glob.matches("--qry.cachex"));
+	// globMatch does not backtrack: '*' stops at the first occurrence of the character which follows it.
+	TEST_CHECK(matching("--qry.*.size")				== "--qry.cache.size=30;");
+	TEST_CHECK(matching("--qry.cache.*.size")		== "--qry.cache.disk.size=1;");
+	TEST_CHECK(matching("--qry.cache.d?sk.*")		== "--qry.cache.disk.path=/tmp;--qry.cache.disk.size=1;");
+	TEST_CHECK(matching("--qry.net.port")			== "--qry.net.port=80;");
+	TEST_CHECK(matching("--qry.net.missing")		== "");
+
+	std::string children;
+	appForEachSettingChild("--qry", [&](std::string_view segment, bool isSetting) {
+		children += std::string(segment) + (isSetting ? "*;" : ";");
+	});
+	TEST_CHECK(children == "cache;cachex*;net;");
+
+	// erased keys are unindexed, along with parents which no longer lead to any setting.
+	appRemoveSetting("--qry.cache.disk.path");
+	appRemoveSetting("--qry.cache.disk.size");
+	TEST_CHECK(withPrefix("--qry.cache.")		== "--qry.cache.size=30;");
+	TEST_CHECK(matching("--qry.cache.*.size")	== "");
+	children.clear();
+	appForEachSettingChild("--qry.cache", [&](std::string_view segment, bool isSetting) {
+		children += std::string(segment) + (isSetting ? "*;" : ";");
+	});
+	TEST_CHECK(children == "size*;");
+
+	appRemoveSetting("--qry.cache.size");
+	appRemoveSetting("--qry.cachex");
+	appRemoveSetting("--qry.net.port");
+	TEST_CHECK(withPrefix("--qry") == "");
+	children.clear();
+	appForEachSettingChild("", [&](std::string_view segment, bool) {
+		if (segment == "--qry") {
+			children = "found";
+		}
+	});
+	TEST_CHECK(children.empty());
+}
+
+static void test_settings_environment() {
+#if PLATFORM_POSIX
+	using namespace icyAppSettingsIfc;
+
+	setenv("ICYTEST_FOO_BAR",		"1",		1);
+	setenv("ICYTEST_CACHE__SIZE",	"30mib",	1);
+	setenv("ICYTEST_EMPTY",			"",			1);
+	setenv("ICYTEST",				"bare",		1);		// the prefix alone names nothing, and is skipped
+	EnvironSnapshotRefresh();
+
+	std::string_view value;
+	TEST_CHECK(EnvironSnapshotGet("ICYTEST_FOO_BAR") && EnvironSnapshotGet("ICYTEST_FOO_BAR") == std::string_view("1"));
+	TEST_CHECK(EnvironSnapshotLookup("ICYTEST_EMPTY", value) && value.empty());
+	TEST_CHECK(!EnvironSnapshotGet("ICYTEST_MISSING"));
+
+	// the snapshot does not observe changes until refreshed.
+	setenv("ICYTEST_LATE", "late", 1);
+	TEST_CHECK(!EnvironSnapshotGet("ICYTEST_LATE"));
+	EnvironSnapshotRefresh();
+	TEST_CHECK(EnvironSnapshotGet("ICYTEST_LATE") && EnvironSnapshotGet("ICYTEST_LATE") == std::string_view("late"));
+
+	TEST_CHECK(appImportSettingsFromEnvironment("ICYTEST_") == 4);
+	TEST_CHECK(appGetSetting("--foo-bar")		== "1");
+	TEST_CHECK(appGetSetting("--cache.size")	== "30mib");
+	TEST_CHECK(appGetSetting("--late")			== "late");
+	TEST_CHECK(appHasSetting("--empty") && appGetSetting("--empty").empty());
+	TEST_CHECK(appGetSettingProvenance("--foo-bar") == SettingsLayer::Environment);
+
+	// the environment overrides config files, and is overridden by the command line.
+	appSetSettingLayer(SettingsLayer::ConfigFile, "--foo-bar", "cfg");
+	TEST_CHECK(appGetSetting("--foo-bar") == "1");
+	appSetSettingLayer(SettingsLayer::CommandLine, "--foo-bar", "cli");
+	TEST_CHECK(appGetSetting("--foo-bar") == "cli");
+	TEST_CHECK(appGetSettingProvenance("--foo-bar") == SettingsLayer::CommandLine);
+	appRemoveSettingLayer(SettingsLayer::CommandLine, "--foo-bar");
+	TEST_CHECK(appGetSetting("--foo-bar") == "1");
+	appRemoveSettingLayer(SettingsLayer::Environment, "--foo-bar");
+	TEST_CHECK(appGetSetting("--foo-bar") == "cfg");
+
+	for (auto* name : { "--foo-bar", "--cache.size", "--late", "--empty" }) {
+		appRemoveSetting(name);
+	}
+	for (auto* name : { "ICYTEST_FOO_BAR", "ICYTEST_CACHE__SIZE", "ICYTEST_EMPTY", "ICYTEST", "ICYTEST_LATE" }) {
+		unsetenv(name);
+	}
+	EnvironSnapshotRefresh();
+	TEST_CHECK(appImportSettingsFromEnvironment("ICYTEST_") == 0);
+#endif
+}
+
+static void test_path_hash() {
+	// spellings which compare equal must hash equal, however the path was built.
+	fs::path ref("dir/sub/file.txt");
+	fs::path appended("DIR");
+	appended /= "Sub";
+	appended /= "FILE.TXT";
+	for (auto& same : { fs::path("Dir/Sub/File.TXT"), fs::path("dir/sub/file.txt/"), fs::path("dir\\sub\\file.txt"),
+		fs::path("dir//sub/./file.txt").lexically_normal(), fs::path("dir/sub/file") + ".TXT", appended,
+		fs::path("dir/sub/file.png").replace_extension(".txt") })
+	{
+		TEST_CHECK(same == ref);
+		TEST_CHECK(same.hash() == ref.hash());
+		TEST_CHECK(fs::path_hash{}(same) == std::hash<fs::path>{}(ref));
+		TEST_CHECK(fs::path_equal{}(same, ref));
+	}
+	TEST_CHECK(ref == "DIR/SUB/FILE.TXT");
+	TEST_CHECK(fs::PathHash("DIR/SUB/FILE.TXT") == ref.hash());
+	TEST_CHECK(fs::PathHash("file.txt", fs::PathHash("dir/sub/")) == ref.hash());
+
+	for (auto& other : { fs::path("dir/sub/file.txu"), fs::path("dir/sub/file"), fs::path("dir/sub"),
+		fs::path("dir/sub/file.txt.bak"), fs::path("dir/su/bfile.txt"), fs::path("/dir/sub/file.txt") })
+	{
+		TEST_CHECK(!(other == ref));
+		TEST_CHECK(other.hash() != ref.hash());
+		TEST_CHECK(!fs::path_equal{}(other, ref));
+	}
+
+	std::unordered_map<fs::path, int, fs::path_hash, fs::path_equal> map;
+	map[ref] = 1;
+	map[fs::path("dir/sub/other.txt")] = 2;
+	TEST_CHECK(map.size() == 2);
+	TEST_CHECK(map.count(fs::path("DIR/sub/FILE.txt")) && map[fs::path("DIR/sub/FILE.txt")] == 1);
+	map[fs::path("Dir/Sub/File.txt")] = 3;
+	TEST_CHECK(map.size() == 2 && map[ref] == 3);
+	TEST_CHECK(!map.count(fs::path("dir/sub/file.tx")));
+}
+
+static void test_dir_enumerator() {
+	// more entries than one batch buffer holds, so that names and types are parsed across several refills.
+	static constexpr int kFiles = 300;
+	auto root = fs::path(test_tmp_path("dirent"));
+	fs::remove_all(root);
+	fs::create_directory(root);
+	for (int i = 0; i < kFiles; ++i) {
+		if (auto* fp = fopen((root / ("file_" + std::to_string(i) + ".txt")).c_str(), "wb")) {
+			fclose(fp);
+		}
+	}
+	fs::create_directory(root / "subdir");
+#if PLATFORM_POSIX
+	TEST_CHECK(symlink("file_0.txt", (root / "link").c_str()) == 0);
+#endif
+
+	fs::DirEnumerator dir(2048);
+	TEST_CHECK(dir.open(root));
+
+	std::vector<fs::DirEntry> batch;
+	std::unordered_map<std::string, fs::DirEntryType> seen;
+	int batches = 0;
+	int files = 0;
+	for (int count; (count = dir.next_batch(batch)) > 0; ) {
+		++batches;
+		TEST_CHECK(count == (int)batch.size());
+		for (auto& ent : batch) {
+			TEST_CHECK(ent.name != "." && ent.name != "..");
+			TEST_CHECK(ent.name.data()[ent.name.size()] == 0);
+			TEST_CHECK(seen.emplace(std::string(ent.name), dir.resolve_type(ent)).second);
+
+			// the type resolved by stat agrees with the type reported by the listing.
+			fs::DirEntry unknown = { ent.name, fs::DirEntryType::Unknown, 0 };
+			auto resolved = dir.resolve_type(unknown);
+			TEST_CHECK(ent.type == fs::DirEntryType::Unknown || PLATFORM_LINUX == 0 || resolved == ent.type);
+			files += StringUtil::BeginsWith(std::string(ent.name), "file_");
+		}
+	}
+	TEST_CHECK(dir.error() == 0);
+	TEST_CHECK(batches > 1);
+	TEST_CHECK(files == kFiles);
+	TEST_CHECK(seen.size() == kFiles + 1 + PLATFORM_POSIX);
+	TEST_CHECK(seen["file_0.txt"]	== fs::DirEntryType::File);
+	TEST_CHECK(seen["subdir"]		== fs::DirEntryType::Directory);
+#if PLATFORM_POSIX
+	TEST_CHECK(seen["link"]			== fs::DirEntryType::Symlink);
+#endif
+
+	// reopening rewinds, and next() sees the same entries as the batches.
+	TEST_CHECK(dir.open(root));
+	TEST_CHECK(dir.forEach([](const fs::DirEntry&) {}) == (intmax_t)seen.size());
+	TEST_CHECK(fs::EnumerateDirectory(root / "subdir", [](const fs::DirEntry&) { return true; }) == 0);
+	TEST_CHECK(fs::EnumerateDirectory(root / "missing", [](const fs::DirEntry&) { return true; }) == -1);
+	TEST_CHECK(!dir.open(root / "missing") && dir.error() != 0);
+
+	fs::remove_all(root);
+}
+
+// polls cond for up to two seconds, for results which depend on asynchronous change notifications.
+template<typename Cond>
+static bool test_wait_for(Cond&& cond) {
+	for (int i = 0; i < 2000; ++i) {
+		if (cond()) {
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return cond();
+}
+
+static void test_caching_filesystem() {
+	// manual invalidation over a MemoryFileSystem, whose counters show which queries reach the backend.
+	{
+		MemoryFileSystem memfs;
+		memfs.WriteFile("/m/a.txt", "one");
+		memfs.WriteFile("/m/b.txt", "two");
+
+		CachingFileSystem cache(&memfs, 4, CacheInvalidation::Manual);
+		TEST_CHECK(cache.IsCaching());
+		TEST_CHECK(cache.Stat("/m/a.txt").st_size == 3);
+		TEST_CHECK(cache.Stat("/m/./a.txt").st_size == 3);
+		auto stats = cache.GetCacheStats();
+		TEST_CHECK(stats.misses == 1 && stats.hits == 1 && stats.entries == 1);
+		TEST_CHECK(memfs.GetCounters()[MemFsOp::Stat].calls == 1);
+
+		// results are kept until invalidated.
+		memfs.WriteFile("/m/a.txt", "three");
+		TEST_CHECK(cache.Stat("/m/a.txt").st_size == 3);
+		cache.Invalidate("/m/a.txt");
+		TEST_CHECK(cache.Stat("/m/a.txt").st_size == 5);
+		TEST_CHECK(memfs.GetCounters()[MemFsOp::Stat].calls == 2);
+
+		std::vector<std::string> names;
+		cache.VisitDirectoryContents([&](const fs::path& item) { names.push_back(item.filename()); }, "/m");
+		memfs.WriteFile("/m/c.txt", "");
+		cache.VisitDirectoryContents([&](const fs::path& item) { names.push_back(item.filename()); }, "/m");
+		TEST_CHECK(names.size() == 4);
+		cache.InvalidateAll();
+		TEST_CHECK(cache.GetCacheStats().entries == 0);
+		names.clear();
+		cache.VisitDirectoryContents([&](const fs::path& item) { names.push_back(item.filename()); }, "/m");
+		TEST_CHECK(names.size() == 3);
+
+		// LRU eviction at maxEntries: the least recently used entry goes first.
+		cache.InvalidateAll();
+		memfs.ResetCounters();
+		for (auto* path : { "/m/a.txt", "/m/b.txt", "/m/c.txt", "/m/d.txt", "/m/a.txt", "/m/e.txt", "/m/f.txt" }) {
+			cache.Exists(path);
+		}
+		stats = cache.GetCacheStats();
+		TEST_CHECK(stats.entries == 4 && stats.evictions == 2);
+		TEST_CHECK(memfs.GetCounters()[MemFsOp::Exists].calls == 6);
+		cache.Exists("/m/a.txt");		// recently used, still cached
+		TEST_CHECK(memfs.GetCounters()[MemFsOp::Exists].calls == 6);
+		cache.Exists("/m/b.txt");		// evicted
+		TEST_CHECK(memfs.GetCounters()[MemFsOp::Exists].calls == 7);
+	}
+
+#if PLATFORM_LINUX
+	// inotify invalidation against the host filesystem.
+	auto root = fs::path(test_tmp_path("cachefs"));
+	fs::remove_all(root);
+	fs::create_directory(root);
+	auto file = root / "a.txt";
+	test_write_file(file, "one");
+
+	CachingFileSystem cache;
+	TEST_CHECK(cache.IsCaching());
+	TEST_CHECK(cache.Stat(file).st_size == 3);
+	TEST_CHECK(cache.Stat(file).st_size == 3);
+	TEST_CHECK(cache.GetCacheStats().hits == 1 && cache.GetCacheStats().watches > 0);
+
+	test_write_file(file, "modified");
+	TEST_CHECK(test_wait_for([&] { return cache.Stat(file).st_size == 8; }));
+
+	int listed = 0;
+	cache.VisitDirectoryContents([&](const fs::path&) { ++listed; }, root);
+	test_write_file(root / "b.txt", "");
+	TEST_CHECK(test_wait_for([&] {
+		listed = 0;
+		cache.VisitDirectoryContents([&](const fs::path&) { ++listed; }, root);
+		return listed == 2;
+	}));
+
+	TEST_CHECK(cache.Exists(file));
+	remove(file.c_str());
+	TEST_CHECK(test_wait_for([&] { return !cache.Exists(file); }));
+	TEST_CHECK(cache.GetCacheStats().invalidations >= 3);
+
+	fs::remove_all(root);
+#endif
+}
+
+static void test_posix_stat_batch() {
+	auto root = fs::path(test_tmp_path("statbatch"));
+	fs::remove_all(root);
+	fs::create_directory(root);
+
+	// more paths than one chunk per thread, with every third path missing.
+	std::vector<std::string> paths;
+	int expectFound = 0;
+	for (int i = 0; i < 400; ++i) {
+		auto path = (root / ("f" + std::to_string(i))).uni_string();
+		if (i % 3) {
+			test_write_file(path, std::string(i, 'x'));
+			++expectFound;
+		}
+		paths.push_back(path);
+	}
+	paths.push_back(root.uni_string());
+
+	std::vector<const char*> cpaths;
+	for (auto& path : paths) {
+		cpaths.push_back(path.c_str());
+	}
+	for (int threads : { 1, 4, 0 }) {
+		std::vector<CStatInfo> dest(paths.size());
+		TEST_CHECK(posix_stat_batch(cpaths.data(), cpaths.size(), dest.data(), threads) == expectFound + 1);
+		for (size_t i = 0; i < paths.size(); ++i) {
+			auto single = posix_stat(cpaths[i]);
+			TEST_CHECK(dest[i].Exists() == single.Exists());
+			if (single.Exists()) {
+				TEST_CHECK(dest[i] == single);
+			}
+		}
+		TEST_CHECK(dest.back().IsDir() && dest[1].IsFile() && dest[1].st_size == 1);
+	}
+
+#if PLATFORM_POSIX
+	// a file replaced via rename has a new identity, even with identical size and timestamp.
+	auto target = (root / "target").uni_string();
+	auto temp   = (root / "target.new").uni_string();
+	test_write_file(target, "same");
+	CStatModInfo before = posix_stat(target.c_str());
+	TEST_CHECK(before.st_ino != 0 && before.st_dev != 0);
+	TEST_CHECK(before == posix_stat(target.c_str()));
+
+	test_write_file(temp, "same");
+	auto tempStat = posix_stat(temp.c_str());
+	TEST_CHECK(rename(temp.c_str(), target.c_str()) == 0);
+	auto after = posix_stat(target.c_str());
+	TEST_CHECK(after.st_ino == tempStat.st_ino);
+	TEST_CHECK(after.st_ino != before.st_ino);
+	TEST_CHECK(after != before);
+	TEST_CHECK(after.getModificationInfo() != before);
+	TEST_CHECK(after.time_modified_nsec >= 0 && after.time_modified_nsec < 1000000000);
+#endif
+
+	fs::remove_all(root);
+}
+
+static void test_mapped_file() {
+	std::string content;
+	for (int i = 0; i < 3 * 4096 + 123; ++i) {
+		content += char('a' + i % 26);
+	}
+	auto path = test_tmp_path("mapped");
+	test_write_file(path, content);
+
+	// subviews share the mapping, and keep it alive after the handle they came from is closed.
+	MappedFile sub;
+	{
+		MappedFile file(path);
+		TEST_CHECK(file.is_open() && file.size() == content.size());
+		TEST_CHECK(file.view() == content);
+		TEST_CHECK(file.use_count() == 1);
+
+		sub = file.subview(5000, 100);
+		TEST_CHECK(file.use_count() == 2);
+		TEST_CHECK(sub.size() == 100 && sub.view() == std::string_view(content).substr(5000, 100));
+		TEST_CHECK(file.subview(content.size() - 10).size() == 10);
+		TEST_CHECK(file.subview(content.size() + 10).size() == 0);
+		TEST_CHECK(sub.subview(90, 50).view() == std::string_view(content).substr(5090, 10));
+		file.close();
+		TEST_CHECK(!file.is_open());
+	}
+	TEST_CHECK(sub.is_open() && sub.use_count() == 1);
+	TEST_CHECK(sub.view() == std::string_view(content).substr(5000, 100));
+	sub.close();
+
+	// offset and length need not be page aligned.
+	for (auto [offset, length] : { std::pair<size_t, size_t>{ 1, 10 }, { 4095, 2 }, { 4097, 5000 }, { 8191, 0 }, { 12300, 0 } }) {
+		MappedFileOptions options;
+		options.offset = offset;
+		options.length = length;
+		MappedFile part(path, options);
+		auto expect = std::string_view(content).substr(offset, length ? length : std::string_view::npos);
+		TEST_CHECK(part.is_open() && part.view() == expect);
+	}
+
+	// an empty file maps successfully, with no data.
+	test_write_file(path, "");
+	MappedFile empty(path);
+	TEST_CHECK(empty.is_open() && empty.size() == 0 && empty.data() == nullptr);
+	TEST_CHECK(empty.subview(0).size() == 0);
+	empty.close();
+
+	MappedFile missing((path + ".missing").c_str());
+	TEST_CHECK(!missing.is_open() && missing.error() != 0);
+	remove(path.c_str());
+}
+
+static void test_direct_file_reader() {
+	std::string content(1024 * 1024 + 777, 0);
+	for (size_t i = 0; i < content.size(); ++i) {
+		content[i] = char(i * 131 + (i >> 12));
+	}
+	auto path = test_tmp_path("direct");
+	test_write_file(path, content);
+
+	// a small bounce buffer, so that unaligned reads are staged in several pieces.
+	DirectFileReaderOptions options;
+	options.direct_threshold	= 64 * 1024;
+	options.bounce_size			= 16 * 1024;
+	DirectFileReader reader(options);
+	TEST_CHECK(reader.open(path.c_str()));
+	TEST_CHECK(reader.size() == (intmax_t)content.size());
+
+	auto size = content.size();
+	std::vector<uint8_t> dest(256 * 1024 + 16);
+	for (size_t offset : { size_t(0), size_t(1), size_t(511), size_t(4095), size_t(4096), size_t(4097), size_t(100003), size - 5000, size - 1, size, size + 100 }) {
+		for (size_t length : { size_t(1), size_t(100), size_t(4096), size_t(4097), size_t(20000), size_t(200001) }) {
+			for (size_t misalign : { 0, 1, 7 }) {
+				memset(dest.data(), 0xcd, dest.size());
+				auto got = reader.read(dest.data() + misalign, length, offset);
+				auto expect = offset >= size ? 0 : std::min(length, size - offset);
+				TEST_CHECK(got == (intmax_t)expect);
+				if (got == (intmax_t)expect && expect) {
+					TEST_CHECK(memcmp(dest.data() + misalign, content.data() + offset, expect) == 0);
+				}
+				// nothing is written beyond the bytes read.
+				TEST_CHECK(dest[misalign + expect] == 0xcd);
+			}
+		}
+	}
+	reader.close();
+
+	// buffered mode gives the same results.
+	options.direct = false;
+	DirectFileReader buffered(options);
+	TEST_CHECK(buffered.open(path.c_str()) && !buffered.is_direct());
+	TEST_CHECK(buffered.read(dest.data() + 3, 9000, 4093) == 9000 && memcmp(dest.data() + 3, content.data() + 4093, 9000) == 0);
+	remove(path.c_str());
+}
+
+static void test_buffered_file() {
+	auto path = test_tmp_path("buffered");
+
+	// readLine: CRLF and LF endings, an empty line, a line longer than the buffer, and an unterminated last line.
+	std::string longLine(3000, 'L');
+	test_write_file(path, "first\r\nsecond\n\n" + longLine + "\r\n\r\ntail");
+	{
+		BufferedReader reader({ 1024 });
+		TEST_CHECK(reader.open(path));
+		std::vector<std::string> lines;
+		std::string_view line;
+		while (reader.readLine(line)) {
+			TEST_CHECK(line.data()[line.size()] == 0);
+			lines.emplace_back(line);
+		}
+		TEST_CHECK(reader.eof() && reader.error() == 0);
+		TEST_CHECK(lines.size() == 6);
+		if (lines.size() == 6) {
+			TEST_CHECK(lines[0] == "first" && lines[1] == "second" && lines[2].empty());
+			TEST_CHECK(lines[3] == longLine && lines[4].empty() && lines[5] == "tail");
+		}
+	}
+
+	// writer: small writes which fill the buffer, and writes larger than the buffer (a single writev with the
+	// buffered data), in both foreground and background modes, round-tripped through a reader.
+	std::string expect;
+	for (int i = 0; i < 400; ++i) {
+		expect += "line " + std::to_string(i) + "\n";
+		if (i % 97 == 0) {
+			expect += std::string(2500 + i, char('A' + i % 26)) + "\n";
+		}
+	}
+	for (bool background : { false, true }) {
+		BufferedWriter writer({ 1024, background });
+		TEST_CHECK(writer.open(path));
+		size_t pos = 0;
+		while (pos < expect.size()) {
+			auto end = expect.find('\n', pos) + 1;
+			TEST_CHECK(writer.write(std::string_view(expect).substr(pos, end - pos)));
+			pos = end;
+		}
+		TEST_CHECK(writer.close());
+
+		BufferedReader reader({ 1024 });
+		TEST_CHECK(reader.open(path));
+		std::string got;
+		char head[10];
+		TEST_CHECK(reader.read(head, sizeof(head)) == sizeof(head));
+		got.append(head, sizeof(head));
+		std::string_view line;
+		TEST_CHECK(reader.readLine(line));
+		got += std::string(line) + "\n";
+
+		// the rest in one read, which bypasses the buffer.
+		std::string rest(expect.size(), 0);
+		auto len = reader.read(rest.data(), rest.size());
+		TEST_CHECK(len == intmax_t(expect.size() - got.size()));
+		got.append(rest.data(), std::max<intmax_t>(len, 0));
+		TEST_CHECK(got == expect);
+		TEST_CHECK(reader.eof() && !reader.readLine(line));
+	}
+
+#if PLATFORM_POSIX
+	// write errors are sticky.
+	{
+		int fd = open(path.c_str(), O_RDONLY);
+		BufferedWriter writer({ 1024 });
+		writer.attach(fd);
+		TEST_CHECK(writer.write("buffered"));
+		TEST_CHECK(!writer.write(std::string(4096, 'x')));
+		TEST_CHECK(writer.error() == EBADF);
+		TEST_CHECK(!writer.write("more"));
+		TEST_CHECK(!writer.flush());
+		TEST_CHECK(!writer.close());
+		TEST_CHECK(writer.error() == EBADF);
+		::close(fd);
+	}
+	{
+		// reading a directory fails with an error rather than at end of file.
+		BufferedReader reader;
+		TEST_CHECK(reader.open(fs::path(".")));
+		std::string_view line;
+		TEST_CHECK(!reader.readLine(line) && reader.error() != 0);
+	}
+#endif
+
+	BufferedReader missing;
+	TEST_CHECK(!missing.open(path + ".missing") && missing.error() == ENOENT);
+	remove(path.c_str());
+}
+
+static void test_input_stream() {
+	auto asString = [](std::span<const uint8_t> span) { return std::string((const char*)span.data(), span.size()); };
+
+	// memory stream: the window is the whole stream, so every edge is a window edge.
+	{
+		fs::MemoryStream stream("0123456789");
+		uint8_t buf[16];
+		TEST_CHECK(stream.size() == 10);
+		TEST_CHECK(stream.read({ buf, 3 }) == 3 && std::string((char*)buf, 3) == "012" && stream.tell() == 3);
+		TEST_CHECK(asString(stream.peek(7)) == "3456789");
+		TEST_CHECK(asString(stream.peek(20)) == "3456789");
+		TEST_CHECK(stream.tell() == 3);
+		TEST_CHECK(stream.skip(5) == 5 && stream.tell() == 8);
+
+		uint16_t u16 = 0;
+		TEST_CHECK(stream.read(u16) && memcmp(&u16, "89", 2) == 0);
+		TEST_CHECK(stream.eof() && stream.peek(1).empty() && stream.skip(1) == 0);
+		TEST_CHECK(stream.read({ buf, 1 }) == 0);
+
+		TEST_CHECK(stream.seek(0) && stream.tell() == 0);
+		TEST_CHECK(stream.seek(10) && stream.eof());
+		TEST_CHECK(!stream.seek(11) && !stream.seek(-1));
+		TEST_CHECK(stream.seek(7));
+		uint32_t u32 = 0;
+		TEST_CHECK(!stream.read(u32));		// three bytes remain: fails, and consumes them
+		TEST_CHECK(stream.tell() == 10);
+		TEST_CHECK(stream.seek(8) && stream.skip(5) == 2);
+	}
+
+	std::string content;
+	for (int i = 0; i < 100000; ++i) {
+		content += char(i * 7 + (i >> 8));
+	}
+
+#if PLATFORM_POSIX
+	// fd stream over a pipe: not seekable and of unknown size, so everything goes through the buffer.
+	{
+		int fds[2];
+		TEST_CHECK(pipe(fds) == 0);
+		std::thread writer([&] {
+			for (size_t pos = 0; pos < content.size(); ) {
+				auto len = ::write(fds[1], content.data() + pos, std::min<size_t>(3000, content.size() - pos));
+				if (len <= 0) {
+					break;
+				}
+				pos += len;
+			}
+			::close(fds[1]);
+		});
+
+		fs::FdStream stream(4096);
+		stream.attach(fds[0], true);
+		TEST_CHECK(stream.size() == -1);
+		std::string got(content.size() + 10, 0);
+		TEST_CHECK(stream.read({ (uint8_t*)got.data(), 100 }) == 100);
+		TEST_CHECK(asString(stream.peek(10000)) == content.substr(100, 10000));		// larger than the buffer
+		TEST_CHECK(stream.skip(10000) == 10000 && stream.tell() == 10100);
+		TEST_CHECK(!stream.seek(0));
+		auto len = stream.read({ (uint8_t*)got.data() + 10100, got.size() - 10100 });
+		TEST_CHECK(len == content.size() - 10100);
+		TEST_CHECK(got.compare(10100, len, content, 10100, len) == 0);
+		uint64_t u64;
+		TEST_CHECK(!stream.read(u64) && stream.eof());
+		writer.join();
+	}
+#endif
+
+	// fd stream over a regular file.
+	{
+		auto path = test_tmp_path("stream");
+		test_write_file(path, content);
+		fs::FdStream stream(fs::path(path), 4096);
+		TEST_CHECK(stream.is_open() && stream.size() == (intmax_t)content.size());
+		TEST_CHECK(asString(stream.peek(10)) == content.substr(0, 10));
+		TEST_CHECK(asString(stream.peek(10000)) == content.substr(0, 10000));
+		stream.consume(5000);
+		TEST_CHECK(stream.tell() == 5000);
+
+		// larger than the buffer: bypasses it.
+		std::string big(50000, 0);
+		TEST_CHECK(stream.read({ (uint8_t*)big.data(), big.size() }) == big.size());
+		TEST_CHECK(big == content.substr(5000, 50000) && stream.tell() == 55000);
+
+		TEST_CHECK(stream.seek(3) && stream.tell() == 3);
+		uint32_t u32 = 0;
+		TEST_CHECK(stream.read(u32) && memcmp(&u32, content.data() + 3, 4) == 0);
+		TEST_CHECK(stream.seek(content.size() - 2));
+		TEST_CHECK(!stream.read(u32) && stream.tell() == (intmax_t)content.size() && stream.eof());
+		TEST_CHECK(stream.seek(content.size() - 4) && stream.read(u32) && memcmp(&u32, content.data() + content.size() - 4, 4) == 0);
+		stream.close();
+		remove(path.c_str());
+	}
+}
+
+static void test_memory_filesystem() {
+	MemoryFileSystem memfs;
+
+	// synthetic tree: depth 2 with 2 subdirectories and 3 files per directory holds 3 * (1 + 2 + 4) files.
+	TEST_CHECK(memfs.AddSyntheticTree("/t", 2, 2, 3, 100) == 21);
+	std::function<int(const fs::path&)> countFiles = [&](const fs::path& dir) {
+		int count = 0;
+		memfs.VisitDirectoryContents([&](const fs::path& item) {
+			auto st = memfs.Stat(item);
+			count += st.IsDir() ? countFiles(item) : st.IsFile();
+		}, dir);
+		return count;
+	};
+	TEST_CHECK(countFiles("/t") == 21);
+	TEST_CHECK(memfs.Stat("/t/d1/d0/f2.bin").st_size == 100 && memfs.Stat("t/d1").IsDir());
+	TEST_CHECK(!memfs.Exists("/t/d2") && !memfs.Exists("/t/d0/d0/d0"));
+	if (auto stream = memfs.Open("/t/d0/f1.bin")) {
+		uint8_t head[2];
+		TEST_CHECK(stream->size() == 100 && stream->read({ head, 2 }) == 2 && head[0] == 7 && head[1] == uint8_t(131 + 7));
+	}
+	else {
+		TEST_CHECK(!"synthetic file could not be opened");
+	}
+
+	// counters, and latency accounting.
+	memfs.ResetCounters();
+	memfs.SetOpConfig(MemFsOp::Exists, { .latency = std::chrono::microseconds(2), .spin = true, .fail_every = 3 });
+	std::string pattern;
+	for (int i = 0; i < 9; ++i) {
+		pattern += memfs.Exists("/t/f0.bin") ? '1' : '0';
+	}
+	TEST_CHECK(pattern == "110110110");
+	auto counters = memfs.GetCounters();
+	TEST_CHECK(counters[MemFsOp::Exists].calls == 9 && counters[MemFsOp::Exists].failures == 3);
+	TEST_CHECK(counters[MemFsOp::Exists].latency_ns == 9 * 2000);
+	TEST_CHECK(counters[MemFsOp::Stat].calls == 0 && counters[MemFsOp::Stat].failures == 0);
+	memfs.SetOpConfig(MemFsOp::Exists, {});
+
+	// seeded failure rates are reproducible.
+	auto failures = [&](uint64_t seed) {
+		memfs.SetSeed(seed);
+		memfs.SetOpConfig(MemFsOp::Stat, { .failure_rate = 0.3 });
+		std::string result;
+		for (int i = 0; i < 200; ++i) {
+			result += memfs.Stat("/t/f1.bin").Exists() ? '1' : '0';
+		}
+		memfs.SetOpConfig(MemFsOp::Stat, {});
+		return result;
+	};
+	auto first = failures(42);
+	auto failed = std::count(first.begin(), first.end(), '0');
+	TEST_CHECK(failed > 30 && failed < 90);
+	TEST_CHECK(failures(42) == first);
+	TEST_CHECK(failures(43) != first);
+
+	// the predicate may call back into the filesystem, including writes.
+	memfs.SetFailurePredicate([&](MemFsOp op, const fs::path& path) {
+		if (op != MemFsOp::Open) {
+			return false;
+		}
+		memfs.WriteFile("/log/opened", path.uni_string());
+		return !memfs.Exists(path.parent_path() / "allow");
+	});
+	TEST_CHECK(!memfs.Open("/t/d0/f0.bin"));
+	TEST_CHECK(memfs.Stat("/log/opened").st_size == (intmax_t)strlen("/t/d0/f0.bin"));
+	memfs.WriteFile("/t/d0/allow", "");
+	TEST_CHECK(memfs.Open("/t/d0/f0.bin") != nullptr);
+	TEST_CHECK(memfs.GetCounters()[MemFsOp::Open].failures == 1);
+	memfs.SetFailurePredicate(nullptr);
+	TEST_CHECK(memfs.Open("/t/d1/f0.bin") != nullptr);
+}
+
+static void test_file_watcher_mode(bool polling) {
+	auto root	= test_tmp_path(polling ? "watchpoll" : "watch");
+	auto tree	= root + "/tree";
+	auto cfgDir	= root + "/cfg";
+	auto cfg	= cfgDir + "/settings.cfg";
+	fs::remove_all(root);
+	fs::create_directory(root);
+	fs::create_directory(tree);
+	test_write_file(tree + "/a.txt", "one");
+
+	std::mutex mutex;
+	std::vector<FileChange> changes;
+	FileWatcherOptions options;
+	options.force_polling	= polling;
+	options.poll_interval	= std::chrono::milliseconds(20);
+
+	FileWatcher watcher([&](std::span<const FileChange> batch) {
+		std::lock_guard lock(mutex);
+		changes.insert(changes.end(), batch.begin(), batch.end());
+	}, options);
+
+	// waits for a change of the given kind to path, and discards it along with everything reported before it.
+	auto expect = [&](const std::string& path, FileChangeKind kind, FileChange* found = nullptr) {
+		return test_wait_for([&] {
+			std::lock_guard lock(mutex);
+			auto it = std::find_if(changes.begin(), changes.end(), [&](const FileChange& change) {
+				return change.path == fs::path(path) && change.kind == kind;
+			});
+			if (it == changes.end()) {
+				return false;
+			}
+			if (found) {
+				*found = *it;
+			}
+			changes.erase(changes.begin(), it + 1);
+			return true;
+		});
+	};
+
+#if PLATFORM_LINUX
+	TEST_CHECK(watcher.IsPolling() == polling);
+#endif
+	TEST_CHECK(watcher.WatchTree(tree) >= 0);
+	TEST_CHECK(watcher.WatchFile(cfg) >= 0);		// its dir does not exist yet
+	TEST_CHECK(watcher.WatchTree(tree + "/a.txt") == -1);
+	TEST_CHECK(watcher.TrackedFiles() == 2);
+
+	// create, modify, remove.
+	test_write_file(tree + "/b.txt", "two");
+	TEST_CHECK(expect(tree + "/b.txt", FileChangeKind::Created));
+	test_write_file(tree + "/a.txt", "modified");
+	TEST_CHECK(expect(tree + "/a.txt", FileChangeKind::Modified));
+	remove((tree + "/b.txt").c_str());
+	TEST_CHECK(expect(tree + "/b.txt", FileChangeKind::Removed));
+
+	// replaced via rename, with the same size: only the inode differs.
+	FileChange change;
+	test_write_file(tree + "/a.tmp", "MODIFIED");
+	TEST_CHECK(rename((tree + "/a.tmp").c_str(), (tree + "/a.txt").c_str()) == 0);
+	TEST_CHECK(expect(tree + "/a.txt", FileChangeKind::Modified, &change));
+	TEST_CHECK(change.old_info.st_size == 8 && change.new_info.st_size == 8);
+	TEST_CHECK(change.old_info.st_ino != change.new_info.st_ino);
+
+	// new subdirectories are covered, and stop being covered once moved out of the tree.
+	fs::create_directory(tree + "/sub");
+	test_write_file(tree + "/sub/c.txt", "three");
+	TEST_CHECK(expect(tree + "/sub/c.txt", FileChangeKind::Created));
+	TEST_CHECK(rename((tree + "/sub").c_str(), (root + "/moved").c_str()) == 0);
+	TEST_CHECK(expect(tree + "/sub/c.txt", FileChangeKind::Removed));
+	test_write_file(root + "/moved/c.txt", "changed after the move");
+	test_write_file(tree + "/a.txt", "marker");
+	TEST_CHECK(expect(tree + "/a.txt", FileChangeKind::Modified));
+	{
+		std::lock_guard lock(mutex);
+		TEST_CHECK(changes.empty());
+	}
+
+	// a watched file whose dir appears after registration.
+	fs::create_directory(cfgDir);
+	test_write_file(cfg, "key=value");
+	TEST_CHECK(expect(cfg, FileChangeKind::Created));
+
+	// removed and recreated dirs: the registrations remain in effect.
+	fs::remove_all(tree);
+	TEST_CHECK(expect(tree + "/a.txt", FileChangeKind::Removed));
+	fs::remove_all(cfgDir);
+	TEST_CHECK(expect(cfg, FileChangeKind::Removed));
+
+	fs::create_directory(tree);
+	test_write_file(tree + "/a.txt", "recreated");
+	TEST_CHECK(expect(tree + "/a.txt", FileChangeKind::Created));
+	fs::create_directory(tree + "/sub");
+	test_write_file(tree + "/sub/d.txt", "four");
+	TEST_CHECK(expect(tree + "/sub/d.txt", FileChangeKind::Created));
+	fs::create_directory(cfgDir);
+	test_write_file(cfg, "key=other");
+	TEST_CHECK(expect(cfg, FileChangeKind::Created));
+
+	// and keep working after being recreated.
+	test_write_file(tree + "/sub/d.txt", "modified");
+	TEST_CHECK(expect(tree + "/sub/d.txt", FileChangeKind::Modified));
+	TEST_CHECK(watcher.TrackedFiles() == 3);
+
+	fs::remove_all(root);
+}
+
+static void test_file_watcher() {
+	test_file_watcher_mode(true);
+#if PLATFORM_LINUX
+	test_file_watcher_mode(false);
+#endif
+}
+
 int main(int argc, char** argv) {
 
+#if PLATFORM_MSW
 	msw_AllocConsoleForWindowedApp();
+#endif
 
     if (argc > 1 && strcasecmp(argv[1], "crashdump") == 0) {
         *((int volatile*)0) = 50;
@@ -123,6 +1676,7 @@ int main(int argc, char** argv) {
 
     printf("TEST:TOKENIZER:SINGLINE\n");
     for(const auto* item : parse_inputs) {
+        if (!item) break;
         auto tok = Tokenizer(item);
         if (auto* lvalue = tok.GetNextToken('=')) {
             printf("%s", lvalue);
@@ -227,8 +1781,121 @@ int main(int argc, char** argv) {
         printf("\n");
     }
 
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:LEXICALLY_NORMAL\n");
+    for(const auto* item : path_abs_inputs) {
+        printf("input  = %s\n", item);
+        printf("normal = %s\n", fs::path(item).lexically_normal().uni_string().c_str());
+        printf("\n");
+    }
+    for(const auto* item : path_rel_inputs) {
+        printf("input  = %s\n", item);
+        printf("normal = %s\n", fs::path(item).lexically_normal().uni_string().c_str());
+        printf("\n");
+    }
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:LEXICALLY_NORMAL_CHECKS\n");
+    test_lexically_normal();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:COMPACTPATH\n");
+    test_compact_path();
+
+    printf("--------------------------------------\n");
+    printf("TEST:SETTINGS:FLATSTRINGMAP\n");
+    test_flat_string_map();
+
+    printf("--------------------------------------\n");
+    printf("TEST:SETTINGS:TYPED\n");
+    test_typed_settings();
+
+    printf("--------------------------------------\n");
+    printf("TEST:CONFIGPARSE:SECTIONS\n");
+    test_config_parse_sections();
+
+    printf("--------------------------------------\n");
+    printf("TEST:SETTINGS:LAYERS\n");
+    test_settings_layers();
+
+    printf("--------------------------------------\n");
+    printf("TEST:SETTINGS:SHARED\n");
+    test_settings_shared();
+
+    printf("--------------------------------------\n");
+    printf("TEST:SETTINGS:BINDING\n");
+    test_settings_binding();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:DIRWALKER\n");
+    test_dir_walker();
+
+    printf("--------------------------------------\n");
+    printf("TEST:ASYNCFILEIO:BACKENDS\n");
+    test_async_file_io();
+
+    printf("--------------------------------------\n");
+    printf("TEST:VFS:RESOLVE\n");
+    test_vfs_resolve();
+
+    printf("--------------------------------------\n");
+    printf("TEST:PACKARCHIVE:BUILD_OPEN\n");
+    test_pack_archive();
+
+    printf("--------------------------------------\n");
+    printf("TEST:SETTINGS:CONCURRENT\n");
+    test_settings_concurrent();
+
+    printf("--------------------------------------\n");
+    printf("TEST:SETTINGS:QUERY\n");
+    test_settings_query();
+
+    printf("--------------------------------------\n");
+    printf("TEST:SETTINGS:ENVIRONMENT\n");
+    test_settings_environment();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:PATH_HASH\n");
+    test_path_hash();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:DIRENUMERATOR\n");
+    test_dir_enumerator();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:CACHING\n");
+    test_caching_filesystem();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:STAT_BATCH\n");
+    test_posix_stat_batch();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:MAPPEDFILE\n");
+    test_mapped_file();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:DIRECTFILEREADER\n");
+    test_direct_file_reader();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:BUFFEREDFILE\n");
+    test_buffered_file();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:INPUTSTREAM\n");
+    test_input_stream();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:MEMORYFS\n");
+    test_memory_filesystem();
+
+    printf("--------------------------------------\n");
+    printf("TEST:FILESYSTEM:WATCHER\n");
+    test_file_watcher();
+
     printf("--------------------------------------\n");
     printf("END OF TEST LOG\n");
 
-    return 0;
+    return s_test_failures ? 1 : 0;
 }
@@ -2,6 +2,11 @@
 
 #include "opt/AppSettings.h"
 #include "icyAppSettingsMap.h"
+#include "icySettingHandle.h"
+#include "icyAppSettingsShared.h"
+#include "EnvironUtil.h"
+#include "ConfigParse.h"
+#include "BufferedFile.h"
 #include "StringUtil.h"
 #include "icy_log.h"
 #include "icy_assert.h"
@@ -10,35 +15,225 @@
 
 namespace icyAppSettingsIfc
 {
-std::map<std::string, std::string> g_map;
+FlatStringMap g_map;			// merged view of all layers
+std::atomic<uint64_t> g_generation = 0;
+
+static FlatStringMap s_layers[kNumSettingsLayers];
 
 // lazy way to make this code look like a class member, and just in case we want to class it later.
 static auto& m_map = g_map;
 
+std::string_view _template_impl::SettingNameView(StdStringTempArg name) {
+	if (auto* stringptr = name.string_ptr()) {
+		return *stringptr;
+	}
+	if (auto* cstr = name.c_str()) {
+		return { cstr, name.length() };
+	}
+	return {};
+}
+
+char const* SettingsLayerName(SettingsLayer layer) {
+	switch (layer) {
+		CaseReturnString(SettingsLayer::Defaults);
+		CaseReturnString(SettingsLayer::ConfigFile);
+		CaseReturnString(SettingsLayer::Environment);
+		CaseReturnString(SettingsLayer::CommandLine);
+		CaseReturnString(SettingsLayer::Runtime);
+	}
+	return "SettingsLayer::Unknown";
+}
+
+// Change journal: a ring of {generation, key hash} records, one per generation, which lets consumers
+// that cache derived state (see SettingsBinding) find out which keys changed without rescanning
+// everything. Changes which affect an unknown set of keys reset the journal.
+struct SettingsJournalRecord {
+	uint64_t	generation;
+	uint32_t	hash;
+};
+
+static constexpr uint32_t		kSettingsJournalSize = 256;		// must be pow2
+static SettingsJournalRecord	s_journal[kSettingsJournalSize];
+static uint64_t					s_journal_reset;				// generations at or before this are not journaled
+
+void _bumpSettingsGeneration(std::string_view key) {
+	auto generation = ++g_generation;
+	s_journal[generation & (kSettingsJournalSize - 1)] = { generation, FlatStringMapHash(key) };
+}
+
+void _bumpSettingsGenerationAll() {
+	s_journal_reset = ++g_generation;
+}
+
+bool _getSettingsChangedSince(uint64_t generation, std::vector<uint32_t>& outHashes) {
+	outHashes.clear();
+	auto current = appGetSettingsGeneration();
+	if (generation < s_journal_reset || current - generation > kSettingsJournalSize) {
+		return false;
+	}
+
+	for (auto gen = generation + 1; gen <= current; ++gen) {
+		auto const& record = s_journal[gen & (kSettingsJournalSize - 1)];
+		if (record.generation != gen) {
+			return false;
+		}
+		outHashes.push_back(record.hash);
+	}
+	return true;
+}
+
+// All modifications to the merged view go through here, so that typed caches and handles stay coherent.
+static void _mergedSet(std::string_view lvalue, std::string_view rvalue) {
+	auto count = m_map.size();
+	if (m_map.set(lvalue, rvalue)) {
+		if (m_map.size() != count) {
+			_indexSettingKey(lvalue);
+		}
+		_bumpSettingsGeneration(lvalue);
+		_notifySettingHandles(lvalue, &rvalue);
+	}
+}
+
+static void _mergedErase(std::string_view lvalue) {
+	if (m_map.erase(lvalue)) {
+		_bumpSettingsGeneration(lvalue);
+
+		// the key may still be provided by an attached shared segment.
+		std::string_view shared;
+		bool isShared = appLookupSettingShared(lvalue, shared);
+		if (!isShared) {
+			_unindexSettingKey(lvalue);
+		}
+		_notifySettingHandles(lvalue, isShared ? &shared : nullptr);
+	}
+}
+
+// re-resolves a single key from the highest layer that defines it.
+static void _mergeKey(std::string_view lvalue) {
+	for (int i = kNumSettingsLayers - 1; i >= 0; --i) {
+		std::string_view rvalue;
+		if (s_layers[i].lookup(lvalue, rvalue)) {
+			_mergedSet(lvalue, rvalue);
+			return;
+		}
+	}
+	_mergedErase(lvalue);
+}
+
+void appSetSettingLayer(SettingsLayer layer, std::string_view lvalue, std::string_view rvalue) {
+	auto idx = int(layer);
+	s_layers[idx].set(lvalue, rvalue);
+
+	// fast path: skip the merge if a higher-precedence layer overrides this key.
+	for (int i = idx + 1; i < kNumSettingsLayers; ++i) {
+		if (s_layers[i].contains(lvalue)) {
+			return;
+		}
+	}
+	_mergedSet(lvalue, rvalue);
+}
+
+void appRemoveSettingLayer(SettingsLayer layer, std::string_view lvalue) {
+	if (s_layers[int(layer)].erase(lvalue)) {
+		_mergeKey(lvalue);
+	}
+}
+
+void appClearSettingsLayer(SettingsLayer layer) {
+	FlatStringMap removed;
+	std::swap(removed, s_layers[int(layer)]);
+	removed.forEach([](std::string_view lvalue, std::string_view) {
+		_mergeKey(lvalue);
+	});
+}
+
+std::optional<SettingsLayer> appGetSettingProvenance(std::string_view name) {
+	for (int i = kNumSettingsLayers - 1; i >= 0; --i) {
+		if (s_layers[i].contains(name)) {
+			return SettingsLayer(i);
+		}
+	}
+	return {};
+}
+
+int appImportSettingsFromEnvironment(std::string_view prefix) {
+	int count = 0;
+	std::string lvalue;
+	EnvironSnapshotForEach([&](std::string_view name, std::string_view value) {
+		if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+			return;
+		}
+
+		lvalue = "--";
+		for (size_t i = prefix.size(); i < name.size(); ++i) {
+			if (name[i] != '_') {
+				lvalue += (char)tolower((uint8_t)name[i]);
+			}
+			elif (i + 1 < name.size() && name[i + 1] == '_') {
+				lvalue += '.';
+				++i;
+			}
+			else {
+				lvalue += '-';
+			}
+		}
+		appSetSettingLayer(SettingsLayer::Environment, lvalue, value);
+		++count;
+	});
+	return count;
+}
+
 void appSetSetting(const std::string& lvalue, std::string rvalue) {
-	m_map[lvalue] = rvalue;
+	appSetSettingLayer(SettingsLayer::Runtime, lvalue, rvalue);
 }
 
 void appRemoveSetting(const std::string& lvalue) {
-	m_map.erase(lvalue);
+	bool removed = false;
+	for (auto& layer : s_layers) {
+		removed |= layer.erase(lvalue);
+	}
+	if (removed) {
+		_mergeKey(lvalue);
+	}
 }
 
-std::string appGetSetting(StdStringTempArg name) {
-	auto* stringptr = name.string_ptr();
-	if (!stringptr) {
-		static thread_local std::string tls_stdstring;
-		tls_stdstring = name.c_str();
-		stringptr = &tls_stdstring;
+bool appLoadSettingsFile(const fs::path& path) {
+	BufferedReader reader({ 64 * 1024 });
+	if (!reader.open(path)) {
+		log_error("%s: could not be opened for reading: %s", path.c_str(), strerror(reader.error()));
+		return false;
 	}
-	auto it = m_map.find(stringptr[0]);
-	if (it == m_map.end()) return {};
-	return it->second;
+	return ConfigParseFile(reader, [](const std::string& lvalue, const std::string& rvalue) {
+		appSetSettingLayer(SettingsLayer::ConfigFile, lvalue, rvalue);
+	}, { path });
+}
+
+void appLoadSettingsArgs(int argc, const char* const argv[]) {
+	ConfigParseArgs(argc, argv, [](const std::string& lvalue, const std::string& rvalue) {
+		if (!lvalue.empty()) {
+			appSetSettingLayer(SettingsLayer::CommandLine, lvalue, rvalue);
+		}
+	});
+}
+
+bool appLookupSetting(std::string_view name, std::string_view& outValue) {
+	return m_map.lookup(name, outValue) || appLookupSettingShared(name, outValue);
+}
+
+std::string_view appGetSettingView(StdStringTempArg name) {
+	std::string_view result;
+	appLookupSetting(_template_impl::SettingNameView(name), result);
+	return result;
+}
+
+std::string appGetSetting(StdStringTempArg name) {
+	return std::string(appGetSettingView(name));
 }
 
 std::tuple<std::string, bool> appGetSettingTuple(const std::string& name) {
-	auto it = m_map.find(name);
-	if (it == m_map.end()) return {};
-	return { it->second, true };
+	std::string_view value;
+	if (!appLookupSetting(name, value)) return {};
+	return { std::string(value), true };
 }
 
 std::string appGetSettingLwr(StdStringTempArg name) {
@@ -46,16 +241,17 @@ std::string appGetSettingLwr(StdStringTempArg name) {
 }
 
 bool appGetSetting(const std::string& name, std::string& value) {
-	auto it = m_map.find(name);
-	if (it == m_map.end())
+	std::string_view view;
+	if (!appLookupSetting(name, view))
 		return false;
 
-	value = it->second;
+	value = view;
 	return true;
 }
 
 bool appHasSetting(const std::string& name) {
-	return m_map.find(name) != m_map.end();
+	std::string_view view;
+	return appLookupSetting(name, view);
 }
 
 // returns 'exists' and 'value'
@@ -85,8 +281,24 @@ StdOptionString<bool> _getSettingBool(std::map<std::string, std::string> const&
 	return _getSettingValueBool(name, it->second);
 }
 
+StdOptionString<bool> _getSettingBool(FlatStringMap const& map, const std::string& name) {
+	std::string_view value;
+	if (!map.lookup(name, value)) return {};
+
+	// values stored in FlatStringMap are NUL-terminated, but _getSettingValueBool wants an owned copy
+	// for the StdOptionString result anyway.
+	return _getSettingValueBool(name, std::string(value));
+}
+
+// switch semantics differ from ConvertFromString<bool> (present-but-empty is TRUE), so keep a separate cache.
+struct SwitchBoolCacheTag;
+
 bool appGetSettingBool(const std::string& name, bool nonexist_result) {
-	auto opt = _getSettingBool(g_map, name);
+	auto const& opt = _template_impl::CachedSettingLookup<bool, SwitchBoolCacheTag>(name, [&]() -> StdOptionString<bool> {
+		std::string_view value;
+		if (!appLookupSetting(name, value)) return {};
+		return _getSettingValueBool(name, std::string(value));
+	});
 	return opt.value_or(nonexist_result);
 }
 
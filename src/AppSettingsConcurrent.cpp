@@ -0,0 +1,173 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "icyAppSettingsConcurrent.h"
+#include "icyAppSettingsMap.h"
+#include "icy_assert.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace icyAppSettingsIfc
+{
+
+// Epoch-based reclamation:
+//   - s_global_epoch only ever increases. Each publish increments it after swapping the snapshot pointer.
+//   - a reader records the global epoch into its own record (with a full barrier) before loading the
+//     snapshot pointer, and clears the record to zero when it leaves.
+//   - a snapshot retired at epoch R can only be referenced by readers whose recorded epoch is less than R,
+//     since any reader that recorded R or later did so after the pointer swap. Once no such reader remains,
+//     the snapshot is freed.
+
+// cacheline-aligned so that readers never write-share a line with each other.
+struct alignas(64) SettingsReaderRecord {
+	std::atomic<uint64_t>	epoch	= 0;	// 0 = not reading
+	std::atomic<int32_t>	in_use	= 0;
+	int32_t					nesting	= 0;
+	SettingsReaderRecord*	next	= nullptr;
+};
+
+struct RetiredSnapshot {
+	SettingsSnapshot*	snapshot;
+	uint64_t			retire_epoch;
+};
+
+static std::atomic<SettingsSnapshot*>		s_current_snapshot;
+static std::atomic<SettingsReaderRecord*>	s_reader_list;
+alignas(64) static std::atomic<uint64_t>	s_global_epoch = 1;
+
+// writer-side state, protected by s_writer_mutex.
+static std::mutex						s_writer_mutex;
+static std::vector<RetiredSnapshot>		s_retired;
+
+// records are never freed, only recycled when their owning thread exits. This keeps the reader list
+// safe to walk without any locking.
+static SettingsReaderRecord* _acquireReaderRecord() {
+	for (auto* rec = s_reader_list.load(); rec; rec = rec->next) {
+		int32_t expected = 0;
+		if (!rec->in_use.load() && rec->in_use.compare_exchange_strong(expected, 1)) {
+			return rec;
+		}
+	}
+
+	auto* rec = new SettingsReaderRecord{};
+	rec->in_use = 1;
+	rec->next = s_reader_list.load();
+	while (!s_reader_list.compare_exchange_weak(rec->next, rec)) {
+		// rec->next was updated to the current head, retry.
+	}
+	return rec;
+}
+
+struct SettingsReaderRecordTls {
+	SettingsReaderRecord* rec = nullptr;
+
+	SettingsReaderRecord* get() {
+		if (expect_false(!rec)) {
+			rec = _acquireReaderRecord();
+		}
+		return rec;
+	}
+
+	~SettingsReaderRecordTls() {
+		if (rec) {
+			assertD(rec->nesting == 0 && rec->epoch == 0, "Thread exited while holding a SettingsReadGuard.");
+			rec->in_use.store(0);
+		}
+	}
+};
+
+static thread_local SettingsReaderRecordTls s_tls_reader;
+
+SettingsReadGuard::SettingsReadGuard() {
+	auto* rec = s_tls_reader.get();
+	if (rec->nesting++ == 0) {
+		// exchange provides the full barrier needed to order our epoch store ahead of the pointer load.
+		rec->epoch.exchange(s_global_epoch.load());
+	}
+	m_snapshot = s_current_snapshot.load();
+}
+
+SettingsReadGuard::~SettingsReadGuard() {
+	auto* rec = s_tls_reader.rec;
+	if (--rec->nesting == 0) {
+		rec->epoch.store(0);
+	}
+}
+
+// must be called with s_writer_mutex held.
+static void _reclaimSnapshots() {
+	if (s_retired.empty()) {
+		return;
+	}
+
+	uint64_t min_active = UINT64_MAX;
+	for (auto* rec = s_reader_list.load(); rec; rec = rec->next) {
+		if (auto epoch = rec->epoch.load(); epoch && epoch < min_active) {
+			min_active = epoch;
+		}
+	}
+
+	auto keep = s_retired.begin();
+	for (auto& item : s_retired) {
+		if (item.retire_epoch <= min_active) {
+			delete item.snapshot;
+		}
+		else {
+			*keep++ = item;
+		}
+	}
+	s_retired.erase(keep, s_retired.end());
+}
+
+// must be called with s_writer_mutex held.
+static void _publishLocked() {
+	auto* snapshot = new SettingsSnapshot{ g_map, appGetSettingsGeneration() };
+	snapshot->map.compact();
+
+	auto* prev = s_current_snapshot.exchange(snapshot);
+	auto retire_epoch = ++s_global_epoch;
+	if (prev) {
+		s_retired.push_back({ prev, retire_epoch });
+	}
+	_reclaimSnapshots();
+}
+
+void appPublishSettingsSnapshot() {
+	std::lock_guard lock(s_writer_mutex);
+	_publishLocked();
+}
+
+void appUpdateSettings(std::function<void()> const& writer) {
+	std::lock_guard lock(s_writer_mutex);
+	auto generation = appGetSettingsGeneration();
+	writer();
+
+	auto* current = s_current_snapshot.load();
+	if (!current || appGetSettingsGeneration() != generation) {
+		_publishLocked();
+	}
+}
+
+std::string appGetSettingConcurrent(StdStringTempArg name) {
+	SettingsReadGuard guard;
+	return std::string(guard.get(_template_impl::SettingNameView(name)));
+}
+
+bool appGetSettingConcurrent(std::string_view name, std::string& value) {
+	SettingsReadGuard guard;
+	std::string_view view;
+	if (!guard.lookup(name, view)) {
+		return false;
+	}
+	value = view;
+	return true;
+}
+
+bool appHasSettingConcurrent(std::string_view name) {
+	SettingsReadGuard guard;
+	std::string_view view;
+	return guard.lookup(name, view);
+}
+
+} // namespace
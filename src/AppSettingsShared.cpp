@@ -0,0 +1,363 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "icyAppSettingsShared.h"
+#include "icyAppSettingsMap.h"
+#include "icySettingHandle.h"
+#include "EnvironUtil.h"
+#include "icy_log.h"
+#include "icy_assert.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <string>
+
+#if PLATFORM_POSIX
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
+namespace icyAppSettingsIfc
+{
+
+// Segment layout (all sections 8-byte aligned, offsets relative to the start of the segment):
+//
+//   SettingsSharedHeader
+//   FlatStringMapSlot  [slot_count]		-- power of two
+//   FlatStringMapEntry [entry_count]		-- no erased entries
+//   char               [arena_size]		-- NUL-terminated keys and values
+//
+// The slot and entry tables are byte-for-byte copies of a compacted FlatStringMap, and are searched
+// with FlatStringMapProbe, so the hashing and probing rules are shared with the live map.
+
+static constexpr uint32_t kSettingsSharedMagic		= 0x53'59'43'49;		// 'ICYS'
+static constexpr uint32_t kSettingsSharedVersion	= 1;
+
+struct SettingsSharedHeader {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	slot_count;
+	uint32_t	entry_count;
+	uint64_t	slots_offset;
+	uint64_t	entries_offset;
+	uint64_t	arena_offset;
+	uint64_t	arena_size;
+	uint64_t	total_size;
+};
+
+struct SettingsSharedSegment {
+	void const*					base;
+	size_t						size;
+	FlatStringMapSlot  const*	slots;
+	FlatStringMapEntry const*	entries;
+	char const*					arena;
+	uint32_t					slot_mask;
+	uint32_t					entry_count;
+
+	bool lookup(std::string_view name, std::string_view& outValue) const {
+		auto idx = FlatStringMapProbe(slots, slot_mask, entries, arena, name, FlatStringMapHash(name));
+		if (idx == kFlatMapNotFound) {
+			return false;
+		}
+		outValue = { arena + entries[idx].val_offset, entries[idx].val_length };
+		return true;
+	}
+
+	template<typename Func>
+	void forEach(Func&& func) const {
+		for (uint32_t i = 0; i < entry_count; ++i) {
+			auto const& entry = entries[i];
+			func(std::string_view{ arena + entry.key_offset, entry.key_length }, std::string_view{ arena + entry.val_offset, entry.val_length });
+		}
+	}
+};
+
+static SettingsSharedSegment	s_segment;
+static bool						s_attached;
+
+static uint64_t _align8(uint64_t offset) {
+	return (offset + 7) & ~uint64_t(7);
+}
+
+// Builds the segment image in memory. Slots and entries are copied verbatim from a compacted copy of
+// the settings store.
+static std::string _buildSegmentImage() {
+	FlatStringMap map = g_map;
+	map.compact();
+
+	auto slotCount = map.slots() ? map.slot_mask() + 1 : 0;
+
+	SettingsSharedHeader header = {};
+	header.magic			= kSettingsSharedMagic;
+	header.version			= kSettingsSharedVersion;
+	header.slot_count		= slotCount;
+	header.entry_count		= (uint32_t)map.entry_count();
+	header.slots_offset		= _align8(sizeof(header));
+	header.entries_offset	= _align8(header.slots_offset   + sizeof(FlatStringMapSlot)  * header.slot_count);
+	header.arena_offset		= _align8(header.entries_offset + sizeof(FlatStringMapEntry) * header.entry_count);
+	header.arena_size		= map.arena_size();
+	header.total_size		= _align8(header.arena_offset + header.arena_size);
+
+	std::string image(header.total_size, '\0');
+	memcpy(image.data(), &header, sizeof(header));
+	if (slotCount) {
+		memcpy(image.data() + header.slots_offset,   map.slots(),   sizeof(FlatStringMapSlot)  * header.slot_count);
+		memcpy(image.data() + header.entries_offset, map.entries(), sizeof(FlatStringMapEntry) * header.entry_count);
+		memcpy(image.data() + header.arena_offset,   map.arena(),   header.arena_size);
+	}
+	return image;
+}
+
+// validates everything that lookups will dereference, so that a truncated or corrupt segment is
+// rejected up front rather than faulting later.
+static bool _validateSegment(void const* base, size_t size, SettingsSharedSegment& out) {
+	if (size < sizeof(SettingsSharedHeader)) {
+		log_error("Shared settings segment is too small (%zu bytes).", size);
+		return false;
+	}
+
+	auto const& header = *(SettingsSharedHeader const*)base;
+	if (header.magic != kSettingsSharedMagic || header.version != kSettingsSharedVersion) {
+		log_error("Shared settings segment has an unrecognized header (magic=0x%08x, version=%u).", header.magic, header.version);
+		return false;
+	}
+
+	bool valid = (header.total_size <= size)
+		&& header.slots_offset <= header.total_size && header.entries_offset <= header.total_size && header.arena_offset <= header.total_size
+		&& (header.slot_count & (header.slot_count - 1)) == 0
+		&& (header.entry_count < header.slot_count || header.slot_count == 0)
+		&& header.slots_offset   + sizeof(FlatStringMapSlot)  * header.slot_count  <= header.total_size
+		&& header.entries_offset + sizeof(FlatStringMapEntry) * header.entry_count <= header.total_size
+		&& header.arena_offset   + header.arena_size <= header.total_size;
+
+	if (!valid) {
+		log_error("Shared settings segment has an invalid layout.");
+		return false;
+	}
+
+	auto const* bytes = (char const*)base;
+	out.base		= base;
+	out.size		= size;
+	out.slots		= header.slot_count ? (FlatStringMapSlot const*)(bytes + header.slots_offset) : nullptr;
+	out.entries		= (FlatStringMapEntry const*)(bytes + header.entries_offset);
+	out.arena		= bytes + header.arena_offset;
+	out.slot_mask	= header.slot_count ? header.slot_count - 1 : 0;
+	out.entry_count	= header.entry_count;
+
+	for (uint32_t i = 0; i < header.entry_count; ++i) {
+		auto const& entry = out.entries[i];
+		if (uint64_t(entry.key_offset) + entry.key_length >= header.arena_size || uint64_t(entry.val_offset) + entry.val_length >= header.arena_size) {
+			log_error("Shared settings segment entry %u is out of bounds.", i);
+			return false;
+		}
+	}
+
+	// FlatStringMapProbe stops only at an empty slot, so a table without one would never terminate on a miss.
+	// Tombstones are not bounded by entry_count, so the empty slots must be counted.
+	uint32_t emptySlots = 0;
+	for (uint32_t i = 0; i < header.slot_count; ++i) {
+		auto index = out.slots[i].index;
+		if (index != 0 && index != kFlatMapTombstone && index > header.entry_count) {
+			log_error("Shared settings segment slot %u is out of bounds.", i);
+			return false;
+		}
+		emptySlots += (index == 0);
+	}
+	if (header.slot_count && !emptySlots) {
+		log_error("Shared settings segment has no empty slots.");
+		return false;
+	}
+	return true;
+}
+
+// Attaching or detaching changes the effective value (and key index membership) of every shared key that
+// isn't overridden locally.
+static void _notifySharedKeys(bool attached) {
+	_bumpSettingsGenerationAll();
+	s_segment.forEach([&](std::string_view key, std::string_view value) {
+		if (!g_map.contains(key)) {
+			if (attached) {
+				_indexSettingKey(key);
+			}
+			else {
+				_unindexSettingKey(key);
+			}
+			_notifySettingHandles(key, attached ? &value : nullptr);
+		}
+	});
+}
+
+bool appLookupSettingShared(std::string_view name, std::string_view& outValue) {
+	return s_attached && s_segment.lookup(name, outValue);
+}
+
+bool appIsSettingsSharedAttached() {
+	return s_attached;
+}
+
+#if PLATFORM_POSIX
+static bool _writeAll(int fd, std::string const& image) {
+	size_t written = 0;
+	while (written < image.size()) {
+		auto result = pwrite(fd, image.data() + written, image.size() - written, written);
+		if (result < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		written += result;
+	}
+	return true;
+}
+
+int appPublishSettingsSharedMemory() {
+#if PLATFORM_LINUX
+	auto image = _buildSegmentImage();
+
+	int fd = memfd_create("icy-settings", MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		log_error("memfd_create failed: %s", strerror(errno));
+		return -1;
+	}
+
+	if (!_writeAll(fd, image)) {
+		log_error("Failed to write shared settings segment: %s", strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	// sealing guarantees to children that the segment can't change or shrink underneath their mappings.
+	if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+		log_error("Failed to seal shared settings segment: %s", strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
+#else
+	log_error("appPublishSettingsSharedMemory is not supported on this platform, use appPublishSettingsSharedFile.");
+	return -1;
+#endif
+}
+
+bool appPublishSettingsSharedFile(char const* path) {
+	auto image = _buildSegmentImage();
+
+	std::string tmppath = path;
+	tmppath += ".tmp." + std::to_string(getpid());
+
+	int fd = open(tmppath.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		log_error("Failed to create shared settings file '%s': %s", tmppath.c_str(), strerror(errno));
+		return false;
+	}
+
+	bool success = _writeAll(fd, image);
+	close(fd);
+
+	if (success && rename(tmppath.c_str(), path) != 0) {
+		success = false;
+	}
+	if (!success) {
+		log_error("Failed to write shared settings file '%s': %s", path, strerror(errno));
+		unlink(tmppath.c_str());
+	}
+	return success;
+}
+
+bool appAttachSettingsShared(int fd) {
+	appDetachSettingsShared();
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		log_error("Shared settings fd %d is invalid: %s", fd, strerror(errno));
+		return false;
+	}
+
+	auto size = (size_t)st.st_size;
+	if (size == 0) {
+		log_error("Shared settings segment is empty.");
+		return false;
+	}
+
+	void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		log_error("Failed to map shared settings segment: %s", strerror(errno));
+		return false;
+	}
+
+	SettingsSharedSegment segment;
+	if (!_validateSegment(base, size, segment)) {
+		munmap(base, size);
+		return false;
+	}
+
+	s_segment	= segment;
+	s_attached	= true;
+	_notifySharedKeys(true);
+	return true;
+}
+
+bool appAttachSettingsSharedFile(char const* path) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		log_error("Failed to open shared settings file '%s': %s", path, strerror(errno));
+		return false;
+	}
+
+	// the mapping holds its own reference to the file.
+	bool result = appAttachSettingsShared(fd);
+	close(fd);
+	return result;
+}
+
+void appDetachSettingsShared() {
+	if (!s_attached) {
+		return;
+	}
+
+	_notifySharedKeys(false);
+	munmap(const_cast<void*>(s_segment.base), s_segment.size);
+	s_segment	= {};
+	s_attached	= false;
+}
+#else
+int appPublishSettingsSharedMemory() {
+	log_error("appPublishSettingsSharedMemory is not supported on this platform.");
+	return -1;
+}
+
+bool appPublishSettingsSharedFile(char const* path) {
+	log_error("appPublishSettingsSharedFile is not supported on this platform.");
+	return false;
+}
+
+bool appAttachSettingsShared(int fd) {
+	log_error("appAttachSettingsShared is not supported on this platform.");
+	return false;
+}
+
+bool appAttachSettingsSharedFile(char const* path) {
+	log_error("appAttachSettingsSharedFile is not supported on this platform.");
+	return false;
+}
+
+void appDetachSettingsShared() {
+}
+#endif
+
+bool appAttachSettingsSharedFromEnvironment() {
+	auto* fdstr = EnvironSnapshotGet(kSettingsSharedFdEnvVar);
+	if (!fdstr || !fdstr[0]) {
+		return false;
+	}
+
+	char* endptr = nullptr;
+	auto fd = strtol(fdstr, &endptr, 10);
+	if (*endptr || fd < 0) {
+		log_error("%s=%s is not a valid file descriptor.", kSettingsSharedFdEnvVar, fdstr);
+		return false;
+	}
+	return appAttachSettingsShared((int)fd);
+}
+
+} // namespace
@@ -0,0 +1,685 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "AsyncFileIO.h"
+#include "icy_log.h"
+#include "icy_assert.h"
+
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if PLATFORM_LINUX
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#	include <linux/io_uring.h>
+#endif
+
+enum class AsyncFileOpType : uint8_t {
+	Read,
+	Write,
+	Open,
+	Close,
+	Fsync,
+	Statx,
+	ReadFixed,
+	WriteFixed,
+};
+
+struct AsyncFileOp {
+	AsyncFileOpType		type;
+	int					fd			= -1;		// fd, or file index for fixed ops
+	void*				buf			= nullptr;
+	size_t				size		= 0;
+	x_off_t				offset		= 0;
+	int					flags		= 0;
+	int					mode		= 0;
+	unsigned			buf_index	= 0;
+	bool				datasync	= false;
+	std::string			path;
+	CStatInfo*			stat_dest	= nullptr;
+	AsyncFileCallback	cb;
+#if PLATFORM_LINUX
+	struct statx		stx;
+#endif
+};
+
+// --------------------------------------------------------------------------------------------------------
+class AsyncFileIOBackend
+{
+protected:
+	std::mutex					m_idle_mutex;
+	std::condition_variable		m_idle_cv;
+	int64_t						m_inflight		= 0;
+	int64_t						m_max_inflight	= INT64_MAX;
+
+public:
+	virtual ~AsyncFileIOBackend() = default;
+
+	virtual bool	is_io_uring			() const = 0;
+	virtual void	submit				(AsyncFileOp* op) = 0;
+	virtual int		register_buffers	(const iovec* buffers, unsigned count) = 0;
+	virtual int		register_files		(const int* fds, unsigned count) = 0;
+	virtual void	unregister_buffers	() = 0;
+	virtual void	unregister_files	() = 0;
+
+	// blocks while the maximum number of operations are in flight.
+	void acquire_slot() {
+		std::unique_lock lock(m_idle_mutex);
+		m_idle_cv.wait(lock, [&] { return m_inflight < m_max_inflight; });
+		++m_inflight;
+	}
+
+	void complete(AsyncFileOp* op, intmax_t result) {
+		if (op->cb) {
+			op->cb(result);
+		}
+		delete op;
+
+		std::lock_guard lock(m_idle_mutex);
+		--m_inflight;
+		m_idle_cv.notify_all();
+	}
+
+	void wait_idle() {
+		std::unique_lock lock(m_idle_mutex);
+		m_idle_cv.wait(lock, [&] { return m_inflight == 0; });
+	}
+};
+
+// --------------------------------------------------------------------------------------------------------
+// Thread pool backend: executes each operation synchronously on a pool thread.
+//
+class AsyncFileThreadPool : public AsyncFileIOBackend
+{
+protected:
+	std::vector<std::thread>	m_threads;
+	std::mutex					m_queue_mutex;
+	std::condition_variable		m_queue_cv;
+	std::deque<AsyncFileOp*>	m_queue;
+	bool						m_stopping = false;
+	std::vector<int>			m_files;		// registered via register_files, read only while ops are in flight
+
+public:
+	AsyncFileThreadPool(int numThreads) {
+		for (int i = 0; i < std::max(1, numThreads); ++i) {
+			m_threads.emplace_back([this] { _worker(); });
+		}
+	}
+
+	~AsyncFileThreadPool() override {
+		{
+			std::lock_guard lock(m_queue_mutex);
+			m_stopping = true;
+		}
+		m_queue_cv.notify_all();
+		for (auto& thread : m_threads) {
+			thread.join();
+		}
+	}
+
+	bool is_io_uring() const override {
+		return false;
+	}
+
+	void submit(AsyncFileOp* op) override {
+		{
+			std::lock_guard lock(m_queue_mutex);
+			m_queue.push_back(op);
+		}
+		m_queue_cv.notify_one();
+	}
+
+	int register_buffers(const iovec*, unsigned) override {
+		return 0;
+	}
+
+	int register_files(const int* fds, unsigned count) override {
+		m_files.assign(fds, fds + count);
+		return 0;
+	}
+
+	void unregister_buffers() override {
+	}
+
+	void unregister_files() override {
+		m_files.clear();
+	}
+
+protected:
+	static intmax_t _errnoResult(intmax_t result) {
+		return (result < 0) ? -(intmax_t)errno : result;
+	}
+
+	intmax_t _execute(AsyncFileOp& op) {
+		int fd = op.fd;
+		if (op.type == AsyncFileOpType::ReadFixed || op.type == AsyncFileOpType::WriteFixed) {
+			if (op.fd < 0 || op.fd >= (int)m_files.size()) {
+				return -EBADF;
+			}
+			fd = m_files[op.fd];
+		}
+
+		switch (op.type) {
+			case AsyncFileOpType::Read:
+			case AsyncFileOpType::ReadFixed:
+				return _errnoResult((intmax_t)posix_pread(fd, op.buf, op.size, op.offset));
+
+			case AsyncFileOpType::Write:
+			case AsyncFileOpType::WriteFixed:
+				return _errnoResult((intmax_t)posix_pwrite(fd, op.buf, op.size, op.offset));
+
+			case AsyncFileOpType::Open:
+				return _errnoResult(posix_open(op.path.c_str(), op.flags, op.mode));
+
+			case AsyncFileOpType::Close:
+				return _errnoResult(posix_close(fd));
+
+			case AsyncFileOpType::Fsync:
+#if PLATFORM_MSW
+				return _errnoResult(_commit(fd));
+#else
+				return _errnoResult(op.datasync ? fdatasync(fd) : ::fsync(fd));
+#endif
+
+			case AsyncFileOpType::Statx: {
+				errno = 0;
+				*op.stat_dest = posix_stat(op.path.c_str());
+				if (!op.stat_dest->Exists()) {
+					return errno ? -errno : -ENOENT;
+				}
+				return 0;
+			}
+		}
+		return -EINVAL;
+	}
+
+	void _worker() {
+		for (;;) {
+			AsyncFileOp* op;
+			{
+				std::unique_lock lock(m_queue_mutex);
+				m_queue_cv.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+				if (m_queue.empty()) {
+					return;
+				}
+				op = m_queue.front();
+				m_queue.pop_front();
+			}
+			complete(op, _execute(*op));
+		}
+	}
+};
+
+// --------------------------------------------------------------------------------------------------------
+// io_uring backend, using the raw syscall interface.
+//
+#if PLATFORM_LINUX
+
+// ring indices are shared with the kernel: loads of kernel-written indices need acquire semantics, and
+// stores of our indices need release semantics, so that ring entries are visible before the index update.
+template<typename T> static T _ringLoad(const T* src) {
+	return __atomic_load_n(src, __ATOMIC_ACQUIRE);
+}
+template<typename T> static void _ringStore(T* dest, T val) {
+	__atomic_store_n(dest, val, __ATOMIC_RELEASE);
+}
+
+static constexpr uint8_t kAsyncUringOpsRequired[] = {
+	IORING_OP_READ, IORING_OP_WRITE, IORING_OP_OPENAT, IORING_OP_CLOSE,
+	IORING_OP_FSYNC, IORING_OP_STATX, IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED, IORING_OP_NOP,
+};
+
+// largest transfer Linux performs in a single read/write call.
+static constexpr size_t kAsyncMaxTransfer = 0x7fff'f000;
+
+class AsyncFileIoUring : public AsyncFileIOBackend
+{
+protected:
+	int				m_ring_fd	= -1;
+	std::mutex		m_submit_mutex;
+	std::thread		m_completion_thread;
+	unsigned		m_unsubmitted = 0;
+
+	void*			m_sq_ring	= MAP_FAILED;
+	void*			m_cq_ring	= MAP_FAILED;
+	size_t			m_sq_ring_size = 0;
+	size_t			m_cq_ring_size = 0;
+	io_uring_sqe*	m_sqes		= (io_uring_sqe*)MAP_FAILED;
+	size_t			m_sqes_size	= 0;
+
+	unsigned*		m_sq_head;
+	unsigned*		m_sq_tail;
+	unsigned		m_sq_mask;
+	unsigned		m_sq_entries;
+	unsigned*		m_sq_array;
+	unsigned*		m_cq_head;
+	unsigned*		m_cq_tail;
+	unsigned		m_cq_mask;
+	io_uring_cqe*	m_cqes;
+
+	static int _enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+		return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+	}
+
+	static int _register(int fd, unsigned opcode, const void* arg, unsigned count) {
+		return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count);
+	}
+
+public:
+	~AsyncFileIoUring() override {
+		if (m_completion_thread.joinable()) {
+			wait_idle();
+			_submitNop();		// wakes the completion thread, which exits on seeing it
+			m_completion_thread.join();
+		}
+		if (m_sqes != MAP_FAILED) {
+			munmap(m_sqes, m_sqes_size);
+		}
+		if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring) {
+			munmap(m_cq_ring, m_cq_ring_size);
+		}
+		if (m_sq_ring != MAP_FAILED) {
+			munmap(m_sq_ring, m_sq_ring_size);
+		}
+		if (m_ring_fd >= 0) {
+			::close(m_ring_fd);
+		}
+	}
+
+	bool init(unsigned queueDepth) {
+		io_uring_params params = {};
+		m_ring_fd = (int)syscall(__NR_io_uring_setup, std::max(1u, queueDepth), &params);
+		if (m_ring_fd < 0) {
+			return false;
+		}
+
+		if (!_probeOps()) {
+			return false;
+		}
+
+		m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		m_cq_ring_size = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+		bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP);
+		if (singleMmap) {
+			m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+		}
+
+		m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+		if (m_sq_ring == MAP_FAILED) {
+			return false;
+		}
+		m_cq_ring = singleMmap ? m_sq_ring
+			: mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_CQ_RING);
+		if (m_cq_ring == MAP_FAILED) {
+			return false;
+		}
+		m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		m_sqes = (io_uring_sqe*)mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES);
+		if (m_sqes == MAP_FAILED) {
+			return false;
+		}
+
+		auto* sq = (uint8_t*)m_sq_ring;
+		auto* cq = (uint8_t*)m_cq_ring;
+		m_sq_head		= (unsigned*)(sq + params.sq_off.head);
+		m_sq_tail		= (unsigned*)(sq + params.sq_off.tail);
+		m_sq_mask		= *(unsigned*)(sq + params.sq_off.ring_mask);
+		m_sq_entries	= params.sq_entries;
+		m_sq_array		= (unsigned*)(sq + params.sq_off.array);
+		m_cq_head		= (unsigned*)(cq + params.cq_off.head);
+		m_cq_tail		= (unsigned*)(cq + params.cq_off.tail);
+		m_cq_mask		= *(unsigned*)(cq + params.cq_off.ring_mask);
+		m_cqes			= (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+		// never allow more in flight than the completion queue can hold.
+		m_max_inflight	= params.cq_entries;
+
+		m_completion_thread = std::thread([this] { _completionThread(); });
+		return true;
+	}
+
+	bool is_io_uring() const override {
+		return true;
+	}
+
+	void submit(AsyncFileOp* op) override {
+		std::lock_guard lock(m_submit_mutex);
+		auto* sqe = _getSqe();
+		_prepare(*sqe, *op);
+		_commitSqe();
+	}
+
+	int register_buffers(const iovec* buffers, unsigned count) override {
+		_register(m_ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+		return (_register(m_ring_fd, IORING_REGISTER_BUFFERS, buffers, count) < 0) ? -errno : 0;
+	}
+
+	int register_files(const int* fds, unsigned count) override {
+		_register(m_ring_fd, IORING_UNREGISTER_FILES, nullptr, 0);
+		return (_register(m_ring_fd, IORING_REGISTER_FILES, fds, count) < 0) ? -errno : 0;
+	}
+
+	void unregister_buffers() override {
+		_register(m_ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+	}
+
+	void unregister_files() override {
+		_register(m_ring_fd, IORING_UNREGISTER_FILES, nullptr, 0);
+	}
+
+protected:
+	bool _probeOps() {
+		// the probe lists opcodes known to the running kernel. Older kernels lack some of the ops used here
+		// (eg. IORING_OP_READ arrived in 5.6), in which case the thread pool is used instead.
+		auto probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+		auto probeMem  = std::make_unique<uint8_t[]>(probeSize);
+		memset(probeMem.get(), 0, probeSize);
+		auto* probe = (io_uring_probe*)probeMem.get();
+		if (_register(m_ring_fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+			return false;
+		}
+		for (auto op : kAsyncUringOpsRequired) {
+			if (op >= probe->ops_len || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// caller must hold m_submit_mutex.
+	io_uring_sqe* _getSqe() {
+		// the kernel consumes SQEs during io_uring_enter, so a full ring only persists if submission is
+		// being refused (EBUSY/EAGAIN under memory pressure). Keep pushing until space opens up.
+		while (*m_sq_tail - _ringLoad(m_sq_head) >= m_sq_entries) {
+			_flush();
+			if (*m_sq_tail - _ringLoad(m_sq_head) >= m_sq_entries) {
+				std::this_thread::yield();
+			}
+		}
+		auto index = *m_sq_tail & m_sq_mask;
+		auto* sqe = &m_sqes[index];
+		memset(sqe, 0, sizeof(*sqe));
+		m_sq_array[index] = index;
+		return sqe;
+	}
+
+	// caller must hold m_submit_mutex.
+	void _commitSqe() {
+		_ringStore(m_sq_tail, *m_sq_tail + 1);
+		++m_unsubmitted;
+		_flush();
+	}
+
+	// caller must hold m_submit_mutex.
+	void _flush() {
+		while (m_unsubmitted) {
+			int result = _enter(m_ring_fd, m_unsubmitted, 0, 0);
+			if (result < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				if (errno != EAGAIN && errno != EBUSY) {
+					log_error("io_uring_enter failed, code=%d (%s)", errno, strerror(errno));
+				}
+				return;		// entries remain in the ring, and go with the next submission.
+			}
+			m_unsubmitted -= std::min<unsigned>(result, m_unsubmitted);
+		}
+	}
+
+	void _submitNop() {
+		std::lock_guard lock(m_submit_mutex);
+		auto* sqe = _getSqe();
+		sqe->opcode		= IORING_OP_NOP;
+		sqe->user_data	= 0;
+		_commitSqe();
+	}
+
+	void _prepare(io_uring_sqe& sqe, AsyncFileOp& op) {
+		sqe.user_data = (uint64_t)(uintptr_t)&op;
+		sqe.fd = op.fd;
+
+		switch (op.type) {
+			case AsyncFileOpType::Read:
+			case AsyncFileOpType::Write:
+			case AsyncFileOpType::ReadFixed:
+			case AsyncFileOpType::WriteFixed:
+				switch (op.type) {
+					case AsyncFileOpType::Read:			sqe.opcode = IORING_OP_READ;			break;
+					case AsyncFileOpType::Write:		sqe.opcode = IORING_OP_WRITE;			break;
+					case AsyncFileOpType::ReadFixed:	sqe.opcode = IORING_OP_READ_FIXED;		break;
+					default:							sqe.opcode = IORING_OP_WRITE_FIXED;		break;
+				}
+				if (op.type == AsyncFileOpType::ReadFixed || op.type == AsyncFileOpType::WriteFixed) {
+					sqe.flags		|= IOSQE_FIXED_FILE;
+					sqe.buf_index	 = (uint16_t)op.buf_index;
+				}
+				sqe.addr	= (uint64_t)(uintptr_t)op.buf;
+				sqe.len		= (uint32_t)std::min(op.size, kAsyncMaxTransfer);
+				sqe.off		= (uint64_t)op.offset;
+				break;
+
+			case AsyncFileOpType::Open:
+				sqe.opcode		= IORING_OP_OPENAT;
+				sqe.fd			= AT_FDCWD;
+				sqe.addr		= (uint64_t)(uintptr_t)op.path.c_str();
+				sqe.len			= (uint32_t)op.mode;
+				sqe.open_flags	= (uint32_t)op.flags;
+				break;
+
+			case AsyncFileOpType::Close:
+				sqe.opcode		= IORING_OP_CLOSE;
+				break;
+
+			case AsyncFileOpType::Fsync:
+				sqe.opcode		= IORING_OP_FSYNC;
+				sqe.fsync_flags	= op.datasync ? IORING_FSYNC_DATASYNC : 0;
+				break;
+
+			case AsyncFileOpType::Statx:
+				sqe.opcode		= IORING_OP_STATX;
+				sqe.fd			= AT_FDCWD;
+				sqe.addr		= (uint64_t)(uintptr_t)op.path.c_str();
+				sqe.len			= kPosixStatxMask;
+				sqe.off			= (uint64_t)(uintptr_t)&op.stx;
+				sqe.statx_flags	= AT_STATX_SYNC_AS_STAT;
+				break;
+		}
+	}
+
+	void _completionThread() {
+		bool stopping = false;
+		while (!stopping) {
+			auto head = *m_cq_head;
+			auto tail = _ringLoad(m_cq_tail);
+			if (head == tail) {
+				if (_enter(m_ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+					log_error("io_uring_enter(GETEVENTS) failed, code=%d (%s)", errno, strerror(errno));
+				}
+				continue;
+			}
+
+			for (; head != tail; ++head) {
+				auto const& cqe = m_cqes[head & m_cq_mask];
+				auto* op	= (AsyncFileOp*)(uintptr_t)cqe.user_data;
+				auto result	= (intmax_t)cqe.res;
+
+				// release the slot before running the callback, which may submit more work.
+				_ringStore(m_cq_head, head + 1);
+
+				if (!op) {
+					stopping = true;
+					continue;
+				}
+				if (op->type == AsyncFileOpType::Statx && op->stat_dest) {
+					*op->stat_dest = (result >= 0) ? posix_statx_to_info(op->stx) : CStatInfo{};
+				}
+				complete(op, result);
+			}
+		}
+	}
+};
+
+#endif
+
+// --------------------------------------------------------------------------------------------------------
+AsyncFileIO::AsyncFileIO(const AsyncFileIOOptions& options) {
+#if PLATFORM_LINUX
+	if (!options.force_fallback) {
+		auto uring = std::make_unique<AsyncFileIoUring>();
+		if (uring->init(options.queue_depth)) {
+			m_backend = std::move(uring);
+			return;
+		}
+	}
+#endif
+	m_backend = std::make_unique<AsyncFileThreadPool>(options.fallback_threads);
+}
+
+AsyncFileIO::~AsyncFileIO() {
+	m_backend->wait_idle();
+}
+
+bool AsyncFileIO::using_io_uring() const {
+	return m_backend->is_io_uring();
+}
+
+void AsyncFileIO::_submit(AsyncFileOp* op) {
+	m_backend->acquire_slot();
+	m_backend->submit(op);
+}
+
+void AsyncFileIO::pread(int fd, void* dest, size_t size, x_off_t offset, AsyncFileCallback cb) {
+	auto* op	= new AsyncFileOp { AsyncFileOpType::Read };
+	op->fd		= fd;
+	op->buf		= dest;
+	op->size	= size;
+	op->offset	= offset;
+	op->cb		= std::move(cb);
+	_submit(op);
+}
+
+void AsyncFileIO::pwrite(int fd, const void* src, size_t size, x_off_t offset, AsyncFileCallback cb) {
+	auto* op	= new AsyncFileOp { AsyncFileOpType::Write };
+	op->fd		= fd;
+	op->buf		= (void*)src;
+	op->size	= size;
+	op->offset	= offset;
+	op->cb		= std::move(cb);
+	_submit(op);
+}
+
+void AsyncFileIO::open(const char* path, int flags, int mode, AsyncFileCallback cb) {
+	auto* op	= new AsyncFileOp { AsyncFileOpType::Open };
+	op->path	= path;
+	op->flags	= flags;
+	op->mode	= mode;
+	op->cb		= std::move(cb);
+	_submit(op);
+}
+
+void AsyncFileIO::close(int fd, AsyncFileCallback cb) {
+	auto* op	= new AsyncFileOp { AsyncFileOpType::Close };
+	op->fd		= fd;
+	op->cb		= std::move(cb);
+	_submit(op);
+}
+
+void AsyncFileIO::fsync(int fd, bool datasync, AsyncFileCallback cb) {
+	auto* op		= new AsyncFileOp { AsyncFileOpType::Fsync };
+	op->fd			= fd;
+	op->datasync	= datasync;
+	op->cb			= std::move(cb);
+	_submit(op);
+}
+
+void AsyncFileIO::statx(const char* path, CStatInfo* dest, AsyncFileCallback cb) {
+	auto* op		= new AsyncFileOp { AsyncFileOpType::Statx };
+	op->path		= path;
+	op->stat_dest	= dest;
+	op->cb			= std::move(cb);
+	_submit(op);
+}
+
+void AsyncFileIO::pread_fixed(int fileIndex, void* dest, size_t size, x_off_t offset, unsigned bufferIndex, AsyncFileCallback cb) {
+	auto* op		= new AsyncFileOp { AsyncFileOpType::ReadFixed };
+	op->fd			= fileIndex;
+	op->buf			= dest;
+	op->size		= size;
+	op->offset		= offset;
+	op->buf_index	= bufferIndex;
+	op->cb			= std::move(cb);
+	_submit(op);
+}
+
+void AsyncFileIO::pwrite_fixed(int fileIndex, const void* src, size_t size, x_off_t offset, unsigned bufferIndex, AsyncFileCallback cb) {
+	auto* op		= new AsyncFileOp { AsyncFileOpType::WriteFixed };
+	op->fd			= fileIndex;
+	op->buf			= (void*)src;
+	op->size		= size;
+	op->offset		= offset;
+	op->buf_index	= bufferIndex;
+	op->cb			= std::move(cb);
+	_submit(op);
+}
+
+template<typename SubmitFunc>
+std::future<intmax_t> AsyncFileIO::_asFuture(SubmitFunc&& submit) {
+	auto promise = std::make_shared<std::promise<intmax_t>>();
+	auto future  = promise->get_future();
+	submit([promise](intmax_t result) { promise->set_value(result); });
+	return future;
+}
+
+std::future<intmax_t> AsyncFileIO::pread(int fd, void* dest, size_t size, x_off_t offset) {
+	return _asFuture([&](AsyncFileCallback cb) { pread(fd, dest, size, offset, std::move(cb)); });
+}
+
+std::future<intmax_t> AsyncFileIO::pwrite(int fd, const void* src, size_t size, x_off_t offset) {
+	return _asFuture([&](AsyncFileCallback cb) { pwrite(fd, src, size, offset, std::move(cb)); });
+}
+
+std::future<intmax_t> AsyncFileIO::open(const char* path, int flags, int mode) {
+	return _asFuture([&](AsyncFileCallback cb) { open(path, flags, mode, std::move(cb)); });
+}
+
+std::future<intmax_t> AsyncFileIO::close(int fd) {
+	return _asFuture([&](AsyncFileCallback cb) { close(fd, std::move(cb)); });
+}
+
+std::future<intmax_t> AsyncFileIO::fsync(int fd, bool datasync) {
+	return _asFuture([&](AsyncFileCallback cb) { fsync(fd, datasync, std::move(cb)); });
+}
+
+std::future<intmax_t> AsyncFileIO::statx(const char* path, CStatInfo* dest) {
+	return _asFuture([&](AsyncFileCallback cb) { statx(path, dest, std::move(cb)); });
+}
+
+int AsyncFileIO::register_buffers(const iovec* buffers, unsigned count) {
+	return m_backend->register_buffers(buffers, count);
+}
+
+int AsyncFileIO::register_files(const int* fds, unsigned count) {
+	return m_backend->register_files(fds, count);
+}
+
+void AsyncFileIO::unregister_buffers() {
+	m_backend->unregister_buffers();
+}
+
+void AsyncFileIO::unregister_files() {
+	m_backend->unregister_files();
+}
+
+void AsyncFileIO::wait_idle() {
+	m_backend->wait_idle();
+}
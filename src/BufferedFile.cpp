@@ -0,0 +1,436 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "BufferedFile.h"
+#include "icy_log.h"
+#include "icy_assert.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if !PLATFORM_MSW
+#	include <sys/uio.h>
+#endif
+
+#if !defined(O_CLOEXEC)
+#	define O_CLOEXEC	(0)
+#endif
+
+// --------------------------------------------------------------------------------------------------------
+BufferedReader::BufferedReader(const BufferedReaderOptions& options)
+	: m_options(options)
+{
+	// one byte is reserved past the data, for NUL-terminating the last line of a file.
+	m_capacity	= std::max<size_t>(options.buffer_size, 64) + 1;
+	m_buffer	= std::make_unique<char[]>(m_capacity);
+}
+
+BufferedReader::~BufferedReader() {
+	close();
+}
+
+bool BufferedReader::open(const fs::path& path) {
+	return open((const char*)path);
+}
+
+bool BufferedReader::open(const char* path) {
+	close();
+	int fd = ::posix_open(path, O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0) {
+		m_error = errno;
+		return false;
+	}
+	attach(fd, true);
+	return true;
+}
+
+void BufferedReader::attach(int fd, bool takeOwnership) {
+	close();
+	m_fd		= fd;
+	m_owns_fd	= takeOwnership;
+	m_error		= 0;
+
+#if PLATFORM_LINUX
+	if (m_options.readahead) {
+		// doubles the kernel readahead window for this file, and drops the pages behind us sooner.
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+#endif
+}
+
+void BufferedReader::close() {
+	if (m_fd >= 0 && m_owns_fd) {
+		::posix_close(m_fd);
+	}
+	m_fd		= -1;
+	m_owns_fd	= false;
+	m_pos		= 0;
+	m_end		= 0;
+	m_eof		= false;
+}
+
+bool BufferedReader::_grow(size_t minCapacity) {
+	auto newCapacity = std::max(minCapacity, m_capacity * 2);
+	auto newBuffer = std::make_unique<char[]>(newCapacity);
+	memcpy(newBuffer.get(), m_buffer.get() + m_pos, m_end - m_pos);
+	m_end		-= m_pos;
+	m_pos		 = 0;
+	m_buffer	 = std::move(newBuffer);
+	m_capacity	 = newCapacity;
+	return true;
+}
+
+// moves unconsumed data to the front of the buffer and reads more after it. Returns FALSE on error.
+// Reaching the end of the file is not an error, and sets m_eof.
+bool BufferedReader::_fill() {
+	if (m_pos) {
+		memmove(m_buffer.get(), m_buffer.get() + m_pos, m_end - m_pos);
+		m_end -= m_pos;
+		m_pos  = 0;
+	}
+
+	auto space = m_capacity - 1 - m_end;
+	if (!space || m_eof) {
+		return true;
+	}
+
+	for (;;) {
+		auto result = (intmax_t)::posix_read(m_fd, m_buffer.get() + m_end, space);
+		if (result > 0) {
+			m_end += (size_t)result;
+			return true;
+		}
+		if (result == 0) {
+			m_eof = true;
+			return true;
+		}
+		if (errno != EINTR) {
+			m_error = errno;
+			return false;
+		}
+	}
+}
+
+intmax_t BufferedReader::read(void* dest, size_t size) {
+	if (m_fd < 0) {
+		m_error = EBADF;
+		return -1;
+	}
+
+	auto* out = (char*)dest;
+	size_t total = 0;
+
+	while (total < size) {
+		if (m_pos < m_end) {
+			auto amount = std::min(m_end - m_pos, size - total);
+			memcpy(out + total, m_buffer.get() + m_pos, amount);
+			m_pos += amount;
+			total += amount;
+			continue;
+		}
+		if (m_eof) {
+			break;
+		}
+
+		auto remain = size - total;
+		if (remain >= m_capacity - 1) {
+			// large reads go directly to the destination, the buffer would only add a copy.
+			auto result = (intmax_t)::posix_read(m_fd, out + total, remain);
+			if (result < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				m_error = errno;
+				return total ? (intmax_t)total : -1;
+			}
+			if (result == 0) {
+				m_eof = true;
+			}
+			total += (size_t)result;
+			continue;
+		}
+
+		if (!_fill()) {
+			return total ? (intmax_t)total : -1;
+		}
+	}
+	return (intmax_t)total;
+}
+
+bool BufferedReader::readLine(std::string_view& line) {
+	if (m_fd < 0) {
+		return false;
+	}
+
+	size_t scanned = 0;		// bytes past m_pos known to contain no newline
+	for (;;) {
+		auto* base	= m_buffer.get();
+		auto* nl	= (char*)memchr(base + m_pos + scanned, '\n', m_end - m_pos - scanned);
+
+		size_t start = m_pos;
+		size_t length;
+		if (nl) {
+			length	= (size_t)(nl - (base + start));
+			m_pos	= start + length + 1;
+		}
+		elif (m_eof) {
+			if (m_pos == m_end) {
+				return false;
+			}
+			length	= m_end - start;
+			m_pos	= m_end;
+		}
+		else {
+			scanned = m_end - m_pos;
+			if (m_pos == 0 && m_end == m_capacity - 1) {
+				_grow(m_capacity * 2);
+			}
+			if (!_fill()) {
+				return false;
+			}
+			continue;
+		}
+
+		if (length && base[start + length - 1] == '\r') {
+			--length;
+		}
+		base[start + length] = 0;
+		line = { base + start, length };
+		return true;
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------
+BufferedWriter::BufferedWriter(const BufferedWriterOptions& options)
+	: m_options(options)
+{
+	m_capacity	= std::max<size_t>(options.buffer_size, 64);
+	m_buffer	= std::make_unique<char[]>(m_capacity);
+	if (options.background) {
+		m_pending = std::make_unique<char[]>(m_capacity);
+	}
+}
+
+BufferedWriter::~BufferedWriter() {
+	close();
+}
+
+bool BufferedWriter::open(const fs::path& path, int flags, int mode) {
+	return open((const char*)path, flags, mode);
+}
+
+bool BufferedWriter::open(const char* path, int flags, int mode) {
+	close();
+	int fd = ::posix_open(path, flags | O_CLOEXEC, mode);
+	if (fd < 0) {
+		m_error = errno;
+		return false;
+	}
+	attach(fd, true);
+	return true;
+}
+
+void BufferedWriter::attach(int fd, bool takeOwnership) {
+	close();
+	m_fd		= fd;
+	m_owns_fd	= takeOwnership;
+	m_error		= 0;
+	m_used		= 0;
+
+	if (m_options.background) {
+		m_stopping		= false;
+		m_pending_error	= 0;
+		m_thread		= std::thread([this] { _writerThread(); });
+	}
+}
+
+bool BufferedWriter::close() {
+	if (m_fd < 0) {
+		return true;
+	}
+
+	bool result = flush();
+
+	if (m_thread.joinable()) {
+		{
+			std::lock_guard lock(m_mutex);
+			m_stopping = true;
+		}
+		m_cv.notify_all();
+		m_thread.join();
+	}
+
+	if (m_owns_fd && ::posix_close(m_fd) != 0) {
+		_setError(errno);
+		result = false;
+	}
+	m_fd		= -1;
+	m_owns_fd	= false;
+	return result;
+}
+
+void BufferedWriter::_setError(int err) {
+	if (!m_error) {
+		m_error = err;
+		log_error("BufferedWriter: write to fd %d failed: %s", m_fd, strerror(err));
+	}
+}
+
+// writes head followed by tail, in as few syscalls as possible.
+bool BufferedWriter::_writeAll(const void* head, size_t headSize, const void* tail, size_t tailSize) {
+#if PLATFORM_MSW
+	for (auto [src, size] : { std::pair{ (const char*)head, headSize }, std::pair{ (const char*)tail, tailSize } }) {
+		while (size) {
+			auto chunk	= (unsigned)std::min<size_t>(size, 0x4000'0000);
+			auto result	= ::posix_write(m_fd, src, chunk);
+			if (result < 0) {
+				_setError(errno);
+				return false;
+			}
+			src  += result;
+			size -= (size_t)result;
+		}
+	}
+	return true;
+#else
+	iovec iov[2] = {
+		{ (void*)head, headSize },
+		{ (void*)tail, tailSize },
+	};
+	iovec* cur	= iov;
+	int count	= 2;
+
+	while (count) {
+		if (!cur->iov_len) {
+			++cur;
+			--count;
+			continue;
+		}
+		auto result = ::writev(m_fd, cur, count);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			_setError(errno);
+			return false;
+		}
+		auto written = (size_t)result;
+		while (count && written >= cur->iov_len) {
+			written -= cur->iov_len;
+			++cur;
+			--count;
+		}
+		if (count) {
+			cur->iov_base	= (char*)cur->iov_base + written;
+			cur->iov_len	-= written;
+		}
+	}
+	return true;
+#endif
+}
+
+void BufferedWriter::_waitPending() {
+	std::unique_lock lock(m_mutex);
+	m_cv.wait(lock, [&] { return !m_pending_busy; });
+	if (m_pending_error) {
+		_setError(m_pending_error);
+		m_pending_error = 0;
+	}
+}
+
+void BufferedWriter::_writerThread() {
+	std::unique_lock lock(m_mutex);
+	for (;;) {
+		m_cv.wait(lock, [&] { return m_pending_busy || m_stopping; });
+		if (!m_pending_busy) {
+			return;
+		}
+
+		lock.unlock();
+		int err = 0;
+		auto* src	= m_pending.get();
+		auto size	= m_pending_size;
+		while (size) {
+			auto result = (intmax_t)::posix_write(m_fd, src, (unsigned)std::min<size_t>(size, 0x4000'0000));
+			if (result < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				err = errno;
+				break;
+			}
+			src  += result;
+			size -= (size_t)result;
+		}
+		lock.lock();
+
+		m_pending_busy	= false;
+		m_pending_error	= m_pending_error ? m_pending_error : err;
+		m_cv.notify_all();
+	}
+}
+
+bool BufferedWriter::write(const void* src, size_t size) {
+	if (m_fd < 0 || m_error) {
+		return false;
+	}
+
+	auto* in = (const char*)src;
+
+	if (!m_options.background) {
+		if (m_used + size <= m_capacity) {
+			memcpy(m_buffer.get() + m_used, in, size);
+			m_used += size;
+			return true;
+		}
+		// buffered data and the new data go out in a single writev, rather than topping up the buffer first.
+		bool result = _writeAll(m_buffer.get(), m_used, in, size);
+		m_used = 0;
+		return result;
+	}
+
+	while (size) {
+		if (m_used == 0 && size >= m_capacity) {
+			// larger than a buffer: write synchronously once the background write (which precedes this data
+			// in the file) is done.
+			_waitPending();
+			return !m_error && _writeAll(in, size, nullptr, 0);
+		}
+
+		auto amount = std::min(size, m_capacity - m_used);
+		memcpy(m_buffer.get() + m_used, in, amount);
+		m_used	+= amount;
+		in		+= amount;
+		size	-= amount;
+
+		if (m_used == m_capacity) {
+			_waitPending();
+			if (m_error) {
+				return false;
+			}
+			{
+				std::lock_guard lock(m_mutex);
+				std::swap(m_buffer, m_pending);
+				m_pending_size	= m_used;
+				m_pending_busy	= true;
+			}
+			m_cv.notify_all();
+			m_used = 0;
+		}
+	}
+	return true;
+}
+
+bool BufferedWriter::flush() {
+	if (m_fd < 0) {
+		return false;
+	}
+	if (m_options.background) {
+		_waitPending();
+	}
+	if (m_used && !m_error) {
+		_writeAll(m_buffer.get(), m_used, nullptr, 0);
+	}
+	m_used = 0;
+	return !m_error;
+}
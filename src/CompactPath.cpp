@@ -0,0 +1,198 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "CompactPath.h"
+#include "icy_assert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace fs {
+
+// returns TRUE if the path is already in universal form and would pass through PathFromString unmodified
+// (aside from trailing slash removal). See ConvertFromMsw for the forms which need conversion.
+static bool _isUniversalForm(std::string_view src) {
+	if (src.empty() || src[0] == '/') {
+		return true;
+	}
+	if (src == "NUL" || src == "CON") {
+		return false;
+	}
+	return src.find_first_of("\\:") == src.npos;
+}
+
+CompactPath& CompactPath::operator=(CompactPath&& rhs) {
+	if (this == &rhs) {
+		return *this;
+	}
+
+	if (rhs.is_inline()) {
+		_assign_uni(rhs.uni_view());
+	}
+	else {
+		if (!is_inline()) {
+			delete[] m_data;
+		}
+		m_data		= rhs.m_data;
+		m_length	= rhs.m_length;
+		m_capacity	= rhs.m_capacity;
+		_invalidate_native();
+
+		rhs.m_data		= rhs.m_inline;
+		rhs.m_capacity	= kInlineCapacity;
+	}
+	rhs.clear();
+	return *this;
+}
+
+void CompactPath::clear() {
+	m_length	= 0;
+	m_data[0]	= 0;
+	_invalidate_native();
+}
+
+void CompactPath::_reserve(size_t length) {
+	if (length <= m_capacity) {
+		return;
+	}
+
+	assertD(length < UINT32_MAX);
+	auto capacity = std::max<size_t>(length, m_capacity * 2);
+	auto* data = new char[capacity + 1];
+	memcpy(data, m_data, m_length + 1);
+
+	if (!is_inline()) {
+		delete[] m_data;
+	}
+	m_data		= data;
+	m_capacity	= (uint32_t)capacity;
+}
+
+void CompactPath::_assign_uni(std::string_view uni) {
+	_reserve(uni.size());
+	if (!uni.empty()) {
+		memmove(m_data, uni.data(), uni.size());
+	}
+	m_length = (uint32_t)uni.size();
+	m_data[m_length] = 0;
+	_invalidate_native();
+}
+
+CompactPath& CompactPath::assign(std::string_view src) {
+	if (expect_true(_isUniversalForm(src))) {
+		// the root itself keeps its slash.
+		if (src.size() > 1 && src.back() == '/') {
+			src.remove_suffix(1);
+		}
+		_assign_uni(src);
+	}
+	else {
+		_assign_uni(PathFromString(std::string(src).c_str()));
+	}
+	return *this;
+}
+
+bool CompactPath::_aliases(std::string_view src) const {
+	return src.data() >= m_data && src.data() <= m_data + m_length;
+}
+
+CompactPath& CompactPath::append(std::string_view comp) {
+	if (comp.empty()) {
+		return *this;
+	}
+
+	if (expect_false(_aliases(comp))) {
+		// appending may reallocate the buffer out from under the caller's view, eg. p /= p.filename()
+		return append(std::string_view(std::string(comp)));
+	}
+
+	if (!_isUniversalForm(comp)) {
+		return append(std::string_view(PathFromString(std::string(comp).c_str())));
+	}
+
+	// the root itself keeps its slash, so that append("/") yields the root as fs::path::append does.
+	if (comp.size() > 1 && comp.back() == '/') {
+		comp.remove_suffix(1);
+	}
+
+	if (comp[0] == '/') {
+		// provided path is rooted, thus it overrides original path completely.
+		_assign_uni(comp);
+		return *this;
+	}
+
+	bool needsSep = m_length && m_data[m_length - 1] != separator;
+	_reserve(m_length + needsSep + comp.size());
+	if (needsSep) {
+		m_data[m_length++] = separator;
+	}
+	memcpy(m_data + m_length, comp.data(), comp.size());
+	m_length += (uint32_t)comp.size();
+	m_data[m_length] = 0;
+	_invalidate_native();
+	return *this;
+}
+
+CompactPath& CompactPath::concat(std::string_view src) {
+	// same as fs::path::concat, no platform-specific interpretation of the input.
+	if (expect_false(_aliases(src))) {
+		return concat(std::string_view(std::string(src)));
+	}
+	_reserve(m_length + src.size());
+	memcpy(m_data + m_length, src.data(), src.size());
+	m_length += (uint32_t)src.size();
+	m_data[m_length] = 0;
+	_invalidate_native();
+	return *this;
+}
+
+CompactPath& CompactPath::normalize() {
+	if (m_length) {
+		m_length = (uint32_t)LexicallyNormalize(m_data, m_length);
+		m_data[m_length] = 0;
+		_invalidate_native();
+	}
+	return *this;
+}
+
+std::string_view CompactPath::filename() const {
+	auto view = uni_view();
+	auto pos  = view.find_last_of(separator);
+	return (pos == view.npos) ? view : view.substr(pos + 1);
+}
+
+std::string_view CompactPath::extension() const {
+	// same rules as fs::path::extension(): a filename consisting only of dots has no extension.
+	auto fn = filename();
+	if (fn.find_first_not_of('.') == fn.npos) {
+		return {};
+	}
+	auto pos = fn.find_last_of('.');
+	return (pos == fn.npos) ? std::string_view{} : fn.substr(pos);
+}
+
+std::string_view CompactPath::stem() const {
+	auto fn  = filename();
+	auto ext = extension();
+	return fn.substr(0, fn.size() - ext.size());
+}
+
+std::string_view CompactPath::parent_path() const {
+	auto view = uni_view();
+	auto pos  = view.find_last_of(separator);
+	return (pos == view.npos) ? view : view.substr(0, pos);
+}
+
+char const* CompactPath::c_str() const {
+#if FILESYSTEM_NEEDS_OS_PATH
+	if (!m_native_valid) {
+		m_native = ConvertToMsw(std::string(m_data, m_length));
+		m_native_valid = true;
+	}
+	return m_native.c_str();
+#else
+	return m_data;
+#endif
+}
+
+} // namespace fs
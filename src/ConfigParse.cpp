@@ -6,6 +6,7 @@
 #include <algorithm>
 
 #include "ConfigParse.h"
+#include "BufferedFile.h"
 #include "StringUtil.h"
 #include "fs.h"
 #include "defer.h"
@@ -14,6 +15,11 @@
 #include "icy_assert.h"
 
 bool ConfigParseLine(const char* readbuf, const ConfigParseAddFunc& push_item, ConfigParseContext const& ctx) {
+	ConfigParseState state;
+	return ConfigParseLine(readbuf, push_item, ctx, state);
+}
+
+bool ConfigParseLine(const char* readbuf, const ConfigParseAddFunc& push_item, ConfigParseContext const& ctx, ConfigParseState& state) {
 	auto trim = [](const std::string& s) {
 		// Treat quotes as whitespace when parsing CLI options from files.
 		return StringUtil::trim(s," \t\r\n\"");
@@ -44,14 +50,14 @@ bool ConfigParseLine(const char* readbuf, const ConfigParseAddFunc& push_item, C
 				return 0;
 			}
 
-			if (FILE* fp = fopen(include_fullpath, "rt")) {
-				Defer(fclose(fp));
+			BufferedReader reader({ 64 * 1024 });
+			if (reader.open(include_fullpath)) {
 				log_host("!%s '%s'", isRequired ? "require" : "include", include_fullpath.uni_string().c_str());
-				return ConfigParseFile(fp, push_item, {include_fullpath});
+				return ConfigParseFile(reader, push_item, {include_fullpath});
 			}
 			else {
 				if (isRequired) {
-					auto err = errno;
+					auto err = reader.error();
 					log_error("%s(%d): %s could not be opened for reading: %s",
 						ctx.fullpath.c_str(), ctx.linenum, include_fullpath.uni_string().c_str(),
 						strerror(err)
@@ -64,9 +70,25 @@ bool ConfigParseLine(const char* readbuf, const ConfigParseAddFunc& push_item, C
 		return 1;
 	}
 
+	// INI-style section header: [section]
+	if (line[0] == '[') {
+		if (line.back() != ']') {
+			log_error("%s(%d): expected closing bracket (]): %s", ctx.fullpath.c_str(), ctx.linenum, line.c_str());
+			return 0;
+		}
+		state.section = trim(line.substr(1, line.length() - 2));
+		return 1;
+	}
+
 	auto pos = line.find('=');
 	if (pos != line.npos) {
-		push_item(trim(line.substr(0, pos)), trim(line.substr(pos + 1)));
+		auto lvalue = trim(line.substr(0, pos));
+		if (!state.section.empty()) {
+			// keep leading dashes at the front: --size -> --section.size
+			auto dashes = std::min(lvalue.find_first_not_of('-'), lvalue.length());
+			lvalue.insert(dashes, state.section + '.');
+		}
+		push_item(lvalue, trim(line.substr(pos + 1)));
 		return 1;
 	}
 	else {
@@ -78,12 +100,39 @@ bool ConfigParseLine(const char* readbuf, const ConfigParseAddFunc& push_item, C
 bool ConfigParseFile(FILE* fp, const ConfigParseAddFunc& push_item, ConfigParseContext const& ctx) {
 	char readbuf[2048];
 	auto linenum = 0;
+
+	// one state for the whole file, so that [section] headers carry over to subsequent lines.
+	ConfigParseContext linectx = ctx;
+	ConfigParseState state;
 	while (fgets(readbuf, fp)) {
 		linenum++;
-		if (!ConfigParseLine(readbuf, push_item, { ctx.fullpath, ctx.linenum + linenum })) {
+		linectx.linenum = ctx.linenum + linenum;
+		if (!ConfigParseLine(readbuf, push_item, linectx, state)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+bool ConfigParseFile(BufferedReader& reader, const ConfigParseAddFunc& push_item, ConfigParseContext const& ctx) {
+	std::string_view line;
+	auto linenum = 0;
+
+	ConfigParseContext linectx = ctx;
+	ConfigParseState state;
+	while (reader.readLine(line)) {
+		linenum++;
+		linectx.linenum = ctx.linenum + linenum;
+
+		// views from readLine are NUL-terminated.
+		if (!ConfigParseLine(line.data(), push_item, linectx, state)) {
 			return 0;
 		}
 	}
+	if (reader.error()) {
+		log_error("%s: read error: %s", ctx.fullpath.c_str(), strerror(reader.error()));
+		return 0;
+	}
 	return 1;
 }
 
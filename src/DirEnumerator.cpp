@@ -0,0 +1,241 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "DirEnumerator.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if PLATFORM_LINUX
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <dirent.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#else
+#	include <filesystem>
+#endif
+
+namespace fs {
+
+#if PLATFORM_LINUX
+
+// layout of records returned by getdents64. Declared here since glibc only exposes it via _GNU_SOURCE on
+// newer versions, and the layout is fixed by the kernel ABI.
+struct linux_dirent64 {
+	uint64_t		d_ino;
+	int64_t			d_off;
+	uint16_t		d_reclen;
+	uint8_t			d_type;
+	char			d_name[];
+};
+
+static DirEntryType _typeFromDType(uint8_t d_type) {
+	switch (d_type) {
+		case DT_REG:		return DirEntryType::File;
+		case DT_DIR:		return DirEntryType::Directory;
+		case DT_LNK:		return DirEntryType::Symlink;
+		case DT_UNKNOWN:	return DirEntryType::Unknown;
+	}
+	return DirEntryType::Other;
+}
+
+static DirEntryType _typeFromMode(mode_t mode) {
+	switch (mode & S_IFMT) {
+		case S_IFREG:		return DirEntryType::File;
+		case S_IFDIR:		return DirEntryType::Directory;
+		case S_IFLNK:		return DirEntryType::Symlink;
+	}
+	return DirEntryType::Other;
+}
+
+static bool _isDotOrDotDot(char const* name) {
+	return name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0));
+}
+
+bool DirEnumerator::open(const char* native_dir) {
+	return openat(AT_FDCWD, native_dir);
+}
+
+bool DirEnumerator::openat(int dirfd, const char* name) {
+	close();
+	m_fd = ::openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (m_fd < 0) {
+		m_error = errno;
+		return false;
+	}
+	if (!m_buffer) {
+		m_buffer = std::make_unique<char[]>(m_buffer_size);
+	}
+	return true;
+}
+
+void DirEnumerator::close() {
+	if (m_fd >= 0) {
+		::close(m_fd);
+	}
+	m_fd	= -1;
+	m_pos	= 0;
+	m_end	= 0;
+	m_error	= 0;
+	m_eof	= false;
+}
+
+bool DirEnumerator::is_open() const {
+	return m_fd >= 0;
+}
+
+bool DirEnumerator::_refill() {
+	if (m_eof || m_fd < 0) {
+		return false;
+	}
+	auto result = syscall(SYS_getdents64, m_fd, m_buffer.get(), m_buffer_size);
+	if (result < 0) {
+		m_error = errno;
+		m_eof = true;
+		return false;
+	}
+	m_pos = 0;
+	m_end = (size_t)result;
+	m_eof = (result == 0);
+	return !m_eof;
+}
+
+bool DirEnumerator::next(DirEntry& dest) {
+	for (;;) {
+		if (m_pos >= m_end && !_refill()) {
+			return false;
+		}
+		auto* rec = (linux_dirent64 const*)(m_buffer.get() + m_pos);
+		m_pos += rec->d_reclen;
+		if (_isDotOrDotDot(rec->d_name)) {
+			continue;
+		}
+		dest.name	= rec->d_name;
+		dest.type	= _typeFromDType(rec->d_type);
+		dest.ino	= rec->d_ino;
+		return true;
+	}
+}
+
+int DirEnumerator::next_batch(std::vector<DirEntry>& dest) {
+	dest.clear();
+
+	// a batch may consist of only '.' and '..', so keep reading until something is produced.
+	while (dest.empty()) {
+		if (m_pos >= m_end && !_refill()) {
+			return m_error ? -1 : 0;
+		}
+		while (m_pos < m_end) {
+			auto* rec = (linux_dirent64 const*)(m_buffer.get() + m_pos);
+			m_pos += rec->d_reclen;
+			if (!_isDotOrDotDot(rec->d_name)) {
+				dest.push_back({ rec->d_name, _typeFromDType(rec->d_type), rec->d_ino });
+			}
+		}
+	}
+	return (int)dest.size();
+}
+
+DirEntryType DirEnumerator::resolve_type(DirEntry const& ent) const {
+	if (ent.type != DirEntryType::Unknown) {
+		return ent.type;
+	}
+	struct ::stat st;
+	if (fstatat(m_fd, ent.name.data(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+		return DirEntryType::Unknown;
+	}
+	return _typeFromMode(st.st_mode);
+}
+
+#else
+
+// fallback: the listing is read in full on open, and served from memory.
+
+static DirEntryType _typeFromStatus(std::filesystem::file_status const& status) {
+	switch (status.type()) {
+		case std::filesystem::file_type::regular:	return DirEntryType::File;
+		case std::filesystem::file_type::directory:	return DirEntryType::Directory;
+		case std::filesystem::file_type::symlink:	return DirEntryType::Symlink;
+		case std::filesystem::file_type::unknown:	return DirEntryType::Unknown;
+		default: break;
+	}
+	return DirEntryType::Other;
+}
+
+bool DirEnumerator::open(const char* native_dir) {
+	close();
+
+	std::error_code nothrow_please_kthx;
+	std::filesystem::directory_iterator it(native_dir, nothrow_please_kthx);
+	if (nothrow_please_kthx) {
+		m_error = nothrow_please_kthx.value();
+		return false;
+	}
+
+	for (; it != std::filesystem::directory_iterator(); it.increment(nothrow_please_kthx)) {
+		auto status = it->symlink_status(nothrow_please_kthx);
+		m_fallback.push_back({ it->path().filename().string(), _typeFromStatus(status) });
+	}
+	if (nothrow_please_kthx) {
+		m_error = nothrow_please_kthx.value();
+	}
+	m_fallback_open = true;
+	return true;
+}
+
+void DirEnumerator::close() {
+	m_fallback.clear();
+	m_fallback_open	= false;
+	m_pos			= 0;
+	m_error			= 0;
+	m_eof			= false;
+}
+
+bool DirEnumerator::is_open() const {
+	return m_fallback_open;
+}
+
+bool DirEnumerator::_refill() {
+	return false;
+}
+
+bool DirEnumerator::next(DirEntry& dest) {
+	if (m_pos >= m_fallback.size()) {
+		return false;
+	}
+	auto& ent	= m_fallback[m_pos++];
+	dest.name	= ent.name;
+	dest.type	= ent.type;
+	dest.ino	= 0;
+	return true;
+}
+
+int DirEnumerator::next_batch(std::vector<DirEntry>& dest) {
+	dest.clear();
+	auto batchSize = std::max<size_t>(1, m_buffer_size / 64);
+	DirEntry ent;
+	while (dest.size() < batchSize && next(ent)) {
+		dest.push_back(ent);
+	}
+	return (dest.empty() && m_error) ? -1 : (int)dest.size();
+}
+
+DirEntryType DirEnumerator::resolve_type(DirEntry const& ent) const {
+	return ent.type;
+}
+
+#endif
+
+bool DirEnumerator::open(const fs::path& dir) {
+	return open((const char*)dir);
+}
+
+intmax_t EnumerateDirectory(const fs::path& dir, const std::function<bool(const DirEntry& ent)>& func) {
+	DirEnumerator enumerator;
+	if (!enumerator.open(dir)) {
+		return -1;
+	}
+	return enumerator.forEach(func);
+}
+
+} // namespace fs
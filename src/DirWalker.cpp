@@ -0,0 +1,323 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "DirWalker.h"
+#include "StringUtil.h"
+#include "icy_assert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#if PLATFORM_POSIX
+#	include <sys/stat.h>
+#endif
+
+namespace fs {
+
+struct DirWalkTask {
+	std::string		rel;			// relative path of the directory, empty for the root
+	int				depth;			// depth of the entries within the directory
+};
+
+struct DirWalkQueue {
+	std::mutex					lock;
+	std::deque<DirWalkTask>		tasks;
+};
+
+static bool _beginsWith(std::string_view str, std::string_view prefix) {
+	return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+
+class ParallelDirWalk
+{
+public:
+	const DirWalkOptions&		m_options;
+	const DirWalkSink&			m_sink;
+	std::string					m_root;				// native root path, with trailing separator
+	std::vector<std::string>	m_include_prefixes;	// literal prefix of each include pattern
+
+	std::vector<std::unique_ptr<DirWalkQueue>>	m_queues;
+
+	std::atomic<int64_t>		m_pending	= 0;		// directories queued or being processed
+	std::atomic<int64_t>		m_queued	= 0;		// directories queued and not yet taken by a worker
+	std::atomic<int64_t>		m_reported	= 0;
+
+	// idle workers sleep until work is queued or the walk is done. m_idle counts them, so that pushes
+	// only touch the mutex when someone is waiting.
+	std::mutex					m_idle_mutex;
+	std::condition_variable		m_idle_cv;
+	std::atomic<int>			m_idle		= 0;
+
+#if PLATFORM_POSIX
+	std::mutex								m_visited_mutex;
+	std::set<std::pair<uint64_t, uint64_t>>	m_visited;		// dev/ino of directories, for SymlinkPolicy::Follow
+#endif
+
+	ParallelDirWalk(const fs::path& root, const DirWalkOptions& options, const DirWalkSink& sink, int numThreads)
+		: m_options(options)
+		, m_sink(sink)
+	{
+		m_root = (const char*)root;
+		if (m_root.empty() || m_root.back() != '/') {
+			m_root += '/';
+		}
+
+		for (const auto& pattern : options.include) {
+			m_include_prefixes.push_back(pattern.substr(0, std::min(pattern.find_first_of("*?[\\"), pattern.size())));
+		}
+
+		for (int i = 0; i < numThreads; ++i) {
+			m_queues.push_back(std::make_unique<DirWalkQueue>());
+		}
+	}
+
+	bool _matchesAny(const std::vector<std::string>& patterns, const std::string& rel) const {
+		for (const auto& pattern : patterns) {
+			if (StringUtil::globMatch(pattern.c_str(), rel.c_str())) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool _isIncluded(const std::string& rel) const {
+		return m_options.include.empty() || _matchesAny(m_options.include, rel);
+	}
+
+	// returns TRUE if the directory could contain a match for at least one include pattern.
+	bool _mayContainIncluded(const std::string& rel) const {
+		if (m_include_prefixes.empty()) {
+			return true;
+		}
+		// either the directory lies within the literal portion of the pattern (an ancestor of the matches),
+		// or the literal portion ends within the directory (the wildcards may match beneath it).
+		std::string dir = rel + '/';
+		for (const auto& prefix : m_include_prefixes) {
+			if (_beginsWith(dir, prefix) || _beginsWith(prefix, dir)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// returns FALSE if the directory has already been visited (symlink cycle).
+	bool _markVisited(const std::string& native) {
+#if PLATFORM_POSIX
+		if (m_options.symlinks != SymlinkPolicy::Follow) {
+			return true;
+		}
+		struct ::stat st;
+		if (::stat(native.c_str(), &st) != 0) {
+			return false;
+		}
+		std::lock_guard lock(m_visited_mutex);
+		return m_visited.insert({ (uint64_t)st.st_dev, (uint64_t)st.st_ino }).second;
+#else
+		return true;
+#endif
+	}
+
+	DirEntryType _followSymlink(const std::string& native) const {
+#if PLATFORM_POSIX
+		struct ::stat st;
+		if (::stat(native.c_str(), &st) != 0) {
+			return DirEntryType::Unknown;		// dangling
+		}
+		switch (st.st_mode & S_IFMT) {
+			case S_IFREG:	return DirEntryType::File;
+			case S_IFDIR:	return DirEntryType::Directory;
+		}
+		return DirEntryType::Other;
+#else
+		return DirEntryType::Symlink;
+#endif
+	}
+
+	void _wakeIdle(bool all) {
+		if (m_idle.load() == 0) {
+			return;
+		}
+		// a waiter increments m_idle and checks its predicate under the mutex, so acquiring it here ensures
+		// the waiter is either already asleep (and gets the notify) or has yet to check (and sees the change).
+		{
+			std::lock_guard lock(m_idle_mutex);
+		}
+		if (all) {
+			m_idle_cv.notify_all();
+		}
+		else {
+			m_idle_cv.notify_one();
+		}
+	}
+
+	void push(int self, DirWalkTask&& task) {
+		++m_pending;
+		{
+			std::lock_guard lock(m_queues[self]->lock);
+			m_queues[self]->tasks.push_back(std::move(task));
+		}
+		++m_queued;
+		_wakeIdle(false);
+	}
+
+	bool pop(int self, DirWalkTask& dest) {
+		// own queue is processed LIFO (depth-first, good locality). Stealing takes the oldest task from the
+		// victim, which tends to be the shallowest and thus largest remaining subtree.
+		{
+			auto& own = *m_queues[self];
+			std::lock_guard lock(own.lock);
+			if (!own.tasks.empty()) {
+				dest = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				--m_queued;
+				return true;
+			}
+		}
+		auto count = (int)m_queues.size();
+		for (int i = 1; i < count; ++i) {
+			auto& victim = *m_queues[(self + i) % count];
+			std::lock_guard lock(victim.lock);
+			if (!victim.tasks.empty()) {
+				dest = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				--m_queued;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void process(int self, DirEnumerator& enumerator, std::string& native, const DirWalkTask& task) {
+		native = m_root;
+		native += task.rel;
+		if (!_markVisited(native) || !enumerator.open(native.c_str())) {
+			return;
+		}
+
+		std::string rel;
+		enumerator.forEach([&](const DirEntry& ent) {
+			rel = task.rel;
+			if (!rel.empty()) {
+				rel += '/';
+			}
+			rel += ent.name;
+
+			if (!m_options.exclude.empty() && _matchesAny(m_options.exclude, rel)) {
+				return;
+			}
+
+			auto type = enumerator.resolve_type(ent);
+			if (type == DirEntryType::Symlink) {
+				if (m_options.symlinks == SymlinkPolicy::Ignore) {
+					return;
+				}
+				if (m_options.symlinks == SymlinkPolicy::Follow) {
+					type = _followSymlink(m_root + rel);
+				}
+			}
+
+			if (type == DirEntryType::Directory) {
+				bool withinDepth = m_options.max_depth < 0 || task.depth < m_options.max_depth;
+				if (withinDepth && _mayContainIncluded(rel)) {
+					push(self, { rel, task.depth + 1 });
+				}
+				if (!m_options.report_dirs) {
+					return;
+				}
+			}
+
+			if (_isIncluded(rel)) {
+				DirWalkEntry out;
+				out.rel_path	= rel;
+				out.name		= std::string_view(rel).substr(rel.size() - ent.name.size());
+				out.type		= type;
+				out.depth		= task.depth;
+				m_sink(self, out);
+				++m_reported;
+			}
+		});
+	}
+
+	void worker(int self) {
+		DirEnumerator enumerator;
+		std::string native;
+		DirWalkTask task;
+
+		for (;;) {
+			if (pop(self, task)) {
+				process(self, enumerator, native, task);
+				if (--m_pending == 0) {
+					_wakeIdle(true);
+				}
+				continue;
+			}
+			if (m_pending.load() == 0) {
+				break;
+			}
+
+			std::unique_lock lock(m_idle_mutex);
+			++m_idle;
+			m_idle_cv.wait(lock, [&] { return m_queued.load() > 0 || m_pending.load() == 0; });
+			--m_idle;
+		}
+	}
+
+	intmax_t run() {
+		push(0, { {}, 0 });
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < (int)m_queues.size(); ++i) {
+			threads.emplace_back([this, i] { worker(i); });
+		}
+		worker(0);
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		return m_reported.load();
+	}
+};
+
+int DirWalkThreadCount(const DirWalkOptions& options) {
+	if (options.num_threads > 0) {
+		return options.num_threads;
+	}
+	return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+intmax_t WalkDirectoryParallel(const fs::path& root, const DirWalkOptions& options, const DirWalkSink& sink) {
+	if (!fs::is_directory(root)) {
+		return -1;
+	}
+	ParallelDirWalk walk(root, options, sink, DirWalkThreadCount(options));
+	return walk.run();
+}
+
+std::vector<DirWalkResult> WalkDirectorySorted(const fs::path& root, const DirWalkOptions& options) {
+	std::vector<std::vector<DirWalkResult>> perThread(DirWalkThreadCount(options));
+
+	WalkDirectoryParallel(root, options, [&](int threadIndex, const DirWalkEntry& ent) {
+		perThread[threadIndex].push_back({ std::string(ent.rel_path), ent.type });
+	});
+
+	size_t total = 0;
+	for (const auto& list : perThread) {
+		total += list.size();
+	}
+
+	std::vector<DirWalkResult> result;
+	result.reserve(total);
+	for (auto& list : perThread) {
+		std::move(list.begin(), list.end(), std::back_inserter(result));
+	}
+	std::sort(result.begin(), result.end(), [](const DirWalkResult& a, const DirWalkResult& b) {
+		return a.rel_path < b.rel_path;
+	});
+	return result;
+}
+
+} // namespace fs
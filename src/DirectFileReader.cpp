@@ -0,0 +1,182 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "DirectFileReader.h"
+#include "icy_log.h"
+#include "icy_assert.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if !defined(O_CLOEXEC)
+#	define O_CLOEXEC	(0)
+#endif
+
+#if PLATFORM_MAC
+static constexpr bool kDirectNeedsAlignment = false;		// F_NOCACHE has no alignment requirements
+#else
+static constexpr bool kDirectNeedsAlignment = true;
+#endif
+
+static bool _isAligned(uintptr_t val) {
+	return (val & (kDirectIOAlignment - 1)) == 0;
+}
+
+static size_t _alignDown(size_t val) {
+	return val & ~(kDirectIOAlignment - 1);
+}
+
+static size_t _alignUp(size_t val) {
+	return _alignDown(val + kDirectIOAlignment - 1);
+}
+
+DirectFileReader::DirectFileReader(const DirectFileReaderOptions& options)
+	: m_options(options)
+	, m_bounce(std::max(_alignUp(options.bounce_size), kDirectIOAlignment))
+{
+}
+
+DirectFileReader::~DirectFileReader() {
+	close();
+}
+
+bool DirectFileReader::open(const char* path) {
+	close();
+
+	m_fd = ::posix_open(path, O_RDONLY | O_CLOEXEC, 0);
+	if (m_fd < 0) {
+		m_error = errno;
+		return false;
+	}
+
+	auto st = posix_fstat(m_fd);
+	m_size	= st.st_size;
+	m_error	= 0;
+
+	// the file is opened buffered and switched over afterward, so that small files never pay for direct
+	// reads, and so that filesystems refusing O_DIRECT are handled the same as small files.
+	if (m_options.direct && (size_t)m_size >= m_options.direct_threshold) {
+		_setDirect(true);
+	}
+	return true;
+}
+
+void DirectFileReader::close() {
+	if (m_fd >= 0) {
+		::posix_close(m_fd);
+	}
+	m_fd		= -1;
+	m_size		= 0;
+	m_direct	= false;
+}
+
+bool DirectFileReader::_setDirect(bool enable) {
+#if PLATFORM_MAC
+	m_direct = enable && fcntl(m_fd, F_NOCACHE, 1) == 0;
+	if (!enable) {
+		fcntl(m_fd, F_NOCACHE, 0);
+	}
+	return m_direct == enable;
+#elif PLATFORM_POSIX
+	if (!posix_O_DIRECT) {
+		m_direct = false;
+		return !enable;
+	}
+	int flags = fcntl(m_fd, F_GETFL);
+	if (flags < 0) {
+		return false;
+	}
+	flags = enable ? (flags | posix_O_DIRECT) : (flags & ~posix_O_DIRECT);
+	if (fcntl(m_fd, F_SETFL, flags) != 0) {
+		return false;		// EINVAL: not supported by the filesystem.
+	}
+	m_direct = enable;
+	return true;
+#else
+	m_direct = false;
+	return !enable;
+#endif
+}
+
+intmax_t DirectFileReader::_pread(void* dest, size_t size, x_off_t offset) {
+	for (;;) {
+		auto result = (intmax_t)posix_pread(m_fd, dest, size, offset);
+		if (result >= 0 || errno != EINTR) {
+			return result;
+		}
+	}
+}
+
+// reads the aligned blocks spanning [offset, offset+size) into the bounce buffer, and copies out the
+// requested part. size is at most what the bounce buffer can hold once aligned.
+intmax_t DirectFileReader::_readBounced(uint8_t* dest, size_t size, x_off_t offset) {
+	auto alignedOffset	= (x_off_t)_alignDown((size_t)offset);
+	auto lead			= (size_t)(offset - alignedOffset);
+	auto want			= std::min(_alignUp(lead + size), m_bounce.size());
+
+	auto result = _pread(m_bounce.data(), want, alignedOffset);
+	if (result < 0) {
+		return result;
+	}
+	auto avail	= ((size_t)result > lead) ? (size_t)result - lead : 0;
+	auto amount	= std::min(avail, size);
+	memcpy(dest, m_bounce.data() + lead, amount);
+	return (intmax_t)amount;
+}
+
+intmax_t DirectFileReader::read(void* dest, size_t size, x_off_t offset) {
+	if (m_fd < 0) {
+		m_error = EBADF;
+		return -1;
+	}
+
+	if (!m_direct || !kDirectNeedsAlignment) {
+		auto result = _pread(dest, size, offset);
+		if (result < 0) {
+			m_error = errno;
+		}
+		return result;
+	}
+
+	auto* out	= (uint8_t*)dest;
+	size_t total = 0;
+
+	while (total < size) {
+		auto remain = size - total;
+		intmax_t result;
+		size_t expected;
+
+		if (_isAligned((uintptr_t)out) && _isAligned((uintptr_t)offset) && remain >= kDirectIOAlignment) {
+			// aligned: read straight into the caller's buffer.
+			expected	= _alignDown(remain);
+			result		= _pread(out, expected, offset);
+		}
+		else {
+			// unaligned head or tail: via the bounce buffer. The copied amount may be less than requested
+			// when the bounce buffer is smaller than the remaining request, so compare against that.
+			auto lead	= (size_t)(offset & (kDirectIOAlignment - 1));
+			expected	= std::min(remain, m_bounce.size() - lead);
+			result		= _readBounced(out, expected, offset);
+		}
+
+		if (result < 0) {
+			if (errno == EINVAL && total == 0 && _setDirect(false)) {
+				// some filesystems accept O_DIRECT at open but reject the reads themselves (eg. a block size
+				// larger than our alignment). Drop to buffered reads for the rest of this file.
+				log_host("DirectFileReader: direct read rejected (EINVAL), reverting to buffered reads.");
+				return read(dest, size, offset);
+			}
+			m_error = errno;
+			return total ? (intmax_t)total : -1;
+		}
+
+		total	+= (size_t)result;
+		out		+= result;
+		offset	+= result;
+
+		if ((size_t)result < expected) {
+			break;		// end of file
+		}
+	}
+	return (intmax_t)total;
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "EnvironUtil.h"
+#include "FlatStringMap.h"
+
+#include <cstdlib>
+#include <cctype>
+#include <string>
+
+#if PLATFORM_MSW
+#	define posix_environ _environ
+#elif PLATFORM_HAS_GETENV
+extern char** environ;
+#	define posix_environ environ
+#endif
+
+static void _buildSnapshot(FlatStringMap& map) {
+	map.clear();
+
+#if PLATFORM_HAS_GETENV
+	if (!posix_environ) {
+		return;
+	}
+
+	for (char** walk = posix_environ; *walk; ++walk) {
+		std::string_view entry = *walk;
+
+		// start at 1: Windows has hidden per-drive variables that start with '=', eg. "=C:=C:\foo"
+		auto pos = entry.find('=', 1);
+		if (pos == entry.npos) {
+			continue;
+		}
+
+		auto name = entry.substr(0, pos);
+#if PLATFORM_MSW
+		std::string upper(name);
+		for (auto& ch : upper) ch = (char)toupper((uint8_t)ch);
+		name = upper;
+#endif
+		// first definition wins, same as getenv.
+		if (!map.contains(name)) {
+			map.set(name, entry.substr(pos + 1));
+		}
+	}
+#endif
+}
+
+static FlatStringMap& _snapshot() {
+	static FlatStringMap s_snapshot = []() {
+		FlatStringMap map;
+		_buildSnapshot(map);
+		return map;
+	}();
+	return s_snapshot;
+}
+
+void EnvironSnapshotRefresh() {
+	_buildSnapshot(_snapshot());
+}
+
+bool EnvironSnapshotLookup(std::string_view name, std::string_view& outValue) {
+#if PLATFORM_MSW
+	std::string upper(name);
+	for (auto& ch : upper) ch = (char)toupper((uint8_t)ch);
+	return _snapshot().lookup(upper, outValue);
+#else
+	return _snapshot().lookup(name, outValue);
+#endif
+}
+
+char const* EnvironSnapshotGet(std::string_view name) {
+	std::string_view value;
+	return EnvironSnapshotLookup(name, value) ? value.data() : nullptr;
+}
+
+void EnvironSnapshotForEach(std::function<void(std::string_view name, std::string_view value)> const& func) {
+	_snapshot().forEach(func);
+}
@@ -0,0 +1,539 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "FileWatcher.h"
+#include "DirEnumerator.h"
+#include "icy_log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if PLATFORM_LINUX
+#	include <sys/inotify.h>
+
+static constexpr uint32_t kWatcherMask =
+	IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO |
+	IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+#endif
+
+static std::string _nativePath(const fs::path& path) {
+	return (const char*)path.lexically_normal();
+}
+
+static bool _isWithin(const std::string& path, const std::string& dir) {
+	if (dir == ".") {
+		return !path.empty() && path != "." && path[0] != '/' && path != ".." && !path.starts_with("../");
+	}
+	if (dir.back() == '/') {
+		return path.size() > dir.size() && path.starts_with(dir);
+	}
+	return path.size() > dir.size() && path.compare(0, dir.size(), dir) == 0 && path[dir.size()] == '/';
+}
+
+FileWatcher::FileWatcher(Callback callback, const FileWatcherOptions& options)
+	: m_callback(std::move(callback))
+	, m_options(options)
+{
+	// open() logs why, where inotify exists but fails.
+	m_polling = options.force_polling || !m_inotify.open("FileWatcher");
+
+	if (m_polling) {
+		m_thread = std::thread([this] { _pollThread(); });
+	}
+	else {
+		m_thread = std::thread([this] { _notifyThread(); });
+	}
+}
+
+FileWatcher::~FileWatcher() {
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopping = true;
+	}
+	_wake();
+	m_thread.join();
+}
+
+void FileWatcher::_wake() {
+	if (!m_polling) {
+		m_inotify.wake();
+		return;
+	}
+	m_cv.notify_all();
+}
+
+size_t FileWatcher::TrackedFiles() const {
+	std::lock_guard lock(m_mutex);
+	return m_files.size();
+}
+
+// records the current state of a file without reporting it.
+void FileWatcher::_track(const std::string& path, bool report) {
+	if (report) {
+		m_pending.insert(path);
+		return;
+	}
+	auto st = posix_stat(path.c_str());
+	FileState state;
+	state.exists	= st.Exists() && !st.IsDir();
+	state.info		= state.exists ? st.getModificationInfo() : CStatModInfo{};
+	m_files.insert_or_assign(path, state);
+}
+
+// returns the watch descriptor, or -1 if the dir cannot be watched (or when polling).
+int FileWatcher::_addWatch(const std::string& dir, bool tree) {
+	if (tree) {
+		m_tree_dirs.insert(dir);
+	}
+#if PLATFORM_LINUX
+	if (m_polling) {
+		return -1;
+	}
+	if (auto it = m_dir_wds.find(dir); it != m_dir_wds.end()) {
+		return it->second;
+	}
+	int wd = m_inotify.addWatch(dir.c_str(), kWatcherMask);
+	if (wd < 0) {
+		// missing dirs are expected, and handled by watching an ancestor (see _arm). Anything else (eg.
+		// the watch limit) is logged once, until the dir can be watched again.
+		if (errno != ENOENT && errno != ENOTDIR && m_unwatchable.insert(dir).second) {
+			log_error("FileWatcher: cannot watch '%s', code=%d (%s). Changes within it are detected by polling.", dir.c_str(), errno, strerror(errno));
+		}
+		return -1;
+	}
+	m_unwatchable.erase(dir);
+	m_wd_dirs[wd]	= dir;
+	m_dir_wds[dir]	= wd;
+	return wd;
+#else
+	return -1;
+#endif
+}
+
+// watches a dir and its subdirs, and tracks the files within them. If report, the files are reported as
+// created in the next batch (for dirs which appear after registration). Returns TRUE if every dir is
+// being watched.
+bool FileWatcher::_addTree(const std::string& dir, bool report) {
+	// the watch is added before listing, so that no file created in between goes unnoticed.
+	bool watched = _addWatch(dir, true) >= 0;
+
+	std::vector<std::string> subdirs;
+	fs::DirEnumerator enumerator;
+	if (!enumerator.open(dir.c_str())) {
+		return false;
+	}
+	enumerator.forEach([&](const fs::DirEntry& ent) {
+		auto type = (ent.type == fs::DirEntryType::Unknown) ? enumerator.resolve_type(ent) : ent.type;
+		if (type == fs::DirEntryType::File) {
+			_track(native_child_path(dir, ent.name), report);
+		}
+		elif (type == fs::DirEntryType::Directory) {
+			subdirs.push_back(native_child_path(dir, ent.name));
+		}
+	});
+	enumerator.close();
+
+	for (auto& subdir : subdirs) {
+		watched &= _addTree(subdir, report);
+	}
+	return watched;
+}
+
+// establishes the watches a registration depends on, and tracks the files it covers (or if report,
+// queues them so that they are reported). If its dir does not exist, the nearest existing ancestor is
+// watched instead, so that the dir's creation re-arms the registration via _rearm. Registrations which
+// remain unarmed are polled, see _pollUnarmed. Returns TRUE if armed.
+bool FileWatcher::_arm(Registration& reg, bool report) {
+	auto dir = reg.tree ? reg.path : native_parent_dir(reg.path);
+	std::string ancestor;
+	for (;;) {
+		if (reg.tree) {
+			reg.armed = posix_stat(dir.c_str()).IsDir() && _addTree(dir, report);
+		}
+		else {
+			reg.armed = _addWatch(dir, false) >= 0;
+			_track(reg.path, report);
+		}
+		if (reg.armed || m_polling || posix_stat(dir.c_str()).IsDir()) {
+			return reg.armed;
+		}
+
+		// the ancestor is watched before checking the dir again, so that it cannot appear unnoticed in
+		// between. Stops once no deeper ancestor has appeared.
+		auto existing = dir;
+		do {
+			existing = native_parent_dir(existing);
+		} while (existing != "/" && existing != "." && !posix_stat(existing.c_str()).IsDir());
+
+		if (existing == ancestor || _addWatch(existing, false) < 0) {
+			return false;
+		}
+		ancestor = existing;
+	}
+}
+
+// re-arms the registrations whose dir is dir or lies within it, after dir has appeared or disappeared.
+// Registrations which are armed, and still hold the watch on their dir, are left as they are. Returns
+// TRUE if any registration was affected.
+bool FileWatcher::_rearm(const std::string& dir) {
+	bool affected = false;
+	for (auto& [id, reg] : m_registrations) {
+		auto regDir = reg.tree ? reg.path : native_parent_dir(reg.path);
+		if (regDir != dir && !_isWithin(regDir, dir)) {
+			continue;
+		}
+		if (reg.armed && m_dir_wds.count(regDir)) {
+			continue;
+		}
+		_arm(reg, true);
+		affected = true;
+	}
+	return affected;
+}
+
+// forgets the watches on dir and on everything within it, which would otherwise keep reporting under
+// stale paths if the dir was moved, and queues the files within it to be re-checked. ignoredWd has been
+// removed by the kernel already. Returns TRUE if any files are affected.
+bool FileWatcher::_dropWatches(const std::string& dir, int ignoredWd) {
+	std::vector<int> stale;
+	for (auto& [subdir, wd] : m_dir_wds) {
+		if (subdir == dir || _isWithin(subdir, dir)) {
+			stale.push_back(wd);
+		}
+	}
+	for (auto wd : stale) {
+		if (wd != ignoredWd) {
+			m_inotify.removeWatch(wd);
+		}
+		m_dir_wds.erase(m_wd_dirs[wd]);
+		m_wd_dirs.erase(wd);
+	}
+	std::erase_if(m_tree_dirs, [&](const std::string& subdir) { return subdir == dir || _isWithin(subdir, dir); });
+
+	bool affected = false;
+	for (auto& [path, state] : m_files) {
+		if (_isWithin(path, dir)) {
+			m_pending.insert(path);
+			affected = true;
+		}
+	}
+	return affected;
+}
+
+bool FileWatcher::_hasUnarmed() const {
+	return std::any_of(m_registrations.begin(), m_registrations.end(), [](const auto& item) { return !item.second.armed; });
+}
+
+// registrations which could not be armed are polled: the files they cover are re-checked, and arming is
+// retried, which also picks up files created meanwhile.
+void FileWatcher::_pollUnarmed() {
+	for (auto& [id, reg] : m_registrations) {
+		if (reg.armed) {
+			continue;
+		}
+		for (auto& [path, state] : m_files) {
+			if (path == reg.path || _isWithin(path, reg.path)) {
+				m_pending.insert(path);
+			}
+		}
+		_arm(reg, true);
+	}
+}
+
+FileWatcher::WatchId FileWatcher::WatchFile(const fs::path& path) {
+	auto native = _nativePath(path);
+
+	std::lock_guard lock(m_mutex);
+	auto id		= m_next_id++;
+	auto& reg	= m_registrations[id];
+	reg			= { native, false };
+	m_explicit.insert(native);
+
+	// a file which is already tracked (within a tree) keeps its last reported state.
+	if (!_arm(reg, m_files.count(native) != 0) && !m_polling) {
+		_wake();		// so that the notify thread starts polling
+	}
+	return id;
+}
+
+FileWatcher::WatchId FileWatcher::WatchTree(const fs::path& dir) {
+	auto native = _nativePath(dir);
+	auto st = posix_stat(native.c_str());
+	if (st.Exists() && !st.IsDir()) {
+		log_error("FileWatcher: '%s' is not a directory", native.c_str());
+		return -1;
+	}
+
+	std::lock_guard lock(m_mutex);
+	auto id		= m_next_id++;
+	auto& reg	= m_registrations[id];
+	reg			= { native, true };
+	if (!_arm(reg, false) && !m_polling) {
+		_wake();
+	}
+	return id;
+}
+
+bool FileWatcher::Unwatch(WatchId id) {
+	std::lock_guard lock(m_mutex);
+	if (!m_registrations.erase(id)) {
+		return false;
+	}
+	_rebuild();
+	return true;
+}
+
+// re-establishes all watches from the registrations. Files which remain covered keep their last reported
+// state, and are re-checked in the next batch, so that changes made meanwhile are still reported.
+void FileWatcher::_rebuild() {
+	for (auto& [wd, dir] : m_wd_dirs) {
+		m_inotify.removeWatch(wd);
+	}
+	m_wd_dirs.clear();
+	m_dir_wds.clear();
+	m_tree_dirs.clear();
+	m_explicit.clear();
+
+	auto previous = std::move(m_files);
+	m_files.clear();
+
+	for (auto& [id, reg] : m_registrations) {
+		if (!reg.tree) {
+			m_explicit.insert(reg.path);
+		}
+		_arm(reg, false);
+	}
+
+	for (auto& [path, state] : m_files) {
+		if (auto it = previous.find(path); it != previous.end()) {
+			state = it->second;
+			m_pending.insert(path);
+		}
+	}
+	std::erase_if(m_pending, [&](const std::string& path) { return !m_files.count(path) && !m_tree_dirs.count(native_parent_dir(path)); });
+	_wake();
+}
+
+// re-checks everything: tracked files, and files which have appeared in trees.
+void FileWatcher::_rescan() {
+	for (auto& [path, state] : m_files) {
+		m_pending.insert(path);
+	}
+	for (auto& [id, reg] : m_registrations) {
+		_arm(reg, true);
+	}
+}
+
+// stats every pending path, and produces change records for those whose state differs from the last
+// reported state.
+void FileWatcher::_collect(std::vector<FileChange>& dest) {
+	for (auto& path : m_pending) {
+		auto st		= posix_stat(path.c_str());
+		bool exists	= st.Exists() && !st.IsDir();
+		auto info	= exists ? st.getModificationInfo() : CStatModInfo{};
+
+		auto it = m_files.find(path);
+		bool existed = (it != m_files.end()) && it->second.exists;
+
+		if (!existed && !exists) {
+			continue;
+		}
+
+		FileChangeKind kind;
+		if (!existed) {
+			kind = FileChangeKind::Created;
+		}
+		elif (!exists) {
+			kind = FileChangeKind::Removed;
+		}
+		elif (info != it->second.info) {
+			kind = FileChangeKind::Modified;
+		}
+		else {
+			continue;
+		}
+
+		dest.push_back({ fs::path(path), kind, existed ? it->second.info : CStatModInfo{}, info });
+
+		if (!exists && !m_explicit.count(path)) {
+			m_files.erase(it);
+		}
+		else {
+			m_files.insert_or_assign(path, FileState{ info, exists });
+		}
+	}
+	m_pending.clear();
+}
+
+// returns TRUE if the event affects a file of interest.
+bool FileWatcher::_handleEvent(int wd, uint32_t mask, const char* name) {
+#if PLATFORM_LINUX
+	if (mask & IN_Q_OVERFLOW) {
+		// events were lost: everything must be re-checked.
+		_rescan();
+		return true;
+	}
+
+	auto it = m_wd_dirs.find(wd);
+	if (it == m_wd_dirs.end()) {
+		return false;
+	}
+	auto dir = it->second;
+
+	if (mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+		// the dir is gone (or now elsewhere, where its paths would be wrong). Files within it are re-checked,
+		// which reports them as removed. Registrations which depend on it remain in effect: they are
+		// watched as before if the dir already exists again, or else wait for it via an ancestor.
+		bool affected = _dropWatches(dir, (mask & IN_IGNORED) ? wd : -1);
+		return _rearm(dir) || affected;
+	}
+
+	if (!name || !name[0]) {
+		return false;
+	}
+
+	auto path		= native_child_path(dir, name);
+	bool inTree		= m_tree_dirs.count(dir) != 0;
+
+	if (mask & IN_ISDIR) {
+		if (mask & (IN_CREATE | IN_MOVED_TO)) {
+			// may be the (re)appearance of a registration's dir, or of an ancestor of one.
+			bool affected = _rearm(path);
+			if (inTree) {
+				if (!_addTree(path, true)) {
+					for (auto& [id, reg] : m_registrations) {
+						if (reg.tree && _isWithin(path, reg.path)) {
+							reg.armed = false;
+						}
+					}
+				}
+				affected = true;
+			}
+			return affected;
+		}
+		if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+			bool affected = _dropWatches(path, -1);
+			return _rearm(path) || affected || inTree;
+		}
+		return false;
+	}
+
+	if (inTree || m_explicit.count(path)) {
+		m_pending.insert(path);
+		return true;
+	}
+#endif
+	return false;
+}
+
+void FileWatcher::_notifyThread() {
+	using clock = std::chrono::steady_clock;
+
+	bool				pending	= false;
+	clock::time_point	first, last;
+	clock::time_point	nextPoll;		// of unarmed registrations, see _pollUnarmed
+
+	auto markPending = [&] {
+		auto now = clock::now();
+		if (!pending) {
+			first	= now;
+			pending	= true;
+		}
+		last = now;
+	};
+
+	for (;;) {
+		// no timeout while idle, so the thread costs nothing until an event arrives.
+		int timeout = -1;
+		if (pending) {
+			auto due	= std::min(last + m_options.coalesce, first + m_options.max_delay);
+			auto remain	= std::chrono::ceil<std::chrono::milliseconds>(due - clock::now()).count();
+			timeout		= (int)std::max<intmax_t>(remain, 0);
+		}
+
+		bool polling;
+		{
+			std::lock_guard lock(m_mutex);
+			polling = _hasUnarmed();
+		}
+		if (!polling) {
+			nextPoll = {};
+		}
+		else {
+			if (nextPoll == clock::time_point{}) {
+				nextPoll = clock::now() + m_options.poll_interval;
+			}
+			auto remain	= std::chrono::ceil<std::chrono::milliseconds>(nextPoll - clock::now()).count();
+			auto wait	= (int)std::max<intmax_t>(remain, 0);
+			timeout		= (timeout < 0) ? wait : std::min(timeout, wait);
+		}
+
+		InotifyReady ready;
+		if (!m_inotify.wait(timeout, ready)) {
+			log_error("FileWatcher: changes will no longer be detected.");
+			return;
+		}
+
+		if (ready.woken) {
+			std::lock_guard lock(m_mutex);
+			if (m_stopping) {
+				return;
+			}
+			if (!m_pending.empty()) {
+				markPending();
+			}
+		}
+
+		if (ready.events) {
+			bool affected = false;
+			std::lock_guard lock(m_mutex);
+			m_inotify.readEvents([&](int wd, uint32_t mask, const char* name) {
+				affected |= _handleEvent(wd, mask, name);
+			});
+			if (affected) {
+				markPending();
+			}
+		}
+
+		if (polling && clock::now() >= nextPoll) {
+			nextPoll = clock::now() + m_options.poll_interval;
+			std::lock_guard lock(m_mutex);
+			_pollUnarmed();
+			if (!m_pending.empty()) {
+				markPending();
+			}
+		}
+
+		if (pending && clock::now() >= std::min(last + m_options.coalesce, first + m_options.max_delay)) {
+			pending = false;
+			std::vector<FileChange> changes;
+			{
+				std::lock_guard lock(m_mutex);
+				_collect(changes);
+			}
+			if (!changes.empty()) {
+				m_callback(changes);
+			}
+		}
+	}
+}
+
+void FileWatcher::_pollThread() {
+	std::unique_lock lock(m_mutex);
+	for (;;) {
+		m_cv.wait_for(lock, m_options.poll_interval, [&] { return m_stopping; });
+		if (m_stopping) {
+			return;
+		}
+
+		_rescan();
+
+		std::vector<FileChange> changes;
+		_collect(changes);
+		if (!changes.empty()) {
+			lock.unlock();
+			m_callback(changes);
+			lock.lock();
+		}
+	}
+}
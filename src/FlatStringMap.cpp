@@ -0,0 +1,238 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "FlatStringMap.h"
+#include "StringUtil.h"
+#include "icy_assert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+uint32_t FlatStringMapHash(std::string_view key) {
+	// djb2 (see hash() in StringUtil.h) has weak low bits for short keys that differ only in their last
+	// character, which is the common case for settings names. Power-of-two tables index using low bits,
+	// so run the result through the murmur3 finalizer to spread the entropy around.
+	uint32_t h = hash(key);
+	h ^= h >> 16;
+	h *= 0x85eb'ca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2'ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+uint32_t FlatStringMapProbe(
+	FlatStringMapSlot  const* slots, uint32_t slotMask,
+	FlatStringMapEntry const* entries, char const* arena,
+	std::string_view key, uint32_t hash
+) {
+	if (!slots) {
+		return kFlatMapNotFound;
+	}
+
+	// the table always keeps at least one empty slot (load factor is capped), so this terminates.
+	for (uint32_t pos = hash & slotMask; ; pos = (pos + 1) & slotMask) {
+		auto const& slot = slots[pos];
+		if (slot.index == 0) {
+			return kFlatMapNotFound;
+		}
+		if (slot.index == kFlatMapTombstone || slot.hash != hash) {
+			continue;
+		}
+		auto const& entry = entries[slot.index - 1];
+		if (entry.key_length == key.size() && (key.empty() || memcmp(arena + entry.key_offset, key.data(), key.size()) == 0)) {
+			return slot.index - 1;
+		}
+	}
+}
+
+static size_t _slotCountFor(size_t count) {
+	// keep load factor at or below 50% after a rehash, so that the table has room to absorb inserts
+	// before the next rehash (which is triggered at 75%).
+	size_t slots = 16;
+	while (slots < count * 2) {
+		slots *= 2;
+	}
+	return slots;
+}
+
+void FlatStringMap::clear() {
+	m_slots.clear();
+	m_entries.clear();
+	m_arena.clear();
+	m_count			= 0;
+	m_tombstones	= 0;
+	m_garbage		= 0;
+}
+
+void FlatStringMap::reserve(size_t count) {
+	if (auto slotCount = _slotCountFor(count); slotCount > m_slots.size()) {
+		_rehash(slotCount);
+	}
+	m_entries.reserve(count);
+}
+
+FlatStringMap::Entry const* FlatStringMap::find(std::string_view key) const {
+	auto idx = FlatStringMapProbe(slots(), slot_mask(), m_entries.data(), m_arena.data(), key, FlatStringMapHash(key));
+	return (idx == kFlatMapNotFound) ? nullptr : &m_entries[idx];
+}
+
+bool FlatStringMap::lookup(std::string_view key, std::string_view& outValue) const {
+	if (auto* entry = find(key)) {
+		outValue = value_of(*entry);
+		return true;
+	}
+	return false;
+}
+
+uint32_t FlatStringMap::_append(std::string_view str) {
+	auto offset = m_arena.size();
+	assertD(offset + str.size() + 1 < kFlatMapTombstone, "FlatStringMap arena exceeds 4GB.");
+	m_arena.resize(offset + str.size() + 1);
+	if (!str.empty()) {
+		memcpy(&m_arena[offset], str.data(), str.size());
+	}
+	m_arena[offset + str.size()] = 0;
+	return (uint32_t)offset;
+}
+
+bool FlatStringMap::set(std::string_view key, std::string_view value) {
+	// guard against callers passing views into our own arena (eg. copying one key to another), since
+	// appending to the arena may reallocate it out from under them.
+	auto aliases = [&](std::string_view sv) {
+		return !m_arena.empty() && sv.data() >= m_arena.data() && sv.data() < m_arena.data() + m_arena.size();
+	};
+	if (expect_false(aliases(key) || aliases(value))) {
+		std::string keycopy(key), valcopy(value);
+		return set(keycopy, valcopy);
+	}
+
+	auto h = FlatStringMapHash(key);
+	if (auto idx = FlatStringMapProbe(slots(), slot_mask(), m_entries.data(), m_arena.data(), key, h); idx != kFlatMapNotFound) {
+		auto& entry = m_entries[idx];
+		if (value_of(entry) == value) {
+			return false;
+		}
+
+		if (value.size() <= entry.val_length) {
+			// shrinking or same-size values are overwritten in-place.
+			if (!value.empty()) {
+				memcpy(&m_arena[entry.val_offset], value.data(), value.size());
+			}
+			m_arena[entry.val_offset + value.size()] = 0;
+			m_garbage += entry.val_length - (uint32_t)value.size();
+			entry.val_length = (uint32_t)value.size();
+		}
+		else {
+			m_garbage += entry.val_length + 1;
+			entry.val_offset = _append(value);
+			entry.val_length = (uint32_t)value.size();
+		}
+
+		if (m_garbage > 4096 && m_garbage > m_arena.size() / 2) {
+			compact();
+		}
+		return true;
+	}
+
+	if ((m_count + m_tombstones + 1) * 4 > m_slots.size() * 3) {
+		_rehash(_slotCountFor(m_count + 1));
+	}
+
+	Entry entry;
+	entry.hash			= h;
+	entry.key_offset	= _append(key);
+	entry.key_length	= (uint32_t)key.size();
+	entry.val_offset	= _append(value);
+	entry.val_length	= (uint32_t)value.size();
+
+	m_entries.push_back(entry);
+	_insert_slot(h, uint32_t(m_entries.size() - 1));
+	++m_count;
+	return true;
+}
+
+bool FlatStringMap::erase(std::string_view key) {
+	if (m_slots.empty()) {
+		return false;
+	}
+
+	auto h    = FlatStringMapHash(key);
+	auto mask = slot_mask();
+	for (uint32_t pos = h & mask; ; pos = (pos + 1) & mask) {
+		auto& slot = m_slots[pos];
+		if (slot.index == 0) {
+			return false;
+		}
+		if (slot.index == kFlatMapTombstone || slot.hash != h) {
+			continue;
+		}
+
+		auto& entry = m_entries[slot.index - 1];
+		if (key_of(entry) != key) {
+			continue;
+		}
+
+		m_garbage += entry.key_length + entry.val_length + 2;
+		entry.key_offset = kFlatMapTombstone;
+		slot.index = kFlatMapTombstone;
+		++m_tombstones;
+		--m_count;
+
+		if (m_count == 0) {
+			clear();
+		}
+		elif (m_garbage > 4096 && m_garbage > m_arena.size() / 2) {
+			compact();
+		}
+		return true;
+	}
+}
+
+void FlatStringMap::compact() {
+	if (m_garbage || m_tombstones || m_entries.size() != m_count) {
+		_rehash(std::max(m_slots.size(), _slotCountFor(m_count)));
+	}
+}
+
+void FlatStringMap::_insert_slot(uint32_t hash, uint32_t entryIndex) {
+	auto mask = slot_mask();
+	for (uint32_t pos = hash & mask; ; pos = (pos + 1) & mask) {
+		auto& slot = m_slots[pos];
+		if (slot.index == 0 || slot.index == kFlatMapTombstone) {
+			m_tombstones -= (slot.index == kFlatMapTombstone);
+			slot.hash  = hash;
+			slot.index = entryIndex + 1;
+			return;
+		}
+	}
+}
+
+// rebuilds the slot table, and compacts the entry list and arena in the process.
+void FlatStringMap::_rehash(size_t slotCount) {
+	std::vector<Entry> entries;
+	std::vector<char>  arena;
+	entries.reserve(std::max<size_t>(m_count, m_entries.capacity()));
+	arena  .reserve(m_arena.size() - m_garbage);
+
+	for (auto const& src : m_entries) {
+		if (src.key_offset == kFlatMapTombstone) continue;
+
+		Entry dst = src;
+		dst.key_offset = (uint32_t)arena.size();
+		arena.insert(arena.end(), m_arena.data() + src.key_offset, m_arena.data() + src.key_offset + src.key_length + 1);
+		dst.val_offset = (uint32_t)arena.size();
+		arena.insert(arena.end(), m_arena.data() + src.val_offset, m_arena.data() + src.val_offset + src.val_length + 1);
+		entries.push_back(dst);
+	}
+
+	m_entries.swap(entries);
+	m_arena  .swap(arena);
+	m_slots.assign(slotCount, Slot{});
+	m_tombstones = 0;
+	m_garbage    = 0;
+
+	for (uint32_t i = 0; i < m_entries.size(); ++i) {
+		_insert_slot(m_entries[i].hash, i);
+	}
+}
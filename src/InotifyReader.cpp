@@ -0,0 +1,147 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "InotifyReader.h"
+#include "icy_log.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if PLATFORM_LINUX
+#	include <fcntl.h>
+#	include <poll.h>
+#	include <unistd.h>
+#	include <sys/inotify.h>
+#endif
+
+std::string native_parent_dir(const std::string& path) {
+	auto pos = path.find_last_of('/');
+	if (pos == path.npos) {
+		return ".";
+	}
+	if (pos == 0) {
+		return "/";
+	}
+	return path.substr(0, pos);
+}
+
+std::string native_child_path(const std::string& dir, std::string_view name) {
+	if (dir == ".") {
+		return std::string(name);
+	}
+	std::string path = dir;
+	if (path.empty() || path.back() != '/') {
+		path += '/';
+	}
+	path += name;
+	return path;
+}
+
+InotifyReader::~InotifyReader() {
+	close();
+}
+
+bool InotifyReader::open(const char* owner) {
+	close();
+	m_owner = owner;
+
+#if PLATFORM_LINUX
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_fd < 0) {
+		log_error("%s: inotify_init1 failed, code=%d (%s)", m_owner, errno, strerror(errno));
+		return false;
+	}
+	if (pipe2(m_wake_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+		log_error("%s: pipe2 failed, code=%d (%s)", m_owner, errno, strerror(errno));
+		::close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void InotifyReader::close() {
+#if PLATFORM_LINUX
+	if (m_fd >= 0) {
+		::close(m_fd);			// also removes all watches
+		::close(m_wake_pipe[0]);
+		::close(m_wake_pipe[1]);
+	}
+#endif
+	m_fd			= -1;
+	m_wake_pipe[0]	= -1;
+	m_wake_pipe[1]	= -1;
+}
+
+int InotifyReader::addWatch(const char* dir, uint32_t mask) {
+#if PLATFORM_LINUX
+	return inotify_add_watch(m_fd, dir, mask);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+void InotifyReader::removeWatch(int wd) {
+#if PLATFORM_LINUX
+	inotify_rm_watch(m_fd, wd);
+#endif
+}
+
+void InotifyReader::wake() {
+#if PLATFORM_LINUX
+	char wake = 0;
+	[[maybe_unused]] auto result = write(m_wake_pipe[1], &wake, 1);
+#endif
+}
+
+bool InotifyReader::wait(int timeoutMs, InotifyReady& ready) {
+	ready = {};
+#if PLATFORM_LINUX
+	pollfd fds[2] = {
+		{ m_fd,				POLLIN, 0 },
+		{ m_wake_pipe[0],	POLLIN, 0 },
+	};
+
+	if (poll(fds, 2, timeoutMs) < 0) {
+		if (errno == EINTR) {
+			return true;
+		}
+		log_error("%s: poll failed, code=%d (%s)", m_owner, errno, strerror(errno));
+		return false;
+	}
+
+	if (fds[1].revents) {
+		char drain[64];
+		while (read(m_wake_pipe[0], drain, sizeof(drain)) > 0) { }
+		ready.woken = true;
+	}
+	ready.events = fds[0].revents != 0;
+	return true;
+#else
+	return false;
+#endif
+}
+
+size_t InotifyReader::readEvents(const EventFunc& func) {
+	size_t count = 0;
+#if PLATFORM_LINUX
+	alignas(inotify_event) char buffer[64 * 1024];
+
+	for (;;) {
+		auto length = read(m_fd, buffer, sizeof(buffer));
+		if (length <= 0) {
+			break;
+		}
+		for (auto pos = 0; pos < length; ) {
+			auto* event = (inotify_event const*)(buffer + pos);
+			func(event->wd, event->mask, event->len ? event->name : nullptr);
+			pos += sizeof(inotify_event) + event->len;
+			++count;
+		}
+	}
+#endif
+	return count;
+}
@@ -0,0 +1,210 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "InputStream.h"
+#include "icy_log.h"
+#include "icy_assert.h"
+
+#if PLATFORM_MSW
+#	include "EmbeddedBinaryData.h"
+#	include <tuple>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+
+#if !defined(O_CLOEXEC)
+#	define O_CLOEXEC	(0)
+#endif
+
+namespace fs {
+
+size_t InputStream::_readSlow(std::span<uint8_t> dest) {
+	auto avail = available();
+	memcpy(dest.data(), m_cur, avail);
+	m_cur += avail;
+	return avail + _readMore(dest.data() + avail, dest.size() - avail);
+}
+
+size_t InputStream::_readMore(uint8_t* dest, size_t size) {
+	size_t total = 0;
+	while (total < size) {
+		auto avail = std::min(_underflow(size - total), size - total);
+		if (!avail) {
+			break;
+		}
+		memcpy(dest + total, m_cur, avail);
+		m_cur += avail;
+		total += avail;
+	}
+	return total;
+}
+
+size_t InputStream::_skipSlow(size_t n) {
+	// seeking past the window avoids reading data only to discard it.
+	auto sz = size();
+	if (sz >= 0) {
+		auto target = std::min<intmax_t>(tell() + (intmax_t)n, sz);
+		auto from = tell();
+		if (seek(target)) {
+			return (size_t)(target - from);
+		}
+	}
+
+	size_t total = 0;
+	while (total < n) {
+		auto avail = std::min(available() ? available() : _underflow(1), n - total);
+		if (!avail) {
+			break;
+		}
+		m_cur += avail;
+		total += avail;
+	}
+	return total;
+}
+
+// --------------------------------------------------------------------------------------------------------
+#if PLATFORM_MSW
+EmbeddedStream::EmbeddedStream(const std::string& resourceName) {
+	auto [data, size] = msw_GetResourceInfo(resourceName);
+	reset(data, data ? (size_t)size : 0);
+}
+#endif
+
+// --------------------------------------------------------------------------------------------------------
+FdStream::FdStream(size_t bufferSize) {
+	m_capacity	= std::max<size_t>(bufferSize, 256);
+	m_buffer	= std::make_unique<uint8_t[]>(m_capacity);
+	m_begin		= m_cur = m_end = m_buffer.get();
+}
+
+FdStream::FdStream(const fs::path& path, size_t bufferSize)
+	: FdStream(bufferSize)
+{
+	open(path);
+}
+
+FdStream::~FdStream() {
+	close();
+}
+
+bool FdStream::open(const fs::path& path) {
+	close();
+	int fd = ::posix_open((const char*)path, O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0) {
+		m_error = errno;
+		return false;
+	}
+	attach(fd, true);
+	return true;
+}
+
+void FdStream::attach(int fd, bool takeOwnership) {
+	close();
+	m_fd		= fd;
+	m_owns_fd	= takeOwnership;
+	m_error		= 0;
+
+	auto pos	= (intmax_t)posix_lseek(fd, 0, SEEK_CUR);
+	auto st		= posix_fstat(fd);
+	m_seekable	= pos >= 0 && st.IsFile();
+	m_size		= m_seekable ? st.st_size : -1;
+	m_file_pos	= std::max<intmax_t>(pos, 0);
+	m_base_pos	= m_file_pos;
+	m_begin		= m_cur = m_end = m_buffer.get();
+}
+
+void FdStream::close() {
+	if (m_fd >= 0 && m_owns_fd) {
+		::posix_close(m_fd);
+	}
+	m_fd		= -1;
+	m_owns_fd	= false;
+	m_size		= -1;
+	m_file_pos	= 0;
+	m_base_pos	= 0;
+	m_begin		= m_cur = m_end = m_buffer.get();
+}
+
+intmax_t FdStream::_fdRead(uint8_t* dest, size_t size) {
+	if (m_fd < 0) {
+		return 0;
+	}
+	for (;;) {
+		auto result = m_seekable
+			? (intmax_t)posix_pread(m_fd, dest, size, m_file_pos)
+			: (intmax_t)::posix_read(m_fd, dest, size);
+		if (result >= 0) {
+			m_file_pos += result;
+			return result;
+		}
+		if (errno != EINTR) {
+			m_error = errno;
+			return -1;
+		}
+	}
+}
+
+size_t FdStream::_underflow(size_t want) {
+	auto avail = available();
+	if (avail >= want) {
+		return avail;
+	}
+
+	// move unconsumed data to the front of the buffer, growing it if want exceeds its capacity.
+	auto* buf = m_buffer.get();
+	if (want > m_capacity) {
+		auto newCapacity = std::max(want, m_capacity * 2);
+		auto newBuffer = std::make_unique<uint8_t[]>(newCapacity);
+		memcpy(newBuffer.get(), m_cur, avail);
+		m_buffer	= std::move(newBuffer);
+		m_capacity	= newCapacity;
+		buf			= m_buffer.get();
+	}
+	elif (m_cur != buf) {
+		memmove(buf, m_cur, avail);
+	}
+	m_base_pos	= tell();
+	m_begin		= m_cur = buf;
+	m_end		= buf + avail;
+
+	while (available() < want) {
+		auto result = _fdRead(const_cast<uint8_t*>(m_end), m_capacity - available());
+		if (result <= 0) {
+			break;
+		}
+		m_end += result;
+	}
+	return available();
+}
+
+size_t FdStream::_readMore(uint8_t* dest, size_t size) {
+	if (size < m_capacity) {
+		return InputStream::_readMore(dest, size);
+	}
+
+	// large reads bypass the buffer. The window is empty at this point, so it is simply moved to the new
+	// position afterward.
+	size_t total = 0;
+	while (total < size) {
+		auto result = _fdRead(dest + total, size - total);
+		if (result <= 0) {
+			break;
+		}
+		total += (size_t)result;
+	}
+	m_base_pos	= m_file_pos;
+	m_begin		= m_cur = m_end = m_buffer.get();
+	return total;
+}
+
+bool FdStream::_seek(intmax_t pos) {
+	if (!m_seekable || pos < 0) {
+		return false;
+	}
+	m_file_pos	= pos;
+	m_base_pos	= pos;
+	m_begin		= m_cur = m_end = m_buffer.get();
+	return true;
+}
+
+} // namespace fs
@@ -0,0 +1,276 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "MappedFile.h"
+#include "icy_log.h"
+#include "icy_assert.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if PLATFORM_MSW
+#	define NOMINMAX
+#	define NO_STRICT
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+#else
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+#if !defined(O_CLOEXEC)
+#	define O_CLOEXEC	(0)
+#endif
+
+// one per mapping, shared by all handles to it. base/length describe the actual OS mapping, which begins
+// on an allocation boundary and thus may start before the data requested by the user.
+struct MappedRegion {
+	uint8_t*	base	= nullptr;
+	size_t		length	= 0;
+	MapAccess	access	= MapAccess::ReadOnly;
+
+	~MappedRegion() {
+		if (!base) {
+			return;
+		}
+#if PLATFORM_MSW
+		UnmapViewOfFile(base);
+#else
+		munmap(base, length);
+#endif
+	}
+};
+
+// granularity of mapping offsets, and of madvise ranges.
+static size_t _mapGranularity() {
+	static size_t s_granularity = [] {
+#if PLATFORM_MSW
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return (size_t)info.dwAllocationGranularity;
+#else
+		return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}();
+	return s_granularity;
+}
+
+#if !PLATFORM_MSW
+static int _toMadvise(MapAdvice advice) {
+	switch (advice) {
+		case MapAdvice::Normal:			return MADV_NORMAL;
+		case MapAdvice::Sequential:		return MADV_SEQUENTIAL;
+		case MapAdvice::Random:			return MADV_RANDOM;
+		case MapAdvice::WillNeed:		return MADV_WILLNEED;
+		case MapAdvice::DontNeed:		return MADV_DONTNEED;
+#if defined(MADV_HUGEPAGE)
+		case MapAdvice::HugePage:		return MADV_HUGEPAGE;
+#endif
+		default: break;
+	}
+	return -1;
+}
+#endif
+
+#if PLATFORM_LINUX
+// readahead hints on the file itself take effect before any page is faulted, which matters for the
+// first pass over a file mapped with Sequential or WillNeed.
+static void _fadvise(int fd, x_off_t offset, size_t length, MapAdvice advice) {
+	int fadv;
+	switch (advice) {
+		case MapAdvice::Sequential:		fadv = POSIX_FADV_SEQUENTIAL;	break;
+		case MapAdvice::Random:			fadv = POSIX_FADV_RANDOM;		break;
+		case MapAdvice::WillNeed:		fadv = POSIX_FADV_WILLNEED;		break;
+		case MapAdvice::DontNeed:		fadv = POSIX_FADV_DONTNEED;		break;
+		default: return;
+	}
+	posix_fadvise(fd, offset, length, fadv);
+}
+#endif
+
+bool MappedFile::open(const fs::path& path, const MappedFileOptions& options) {
+	return open((const char*)path, options);
+}
+
+bool MappedFile::open(const char* path, const MappedFileOptions& options) {
+	close();
+
+	int flags = (options.access == MapAccess::ReadWrite) ? O_RDWR : O_RDONLY;
+	int fd = ::posix_open(path, flags | O_CLOEXEC, 0);
+	if (fd < 0) {
+		m_error = errno;
+		return false;
+	}
+
+	bool result = map(fd, options);
+	::posix_close(fd);
+	return result;
+}
+
+bool MappedFile::map(int fd, const MappedFileOptions& options) {
+	close();
+
+	auto st = posix_fstat(fd);
+	if (!st.Exists()) {
+		m_error = errno ? errno : EBADF;
+		return false;
+	}
+	if (options.offset < 0 || options.offset > st.st_size) {
+		m_error = EINVAL;
+		return false;
+	}
+
+	auto avail	= (size_t)(st.st_size - options.offset);
+	auto length	= options.length ? std::min(options.length, avail) : avail;
+
+	auto region = std::make_shared<MappedRegion>();
+	region->access = options.access;
+
+	if (length == 0) {
+		// nothing to map (OSes refuse zero-length mappings), but the handle is still valid.
+		m_region	= std::move(region);
+		m_data		= nullptr;
+		m_size		= 0;
+		m_error		= 0;
+		return true;
+	}
+
+	auto granularity	= _mapGranularity();
+	auto alignedOffset	= options.offset & ~(x_off_t)(granularity - 1);
+	auto lead			= (size_t)(options.offset - alignedOffset);
+	region->length		= length + lead;
+
+#if PLATFORM_MSW
+	auto hfile = (HANDLE)_get_osfhandle(fd);
+	DWORD protect	= PAGE_READONLY;
+	DWORD access	= FILE_MAP_READ;
+	switch (options.access) {
+		case MapAccess::ReadWrite:		protect = PAGE_READWRITE;	access = FILE_MAP_WRITE;	break;
+		case MapAccess::CopyOnWrite:	protect = PAGE_WRITECOPY;	access = FILE_MAP_COPY;		break;
+		default: break;
+	}
+
+	auto hmap = CreateFileMappingW(hfile, nullptr, protect, 0, 0, nullptr);
+	if (!hmap) {
+		m_error = EACCES;
+		log_error("CreateFileMapping failed, GetLastError=%u", (unsigned)GetLastError());
+		return false;
+	}
+	region->base = (uint8_t*)MapViewOfFile(hmap, access, (DWORD)((uint64_t)alignedOffset >> 32), (DWORD)alignedOffset, region->length);
+	CloseHandle(hmap);		// the view holds its own reference to the mapping object.
+	if (!region->base) {
+		m_error = ENOMEM;
+		log_error("MapViewOfFile failed, GetLastError=%u", (unsigned)GetLastError());
+		return false;
+	}
+
+	if (options.populate || options.advice == MapAdvice::WillNeed) {
+		WIN32_MEMORY_RANGE_ENTRY range = { region->base, region->length };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+#else
+	int prot	= PROT_READ;
+	int mflags	= MAP_SHARED;
+	if (options.access == MapAccess::ReadWrite) {
+		prot |= PROT_WRITE;
+	}
+	elif (options.access == MapAccess::CopyOnWrite) {
+		prot |= PROT_WRITE;
+		mflags = MAP_PRIVATE;
+	}
+#	if defined(MAP_POPULATE)
+	if (options.populate) {
+		mflags |= MAP_POPULATE;
+	}
+#	endif
+
+#	if PLATFORM_LINUX
+	_fadvise(fd, options.offset, length, options.advice);
+#	endif
+
+	void* base = mmap(nullptr, region->length, prot, mflags, fd, (off_t)alignedOffset);
+	if (base == MAP_FAILED) {
+		m_error = errno;
+		log_error("mmap of %zu bytes failed: %s", region->length, strerror(errno));
+		return false;
+	}
+	region->base = (uint8_t*)base;
+
+	int madv = _toMadvise(options.advice);
+	if (options.advice != MapAdvice::Normal && madv >= 0) {
+		madvise(base, region->length, madv);
+	}
+#endif
+
+	m_data		= region->base + lead;
+	m_size		= length;
+	m_region	= std::move(region);
+	m_error		= 0;
+	return true;
+}
+
+void MappedFile::close() {
+	m_region.reset();
+	m_data	= nullptr;
+	m_size	= 0;
+}
+
+bool MappedFile::writable() const {
+	return m_region && m_region->access != MapAccess::ReadOnly;
+}
+
+uint8_t* MappedFile::mutable_data() const {
+	assertD(writable());
+	return m_data;
+}
+
+MappedFile MappedFile::subview(size_t offset, size_t length) const {
+	MappedFile result;
+	if (!m_region) {
+		return result;
+	}
+	offset = std::min(offset, m_size);
+	result.m_region	= m_region;
+	result.m_data	= m_data ? m_data + offset : nullptr;
+	result.m_size	= std::min(length, m_size - offset);
+	return result;
+}
+
+bool MappedFile::advise(MapAdvice advice, size_t offset, size_t length) const {
+	if (!m_region || offset >= m_size) {
+		return false;
+	}
+	length = std::min(length, m_size - offset);
+
+	// advice applies to whole pages, so round the range outward.
+	auto granularity	= (uintptr_t)_mapGranularity();
+	auto start			= (uintptr_t)(m_data + offset);
+	auto alignedStart	= start & ~(granularity - 1);
+	auto alignedLength	= (size_t)(start + length - alignedStart);
+
+#if PLATFORM_MSW
+	if (advice != MapAdvice::WillNeed) {
+		return false;
+	}
+	WIN32_MEMORY_RANGE_ENTRY range = { (void*)alignedStart, alignedLength };
+	return PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	int madv = _toMadvise(advice);
+	if (madv < 0) {
+		return false;
+	}
+	return madvise((void*)alignedStart, alignedLength, madv) == 0;
+#endif
+}
+
+bool MappedFile::flush(bool async) const {
+	if (!m_region || !m_data || m_region->access != MapAccess::ReadWrite) {
+		return false;
+	}
+#if PLATFORM_MSW
+	(void)async;
+	return FlushViewOfFile(m_region->base, m_region->length);
+#else
+	return msync(m_region->base, m_region->length, async ? MS_ASYNC : MS_SYNC) == 0;
+#endif
+}
@@ -0,0 +1,344 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "MemoryFileSystem.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// device numbers are distinct per instance, so that nodes of different instances never compare as the
+// same file.
+static std::atomic<uint64_t> s_next_dev = 0x6d656d00;
+
+static constexpr uint64_t kDefaultSeed = 0x9e3779b97f4a7c15ull;
+
+static uint64_t _splitmix64(uint64_t x) {
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return x ^ (x >> 31);
+}
+
+static void _wait(std::chrono::nanoseconds duration, bool spin) {
+	if (!spin) {
+		std::this_thread::sleep_for(duration);
+		return;
+	}
+	auto until = std::chrono::steady_clock::now() + duration;
+	while (std::chrono::steady_clock::now() < until) {
+		// busy-wait
+	}
+}
+
+// visits the components of a path, ignoring the root and '.' so that "a/b", "/a/b" and "./a/b" all name
+// the same node.
+template<typename Func>
+static void _forEachComponent(const fs::path& normal, Func&& func) {
+	for (auto comp : normal.components()) {
+		if (comp != "/" && comp != ".") {
+			func(comp);
+		}
+	}
+}
+
+MemoryFileSystem::MemoryFileSystem() {
+	m_dev	= s_next_dev++;
+	m_seed	= kDefaultSeed;
+	m_root	= _newNode(S_IFDIR | 0755);
+}
+
+MemoryFileSystem::~MemoryFileSystem() = default;
+
+std::unique_ptr<MemoryFileSystem::Node> MemoryFileSystem::_newNode(uint32_t mode) {
+	auto node = std::make_unique<Node>();
+	node->stat			= {};
+	node->stat.st_mode	= mode;
+	node->stat.st_size	= (mode & S_IFDIR) ? 4096 : 0;
+	node->stat.st_dev	= m_dev;
+	node->stat.st_ino	= m_next_ino++;
+	_touch(*node);
+	node->stat.time_accessed		= node->stat.time_modified;
+	node->stat.time_accessed_nsec	= node->stat.time_modified_nsec;
+	return node;
+}
+
+void MemoryFileSystem::_touch(Node& node) {
+	auto now	= std::chrono::system_clock::now().time_since_epoch();
+	auto secs	= std::chrono::duration_cast<std::chrono::seconds>(now);
+	auto nsec	= (int32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - secs).count();
+
+	node.stat.time_modified			= (time_t)secs.count();
+	node.stat.time_modified_nsec	= nsec;
+	node.stat.time_changed			= node.stat.time_modified;
+	node.stat.time_changed_nsec		= nsec;
+}
+
+MemoryFileSystem::Node* MemoryFileSystem::_find(const fs::path& path) const {
+	auto* node = m_root.get();
+	_forEachComponent(path.lexically_normal(), [&](std::string_view name) {
+		if (!node) {
+			return;
+		}
+		auto it = node->children.find(name);
+		node = (it != node->children.end()) ? it->second.get() : nullptr;
+	});
+	return node;
+}
+
+MemoryFileSystem::Node* MemoryFileSystem::_makeDirs(const fs::path& path, bool includeLeaf) {
+	std::vector<std::string_view> names;
+	auto normal = path.lexically_normal();
+	_forEachComponent(normal, [&](std::string_view name) { names.push_back(name); });
+	if (!includeLeaf && !names.empty()) {
+		names.pop_back();
+	}
+
+	auto* node = m_root.get();
+	for (auto name : names) {
+		if (!node->stat.IsDir()) {
+			return nullptr;
+		}
+		auto it = node->children.find(name);
+		if (it == node->children.end()) {
+			it = node->children.emplace(std::string(name), _newNode(S_IFDIR | 0755)).first;
+			_touch(*node);
+		}
+		node = it->second.get();
+	}
+	return node->stat.IsDir() ? node : nullptr;
+}
+
+bool MemoryFileSystem::WriteFile(const fs::path& path, std::string data) {
+	auto normal = path.lexically_normal();
+	auto name	= std::string(normal.filename_view());
+	if (name.empty() || name == "." || name == "/") {
+		return false;
+	}
+
+	std::unique_lock lock(m_mutex);
+	auto* dir = _makeDirs(normal, false);
+	if (!dir) {
+		return false;
+	}
+
+	auto& child = dir->children[name];
+	if (!child) {
+		child = _newNode(S_IFREG | 0644);
+		_touch(*dir);
+	}
+	elif (child->stat.IsDir()) {
+		return false;
+	}
+	child->stat.st_size	= (intmax_t)data.size();
+	child->data			= std::make_shared<const std::string>(std::move(data));
+	_touch(*child);
+	return true;
+}
+
+bool MemoryFileSystem::CreateDirectories(const fs::path& path) {
+	std::unique_lock lock(m_mutex);
+	return _makeDirs(path, true) != nullptr;
+}
+
+bool MemoryFileSystem::Remove(const fs::path& path) {
+	auto normal = path.lexically_normal();
+	auto name	= normal.filename_view();
+
+	std::unique_lock lock(m_mutex);
+	auto* dir = _find(normal.parent_path_view() == name ? fs::path() : normal.parent_path());
+	if (!dir || !dir->stat.IsDir()) {
+		return false;
+	}
+	auto it = dir->children.find(name);
+	if (it == dir->children.end()) {
+		return false;
+	}
+	dir->children.erase(it);
+	_touch(*dir);
+	return true;
+}
+
+void MemoryFileSystem::Clear() {
+	std::unique_lock lock(m_mutex);
+	m_root = _newNode(S_IFDIR | 0755);
+}
+
+size_t MemoryFileSystem::AddSyntheticTree(const fs::path& root, int depth, int dirsPerDir, int filesPerDir, size_t fileSize) {
+	// all files share one buffer, so that large trees cost only their nodes.
+	std::string content(fileSize, 0);
+	for (size_t i = 0; i < fileSize; ++i) {
+		content[i] = (char)(i * 131 + 7);
+	}
+	auto data = std::make_shared<const std::string>(std::move(content));
+
+	std::unique_lock lock(m_mutex);
+	auto* top = _makeDirs(root, true);
+	if (!top) {
+		return 0;
+	}
+
+	size_t count = 0;
+	std::function<void(Node&, int)> populate = [&](Node& dir, int level) {
+		_touch(dir);
+		for (int i = 0; i < filesPerDir; ++i) {
+			auto& child = dir.children["f" + std::to_string(i) + ".bin"];
+			if (!child) {
+				child = _newNode(S_IFREG | 0644);
+			}
+			if (child->stat.IsFile()) {
+				child->data			= data;
+				child->stat.st_size	= (intmax_t)fileSize;
+				++count;
+			}
+		}
+		if (level <= 0) {
+			return;
+		}
+		for (int i = 0; i < dirsPerDir; ++i) {
+			auto& child = dir.children["d" + std::to_string(i)];
+			if (!child) {
+				child = _newNode(S_IFDIR | 0755);
+			}
+			if (child->stat.IsDir()) {
+				populate(*child, level - 1);
+			}
+		}
+	};
+	populate(*top, depth);
+	return count;
+}
+
+void MemoryFileSystem::SetOpConfig(MemFsOp op, const MemFsOpConfig& config) {
+	std::unique_lock lock(m_mutex);
+	m_ops[(int)op].config = config;
+}
+
+void MemoryFileSystem::SetAllOpConfigs(const MemFsOpConfig& config) {
+	std::unique_lock lock(m_mutex);
+	for (auto& state : m_ops) {
+		state.config = config;
+	}
+}
+
+void MemoryFileSystem::SetFailurePredicate(FailurePredicate predicate) {
+	auto shared = predicate ? std::make_shared<const FailurePredicate>(std::move(predicate)) : nullptr;
+	std::unique_lock lock(m_mutex);
+	m_predicate = std::move(shared);
+}
+
+void MemoryFileSystem::SetSeed(uint64_t seed) {
+	m_seed	= seed;
+	m_draws	= 0;
+}
+
+MemFsCounters MemoryFileSystem::GetCounters() const {
+	MemFsCounters result = {};
+	for (int i = 0; i < (int)MemFsOp::Count; ++i) {
+		result.ops[i] = {
+			m_ops[i].calls.load(std::memory_order_relaxed),
+			m_ops[i].failures.load(std::memory_order_relaxed),
+			m_ops[i].latency_ns.load(std::memory_order_relaxed),
+		};
+	}
+	return result;
+}
+
+void MemoryFileSystem::ResetCounters() {
+	for (auto& state : m_ops) {
+		state.calls			= 0;
+		state.failures		= 0;
+		state.latency_ns	= 0;
+	}
+}
+
+uint64_t MemoryFileSystem::_draw() {
+	auto index = m_draws.fetch_add(1, std::memory_order_relaxed);
+	return _splitmix64(m_seed.load(std::memory_order_relaxed) + index * kDefaultSeed);
+}
+
+// counts the call, applies its latency, and decides whether it fails. Returns FALSE if it fails.
+bool MemoryFileSystem::_begin(MemFsOp op, const fs::path& path) {
+	auto& state = m_ops[(int)op];
+	auto index = state.calls.fetch_add(1, std::memory_order_relaxed) + 1;
+
+	MemFsOpConfig config;
+	std::shared_ptr<const FailurePredicate> predicate;
+	{
+		std::shared_lock lock(m_mutex);
+		config		= state.config;
+		predicate	= m_predicate;
+	}
+
+	// the predicate is called without the lock, so that it may query or modify the filesystem.
+	bool fail = (config.fail_every && (index % config.fail_every) == 0)
+		|| (config.failure_rate > 0 && (double)(_draw() >> 11) * 0x1.0p-53 < config.failure_rate);
+	if (!fail && predicate) {
+		fail = (*predicate)(op, path);
+	}
+
+	auto latency = config.latency;
+	if (config.jitter.count() > 0) {
+		latency += std::chrono::nanoseconds(_draw() % (uint64_t)config.jitter.count());
+	}
+	if (latency.count() > 0) {
+		state.latency_ns.fetch_add((uint64_t)latency.count(), std::memory_order_relaxed);
+		_wait(latency, config.spin);
+	}
+
+	if (fail) {
+		state.failures.fetch_add(1, std::memory_order_relaxed);
+	}
+	return !fail;
+}
+
+CStatInfo MemoryFileSystem::Stat(const fs::path& path) {
+	if (!_begin(MemFsOp::Stat, path)) {
+		return {};
+	}
+	std::shared_lock lock(m_mutex);
+	auto* node = _find(path);
+	return node ? node->stat : CStatInfo{};
+}
+
+bool MemoryFileSystem::Exists(const fs::path& path) {
+	if (!_begin(MemFsOp::Exists, path)) {
+		return false;
+	}
+	std::shared_lock lock(m_mutex);
+	return _find(path) != nullptr;
+}
+
+void MemoryFileSystem::VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) {
+	if (!_begin(MemFsOp::List, path)) {
+		return;
+	}
+
+	// names are copied out so that visitFunc runs without holding the lock, and may modify the filesystem.
+	std::vector<std::string> names;
+	{
+		std::shared_lock lock(m_mutex);
+		auto* node = _find(path);
+		if (!node || !node->stat.IsDir()) {
+			return;
+		}
+		names.reserve(node->children.size());
+		for (auto& [name, child] : node->children) {
+			names.push_back(name);
+		}
+	}
+	for (auto& name : names) {
+		visitFunc(path / name);
+	}
+}
+
+std::unique_ptr<fs::InputStream> MemoryFileSystem::Open(const fs::path& path) {
+	if (!_begin(MemFsOp::Open, path)) {
+		return nullptr;
+	}
+	std::shared_lock lock(m_mutex);
+	auto* node = _find(path);
+	if (!node || !node->stat.IsFile()) {
+		return nullptr;
+	}
+	auto& data = node->data;
+	return std::make_unique<fs::SharedMemoryStream>(data, data->data(), data->size());
+}
@@ -0,0 +1,458 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "PackArchive.h"
+#include "BufferedFile.h"
+#include "DirWalker.h"
+#include "icy_log.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// the format is little-endian, and is read in place.
+static_assert(std::endian::native == std::endian::little);
+
+// --------------------------------------------------------------------------------------------------------
+// CRC-32C, slicing-by-8: processes 8 bytes per step using eight 256-entry tables.
+
+struct Crc32cTables {
+	uint32_t	t[8][256];
+};
+
+static constexpr Crc32cTables _makeCrc32cTables() {
+	Crc32cTables tables = {};
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+		for (int k = 0; k < 8; ++k) {
+			crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+		}
+		tables.t[0][i] = crc;
+	}
+	for (uint32_t i = 0; i < 256; ++i) {
+		for (int s = 1; s < 8; ++s) {
+			auto prev = tables.t[s - 1][i];
+			tables.t[s][i] = (prev >> 8) ^ tables.t[0][prev & 0xff];
+		}
+	}
+	return tables;
+}
+
+static constexpr Crc32cTables s_crc32c = _makeCrc32cTables();
+
+uint32_t PackChecksum(const void* data, size_t size, uint32_t seed) {
+	auto& t		= s_crc32c.t;
+	auto* src	= (const uint8_t*)data;
+	uint32_t crc = ~seed;
+
+	while (size && ((uintptr_t)src & 7)) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *src++) & 0xff];
+		--size;
+	}
+	while (size >= 8) {
+		uint64_t word;
+		memcpy(&word, src, 8);
+		word ^= crc;
+		crc =	t[7][(word      ) & 0xff] ^ t[6][(word >>  8) & 0xff] ^
+				t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff] ^
+				t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^
+				t[1][(word >> 48) & 0xff] ^ t[0][(word >> 56)       ];
+		src  += 8;
+		size -= 8;
+	}
+	while (size--) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *src++) & 0xff];
+	}
+	return ~crc;
+}
+
+// --------------------------------------------------------------------------------------------------------
+bool PackArchive::open(const fs::path& path, const PackOpenOptions& options) {
+	close();
+
+	if (!m_file.open(path, { MapAccess::ReadOnly, MapAdvice::Normal, options.populate })) {
+		log_error("PackArchive: failed to map '%s': %s", path.c_str(), strerror(m_file.error()));
+		return false;
+	}
+	if (!_validate(path)) {
+		close();
+		return false;
+	}
+	if (options.verify_payloads && !verify_all()) {
+		log_error("PackArchive: '%s' has corrupt payloads", path.c_str());
+		close();
+		return false;
+	}
+
+	m_time = posix_stat(path).time_modified;
+	return true;
+}
+
+bool PackArchive::_validate(const fs::path& path) {
+	auto size = m_file.size();
+	auto* base = m_file.data();
+
+	auto fail = [&](const char* reason) {
+		log_error("PackArchive: '%s' is not a valid pack: %s", path.c_str(), reason);
+		return false;
+	};
+
+	if (size < sizeof(PackHeader)) {
+		return fail("too small");
+	}
+	auto* hdr = (const PackHeader*)base;
+	if (memcmp(hdr->magic, kPackMagic, sizeof(kPackMagic)) != 0) {
+		return fail("bad magic");
+	}
+	if (hdr->version != kPackVersion) {
+		return fail("unsupported version");
+	}
+	if (hdr->file_size != size) {
+		return fail("size mismatch (truncated?)");
+	}
+	if (hdr->index_offset > size || (hdr->index_offset % alignof(PackEntry)) ||
+		hdr->entry_count > (size - hdr->index_offset) / sizeof(PackEntry)) {
+		return fail("index out of range");
+	}
+	if (hdr->names_offset > size || hdr->names_size > size - hdr->names_offset || hdr->names_size > UINT32_MAX) {
+		return fail("names out of range");
+	}
+
+	std::span<const PackEntry> entries((const PackEntry*)(base + hdr->index_offset), hdr->entry_count);
+	auto* names = (const char*)(base + hdr->names_offset);
+
+	auto crc = PackChecksum(entries.data(), entries.size_bytes());
+	crc = PackChecksum(names, hdr->names_size, crc);
+	if (crc != hdr->index_checksum) {
+		return fail("index checksum mismatch");
+	}
+
+	// the checksum only proves the index is as written, so bounds are still checked to avoid trusting
+	// a malformed (or malicious) archive.
+	for (size_t i = 0; i < entries.size(); ++i) {
+		auto& ent = entries[i];
+		if ((uint64_t)ent.name_offset + ent.name_length >= hdr->names_size || names[ent.name_offset + ent.name_length]) {
+			return fail("entry name out of range");
+		}
+		if (ent.offset > size || ent.size > size - ent.offset) {
+			return fail("entry payload out of range");
+		}
+		if (i && entries[i - 1].name_hash > ent.name_hash) {
+			return fail("index is not sorted");
+		}
+	}
+
+	m_header	= hdr;
+	m_entries	= entries;
+	m_names		= names;
+	return true;
+}
+
+void PackArchive::close() {
+	m_file.close();
+	m_header	= nullptr;
+	m_entries	= {};
+	m_names		= nullptr;
+	m_time		= 0;
+	m_dirs.clear();
+	m_dirs_built = false;
+}
+
+const PackEntry* PackArchive::find(std::string_view name) const {
+	auto lookup = [&](std::string_view key) -> const PackEntry* {
+		auto hash = fs::PathHash(key);
+		auto it = std::lower_bound(m_entries.begin(), m_entries.end(), hash, [](const PackEntry& ent, uint64_t h) {
+			return ent.name_hash < h;
+		});
+		for (; it != m_entries.end() && it->name_hash == hash; ++it) {
+			if (VfsKeyEqual{}(this->name(*it), key)) {
+				return &*it;
+			}
+		}
+		return nullptr;
+	};
+
+	// names are usually given in normal form already, so normalizing (which allocates) is only done if
+	// the name as given is not found.
+	auto start = std::min(name.find_first_not_of('/'), name.size());
+	if (auto* ent = lookup(name.substr(start))) {
+		return ent;
+	}
+	auto key = VfsRelativeKey(name);
+	if (key != name.substr(start)) {
+		return lookup(key);
+	}
+	return nullptr;
+}
+
+bool PackArchive::verify(const PackEntry& entry) const {
+	auto data = view(entry);
+	return PackChecksum(data.data(), data.size()) == entry.checksum;
+}
+
+bool PackArchive::verify_all() const {
+	bool result = true;
+	for (auto& ent : m_entries) {
+		if (!verify(ent)) {
+			log_error("PackArchive: checksum mismatch for '%.*s'", (int)ent.name_length, m_names + ent.name_offset);
+			result = false;
+		}
+	}
+	return result;
+}
+
+void PackArchive::_buildDirs() {
+	std::lock_guard lock(m_dirs_mutex);
+	if (m_dirs_built.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	m_dirs[{}];		// the root exists even if the archive is empty.
+	for (auto& ent : m_entries) {
+		auto child = name(ent);
+		for (;;) {
+			auto pos	= child.find_last_of('/');
+			auto dir	= (pos == child.npos) ? std::string_view{} : child.substr(0, pos);
+			auto leaf	= (pos == child.npos) ? child : child.substr(pos + 1);
+
+			// once a dir already lists the child, its ancestors have been registered too.
+			if (!m_dirs[dir].emplace(leaf).second || dir.empty()) {
+				break;
+			}
+			child = dir;
+		}
+	}
+	m_dirs_built.store(true, std::memory_order_release);
+}
+
+CStatInfo PackArchive::Stat(const fs::path& path) {
+	CStatInfo st = {};
+	if (!is_open()) {
+		return st;
+	}
+
+	if (auto* ent = find(path.uni_string())) {
+		st.st_mode	= S_IFREG | 0444;
+		st.st_size	= (intmax_t)ent->size;
+	}
+	else {
+		if (!m_dirs_built.load(std::memory_order_acquire)) {
+			_buildDirs();
+		}
+		if (!m_dirs.count(VfsRelativeKey(path.uni_string()))) {
+			return st;
+		}
+		st.st_mode	= S_IFDIR | 0555;
+	}
+	st.time_accessed	= m_time;
+	st.time_modified	= m_time;
+	st.time_changed		= m_time;
+	return st;
+}
+
+bool PackArchive::Exists(const fs::path& path) {
+	return Stat(path).Exists();
+}
+
+void PackArchive::VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) {
+	if (!is_open()) {
+		return;
+	}
+	if (!m_dirs_built.load(std::memory_order_acquire)) {
+		_buildDirs();
+	}
+
+	auto it = m_dirs.find(VfsRelativeKey(path.uni_string()));
+	if (it == m_dirs.end()) {
+		return;
+	}
+	for (auto name : it->second) {
+		visitFunc(path / std::string(name));
+	}
+}
+
+std::unique_ptr<fs::InputStream> PackArchive::Open(const fs::path& path) {
+	if (!is_open()) {
+		return nullptr;
+	}
+	auto* ent = find(path.uni_string());
+	if (!ent) {
+		return nullptr;
+	}
+	return std::make_unique<fs::MappedStream>(m_file.subview((size_t)ent->offset, (size_t)ent->size));
+}
+
+// --------------------------------------------------------------------------------------------------------
+PackBuilder::Source* PackBuilder::_add(std::string_view name) {
+	auto key = VfsRelativeKey(name);
+	if (key.empty() || key.size() > UINT16_MAX || key == ".." || key.starts_with("../")) {
+		log_error("PackBuilder: invalid name '%.*s'", (int)name.size(), name.data());
+		return nullptr;
+	}
+
+	if (auto it = m_by_name.find(key); it != m_by_name.end()) {
+		auto& src = m_sources[it->second];
+		src.host_path.clear();
+		src.data.clear();
+		return &src;
+	}
+	m_by_name.emplace(key, m_sources.size());
+	auto& src = m_sources.emplace_back();
+	src.name = std::move(key);
+	return &src;
+}
+
+bool PackBuilder::addHostFile(std::string_view name, const fs::path& hostPath) {
+	auto* src = _add(name);
+	if (!src) {
+		return false;
+	}
+	src->host_path = hostPath;
+	return true;
+}
+
+bool PackBuilder::addFile(std::string_view name, std::string data) {
+	auto* src = _add(name);
+	if (!src) {
+		return false;
+	}
+	src->data = std::move(data);
+	return true;
+}
+
+intmax_t PackBuilder::addDirectory(const fs::path& hostDir, std::string_view prefix) {
+	if (!posix_stat(hostDir).IsDir()) {
+		log_error("PackBuilder: '%s' is not a directory", hostDir.c_str());
+		return -1;
+	}
+
+	fs::DirWalkOptions options;
+	options.symlinks = fs::SymlinkPolicy::Follow;
+
+	intmax_t count = 0;
+	for (auto& result : fs::WalkDirectorySorted(hostDir, options)) {
+		if (result.type != fs::DirEntryType::File) {
+			continue;
+		}
+		std::string name(prefix);
+		if (!name.empty()) {
+			name += '/';
+		}
+		name += result.rel_path;
+		if (addHostFile(name, hostDir / result.rel_path)) {
+			++count;
+		}
+	}
+	return count;
+}
+
+bool PackBuilder::write(const fs::path& path) const {
+	std::string tmppath = path.native();
+	tmppath += ".tmp";
+
+	BufferedWriter writer({ .buffer_size = 1024 * 1024 });
+	if (!writer.open(tmppath.c_str())) {
+		log_error("PackBuilder: failed to create '%s': %s", tmppath.c_str(), strerror(writer.error()));
+		return false;
+	}
+
+	auto fail = [&](const char* what, const char* name) {
+		log_error("PackBuilder: %s '%s'", what, name);
+		writer.close();
+		posix_unlink(tmppath.c_str());
+		return false;
+	};
+
+	static const uint8_t zeros[kPackAlignment] = {};
+
+	PackHeader hdr = {};
+	memcpy(hdr.magic, kPackMagic, sizeof(kPackMagic));
+	hdr.version		= kPackVersion;
+	hdr.data_offset	= sizeof(PackHeader);
+	writer.write(&hdr, sizeof(hdr));		// rewritten once the index is known
+
+	// payloads, in the order added, so that files added together (eg. from the same directory) are adjacent
+	// in the archive.
+	std::vector<PackEntry> entries(m_sources.size());
+	uint64_t pos = sizeof(PackHeader);
+
+	for (size_t i = 0; i < m_sources.size(); ++i) {
+		auto& src = m_sources[i];
+
+		MappedFile mapped;
+		std::string_view data = src.data;
+		if (!src.host_path.empty()) {
+			if (!mapped.open(src.host_path, { MapAccess::ReadOnly, MapAdvice::Sequential })) {
+				return fail("failed to read", src.host_path.c_str());
+			}
+			data = mapped.view();
+		}
+
+		auto& ent = entries[i];
+		ent.name_hash	= fs::PathHash(src.name);
+		ent.offset		= pos;
+		ent.size		= data.size();
+		ent.checksum	= PackChecksum(data.data(), data.size());
+
+		auto padding = (size_t)(-(intmax_t)data.size() & (kPackAlignment - 1));
+		if (!writer.write(data) || !writer.write(zeros, padding)) {
+			return fail("failed to write", tmppath.c_str());
+		}
+		pos += data.size() + padding;
+	}
+
+	// index, sorted by hash for lookup. Names break ties so that the output is deterministic.
+	std::vector<uint32_t> order(entries.size());
+	for (uint32_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		if (entries[a].name_hash != entries[b].name_hash) {
+			return entries[a].name_hash < entries[b].name_hash;
+		}
+		return m_sources[a].name < m_sources[b].name;
+	});
+
+	std::string names;
+	std::vector<PackEntry> index;
+	index.reserve(entries.size());
+	for (auto i : order) {
+		auto& name = m_sources[i].name;
+		if (names.size() + name.size() + 1 > UINT32_MAX) {
+			return fail("too many names for", path.c_str());
+		}
+		auto& ent = index.emplace_back(entries[i]);
+		ent.name_offset	= (uint32_t)names.size();
+		ent.name_length	= (uint16_t)name.size();
+		names.append(name.data(), name.size() + 1);
+	}
+
+	hdr.entry_count		= (uint32_t)index.size();
+	hdr.index_offset	= pos;
+	hdr.names_offset	= pos + index.size() * sizeof(PackEntry);
+	hdr.names_size		= names.size();
+	hdr.file_size		= hdr.names_offset + hdr.names_size;
+	hdr.index_checksum	= PackChecksum(names.data(), names.size(), PackChecksum(index.data(), index.size() * sizeof(PackEntry)));
+
+	if (!writer.write(index.data(), index.size() * sizeof(PackEntry)) || !writer.write(names) || !writer.flush()) {
+		return fail("failed to write", tmppath.c_str());
+	}
+	if (posix_pwrite(writer.fd(), &hdr, sizeof(hdr), 0) != (intmax_t)sizeof(hdr)) {
+		return fail("failed to write header of", tmppath.c_str());
+	}
+	if (!writer.close()) {
+		posix_unlink(tmppath.c_str());
+		return false;
+	}
+
+#if PLATFORM_MSW
+	posix_unlink(path);		// rename does not replace existing files on Windows.
+#endif
+	if (rename(tmppath.c_str(), path) != 0) {
+		log_error("PackBuilder: failed to rename '%s' to '%s': %s", tmppath.c_str(), path.c_str(), strerror(errno));
+		posix_unlink(tmppath.c_str());
+		return false;
+	}
+	return true;
+}
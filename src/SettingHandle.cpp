@@ -0,0 +1,66 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "icySettingHandle.h"
+#include "icyAppSettingsMap.h"
+#include "icy_assert.h"
+
+#include <unordered_map>
+
+namespace icyAppSettingsIfc
+{
+
+struct SettingHandleRegistry {
+	std::unordered_multimap<std::string_view, SettingHandleBase*>	byName;
+};
+
+// function-local static so that handles can register from any TU's static initializers.
+static SettingHandleRegistry& _registry() {
+	static SettingHandleRegistry s_registry;
+	return s_registry;
+}
+
+SettingHandleBase::SettingHandleBase(char const* name) {
+	m_name = name;
+	m_registered = false;
+}
+
+SettingHandleBase::~SettingHandleBase() {
+	if (!m_registered) {
+		return;
+	}
+
+	auto& reg = _registry();
+	auto [beg, end] = reg.byName.equal_range(m_name);
+	for (auto it = beg; it != end; ++it) {
+		if (it->second == this) {
+			reg.byName.erase(it);
+			break;
+		}
+	}
+}
+
+void SettingHandleBase::_register() {
+	assertD(!m_registered);
+	_registry().byName.emplace(m_name, this);
+	m_registered = true;
+
+	// handles declared after config load (function-local statics, for example) pick up the current value.
+	std::string_view rval;
+	if (appLookupSetting(m_name, rval)) {
+		_refresh(&rval);
+	}
+}
+
+void _notifySettingHandles(std::string_view name, std::string_view const* rval) {
+	auto& reg = _registry();
+	if (reg.byName.empty()) {
+		return;
+	}
+
+	auto [beg, end] = reg.byName.equal_range(name);
+	for (auto it = beg; it != end; ++it) {
+		it->second->_refresh(rval);
+	}
+}
+
+} // namespace
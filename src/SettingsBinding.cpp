@@ -0,0 +1,59 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "icySettingsBinding.h"
+#include "icyAppSettingsMap.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace icyAppSettingsIfc::_template_impl
+{
+
+uint32_t const* HashSettingFields(SettingFieldDesc const* fields, size_t count) {
+	// lives for the duration of the program, same as the field table it describes.
+	auto* hashes = new uint32_t[count];
+	for (size_t i = 0; i < count; ++i) {
+		hashes[i] = FlatStringMapHash(fields[i].name);
+	}
+	return hashes;
+}
+
+static bool _assignField(void* dest, void const* defaults, SettingFieldDesc const& field) {
+	std::string_view rval;
+	bool exists = appLookupSetting(field.name, rval);
+	return field.assign((char*)dest + field.offset, (char const*)defaults + field.offset, exists ? &rval : nullptr);
+}
+
+int FillSettingsStruct(void* dest, void const* defaults, SettingsFieldSpan const& span) {
+	int numSet = 0;
+	for (size_t i = 0; i < span.count; ++i) {
+		numSet += _assignField(dest, defaults, span.fields[i]);
+	}
+	return numSet;
+}
+
+int RefillSettingsStruct(void* dest, void const* defaults, SettingsFieldSpan const& span, uint64_t& inoutGeneration) {
+	static thread_local std::vector<uint32_t> s_changed;
+
+	auto generation = appGetSettingsGeneration();
+	if (!_getSettingsChangedSince(inoutGeneration, s_changed)) {
+		inoutGeneration = generation;
+		FillSettingsStruct(dest, defaults, span);
+		return (int)span.count;
+	}
+	inoutGeneration = generation;
+
+	std::sort(s_changed.begin(), s_changed.end());
+
+	// hash collisions only cause an unchanged field to be reassigned, which is harmless.
+	int numAssigned = 0;
+	for (size_t i = 0; i < span.count; ++i) {
+		if (std::binary_search(s_changed.begin(), s_changed.end(), span.hashes[i])) {
+			_assignField(dest, defaults, span.fields[i]);
+			++numAssigned;
+		}
+	}
+	return numAssigned;
+}
+
+} // namespace
@@ -0,0 +1,185 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "icyAppSettingsQuery.h"
+#include "icyAppSettingsMap.h"
+#include "StringUtil.h"
+#include "icy_assert.h"
+
+#include <map>
+#include <memory>
+
+namespace icyAppSettingsIfc
+{
+
+static constexpr char kSettingsKeyDelimiter = '.';
+
+struct SettingsKeyNode {
+	std::map<std::string, std::unique_ptr<SettingsKeyNode>, std::less<>>	children;
+	std::string		key;			// full key, valid only if isSetting
+	bool			isSetting = false;
+};
+
+static SettingsKeyNode s_root;
+
+// Iterates the segments of a dotted key. Empty segments are preserved, so that 'a.' and 'a' remain
+// distinct keys ('a.' has an empty trailing segment).
+struct SettingsKeySegments {
+	std::string_view	remain;
+	bool				done;
+
+	SettingsKeySegments(std::string_view key) {
+		remain	= key;
+		done	= key.empty();
+	}
+
+	bool next(std::string_view& outSegment) {
+		if (done) {
+			return false;
+		}
+		auto pos = remain.find(kSettingsKeyDelimiter);
+		if (pos == remain.npos) {
+			outSegment = remain;
+			done = true;
+		}
+		else {
+			outSegment = remain.substr(0, pos);
+			remain = remain.substr(pos + 1);
+		}
+		return true;
+	}
+};
+
+static bool _beginsWith(std::string_view str, std::string_view prefix) {
+	return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+
+static SettingsKeyNode const* _findNode(std::string_view key) {
+	auto* node = &s_root;
+	SettingsKeySegments segments(key);
+	std::string_view segment;
+	while (segments.next(segment)) {
+		auto it = node->children.find(segment);
+		if (it == node->children.end()) {
+			return nullptr;
+		}
+		node = it->second.get();
+	}
+	return node;
+}
+
+void _indexSettingKey(std::string_view key) {
+	auto* node = &s_root;
+	SettingsKeySegments segments(key);
+	std::string_view segment;
+	while (segments.next(segment)) {
+		auto it = node->children.find(segment);
+		if (it == node->children.end()) {
+			it = node->children.emplace(std::string(segment), std::make_unique<SettingsKeyNode>()).first;
+		}
+		node = it->second.get();
+	}
+	if (!node->isSetting) {
+		node->isSetting = true;
+		node->key = key;
+	}
+}
+
+// returns TRUE if the node is now empty and can be pruned by its parent.
+static bool _unindexRecursive(SettingsKeyNode& node, SettingsKeySegments segments) {
+	std::string_view segment;
+	if (!segments.next(segment)) {
+		node.isSetting = false;
+		node.key.clear();
+	}
+	elif (auto it = node.children.find(segment); it != node.children.end()) {
+		if (_unindexRecursive(*it->second, segments)) {
+			node.children.erase(it);
+		}
+	}
+	return !node.isSetting && node.children.empty();
+}
+
+void _unindexSettingKey(std::string_view key) {
+	_unindexRecursive(s_root, SettingsKeySegments(key));
+}
+
+static int _visitSubtree(SettingsKeyNode const& node, SettingsVisitFunc const& func, CompiledSettingsGlob const* glob) {
+	int count = 0;
+	if (node.isSetting && (!glob || glob->matches(node.key))) {
+		std::string_view value;
+		if (appLookupSetting(node.key, value)) {
+			func(node.key, value);
+			++count;
+		}
+	}
+	for (auto const& [segment, child] : node.children) {
+		count += _visitSubtree(*child, func, glob);
+	}
+	return count;
+}
+
+static int _visitPrefix(std::string_view prefix, SettingsVisitFunc const& func, CompiledSettingsGlob const* glob) {
+	// all but the last segment of the prefix must match exactly. The last segment is a partial match,
+	// which selects a contiguous range of the (sorted) children.
+	auto* node = &s_root;
+	SettingsKeySegments segments(prefix);
+	std::string_view partial, segment;
+	if (segments.next(partial)) {
+		while (segments.next(segment)) {
+			auto it = node->children.find(partial);
+			if (it == node->children.end()) {
+				return 0;
+			}
+			node = it->second.get();
+			partial = segment;
+		}
+	}
+
+	int count = 0;
+	for (auto it = node->children.lower_bound(partial); it != node->children.end() && _beginsWith(it->first, partial); ++it) {
+		count += _visitSubtree(*it->second, func, glob);
+	}
+	return count;
+}
+
+int appForEachSettingWithPrefix(std::string_view prefix, SettingsVisitFunc const& func) {
+	return _visitPrefix(prefix, func, nullptr);
+}
+
+int appForEachSettingMatching(CompiledSettingsGlob const& glob, SettingsVisitFunc const& func) {
+	if (glob.is_literal()) {
+		std::string_view value;
+		if (appLookupSetting(glob.pattern(), value)) {
+			func(glob.pattern(), value);
+			return 1;
+		}
+		return 0;
+	}
+	return _visitPrefix(glob.literal_prefix(), func, &glob);
+}
+
+int appForEachSettingChild(std::string_view parent, std::function<void(std::string_view segment, bool isSetting)> const& func) {
+	auto* node = parent.empty() ? &s_root : _findNode(parent);
+	if (!node) {
+		return 0;
+	}
+
+	for (auto const& [segment, child] : node->children) {
+		func(segment, child->isSetting);
+	}
+	return (int)node->children.size();
+}
+
+CompiledSettingsGlob::CompiledSettingsGlob(std::string_view pattern) {
+	m_pattern = pattern;
+	m_literal_length = m_pattern.find_first_of("*?[\\");
+	if (m_literal_length == m_pattern.npos) {
+		m_literal_length = m_pattern.size();
+	}
+}
+
+bool CompiledSettingsGlob::matches(std::string const& key) const {
+	return _beginsWith(key, literal_prefix()) && StringUtil::globMatch(m_pattern.c_str(), key.c_str());
+}
+
+} // namespace
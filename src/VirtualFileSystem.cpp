@@ -0,0 +1,486 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "VirtualFileSystem.h"
+#include "standardfilesystem.h"
+#include "StringUtil.h"
+#include "icy_log.h"
+
+#include <algorithm>
+#include <mutex>
+
+bool VfsKeyEqual::operator()(std::string_view a, std::string_view b) const {
+	return a.size() == b.size() && StringUtil::CompareCase(a, b) == 0;
+}
+
+std::string VfsRelativeKey(std::string_view path) {
+	auto start = path.find_first_not_of('/');
+	if (start == path.npos) {
+		return {};
+	}
+	std::string key(path.substr(start));
+	key.resize(fs::LexicallyNormalize(key.data(), key.size()));
+	if (key == ".") {
+		key.clear();
+	}
+	return key;
+}
+
+// splits a normalized universal path into its index key and the components which follow it.
+static std::string _splitPath(std::string_view uni, std::vector<std::string_view>& rest) {
+	rest.clear();
+	for (auto comp : fs::path_components{ uni }) {
+		rest.push_back(comp);
+	}
+	if (rest.empty()) {
+		return {};
+	}
+
+	std::string key;
+	if (rest[0] == "/" && rest.size() > 1) {
+		key = "/";
+		key += rest[1];
+		rest.erase(rest.begin(), rest.begin() + 2);
+	}
+	else {
+		key = rest[0];
+		rest.erase(rest.begin());
+	}
+	return key;
+}
+
+static CStatInfo _virtualDirStat() {
+	CStatInfo st = {};
+	st.st_mode = S_IFDIR | 0555;
+	return st;
+}
+
+// --------------------------------------------------------------------------------------------------------
+VirtualFileSystem::VirtualFileSystem() {
+	m_fallback = std::make_shared<StandardFileSystem>();
+}
+
+VirtualFileSystem::~VirtualFileSystem() = default;
+
+VirtualFileSystem::MountId VirtualFileSystem::Mount(std::string_view mountPoint, std::shared_ptr<FileSystemInterface> backend, const fs::path& backendRoot, const VfsMountOptions& options) {
+	auto normal = fs::path(std::string(mountPoint)).lexically_normal();
+
+	std::vector<std::string_view> rest;
+	auto key = _splitPath(normal.uni_string(), rest);
+	if (mountPoint.empty() || key.empty() || !backend) {
+		log_error("VirtualFileSystem: invalid mount at '%.*s'", (int)mountPoint.size(), mountPoint.data());
+		return -1;
+	}
+
+	auto entry = std::make_unique<MountEntry>();
+	entry->key			= key;
+	entry->prefix		= { rest.begin(), rest.end() };
+	entry->backend		= std::move(backend);
+	entry->backend_root	= backendRoot.empty() ? fs::path() : backendRoot.lexically_normal();
+	entry->options		= options;
+
+	std::unique_lock lock(m_mutex);
+	entry->id = m_next_id++;
+	auto id = entry->id;
+	m_mounts[key].push_back(std::move(entry));
+	return id;
+}
+
+VirtualFileSystem::MountId VirtualFileSystem::Mount(std::string_view mountPoint, FileSystemInterface& backend, const fs::path& backendRoot, const VfsMountOptions& options) {
+	// aliasing constructor: a shared_ptr which points to backend without owning it.
+	return Mount(mountPoint, std::shared_ptr<FileSystemInterface>(std::shared_ptr<void>(), &backend), backendRoot, options);
+}
+
+VirtualFileSystem::MountId VirtualFileSystem::MountHostDirectory(std::string_view mountPoint, const fs::path& hostDir, const VfsMountOptions& options) {
+	return Mount(mountPoint, std::make_shared<StandardFileSystem>(), hostDir, options);
+}
+
+bool VirtualFileSystem::Unmount(MountId id) {
+	std::unique_lock lock(m_mutex);
+	for (auto it = m_mounts.begin(); it != m_mounts.end(); ++it) {
+		auto& bucket = it->second;
+		auto found = std::find_if(bucket.begin(), bucket.end(), [&](const auto& mount) { return mount->id == id; });
+		if (found != bucket.end()) {
+			bucket.erase(found);
+			if (bucket.empty()) {
+				m_mounts.erase(it);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void VirtualFileSystem::SetFallback(std::shared_ptr<FileSystemInterface> fallback) {
+	std::unique_lock lock(m_mutex);
+	m_fallback = std::move(fallback);
+}
+
+bool VirtualFileSystem::_candidates(const fs::path& path, std::vector<Candidate>& dest, VfsNameSet* mountDirs) const {
+	dest.clear();
+
+	auto normal = path.lexically_normal();
+	std::string_view uni = normal.uni_string();
+
+	std::vector<std::string_view> rest;
+	auto key = _splitPath(uni, rest);
+	if (key.empty()) {
+		return false;
+	}
+
+	auto match = [&](const MountEntry& mount, size_t skip) {
+		// skip: number of leading components of rest which have been matched by the key.
+		auto& prefix = mount.prefix;
+		auto avail = rest.size() - skip;
+		auto common = std::min(prefix.size(), avail);
+		for (size_t i = 0; i < common; ++i) {
+			if (!VfsKeyEqual{}(prefix[i], rest[skip + i])) {
+				return;
+			}
+		}
+
+		if (prefix.size() > avail) {
+			// the path is an ancestor of the mount point.
+			if (mountDirs) {
+				mountDirs->emplace(prefix[avail]);
+			}
+			return;
+		}
+
+		std::string_view remainder;
+		std::string clamped;
+		if (avail > prefix.size()) {
+			auto* start = rest[skip + prefix.size()].data();
+			remainder = uni.substr(start - uni.data());
+
+			// '..' must not climb above the mount point, which would escape the backend root of a host
+			// mount. Normalization already clamps rooted paths (rom:/.., /opt/..) at their root, so this is
+			// a guard for spellings it leaves alone, and costs one scan otherwise.
+			auto first = rest.begin() + skip + prefix.size();
+			if (std::find(first, rest.end(), std::string_view("..")) != rest.end()) {
+				std::vector<std::string_view> comps;
+				for (auto it = first; it != rest.end(); ++it) {
+					if (*it != "..") {
+						comps.push_back(*it);
+					}
+					elif (!comps.empty()) {
+						comps.pop_back();
+					}
+				}
+				for (auto comp : comps) {
+					if (!clamped.empty()) {
+						clamped += '/';
+					}
+					clamped += comp;
+				}
+				remainder = clamped;
+			}
+		}
+
+		fs::path backendPath;
+		if (mount.backend_root.empty()) {
+			backendPath = fs::path(std::string(remainder));
+		}
+		elif (remainder.empty()) {
+			backendPath = mount.backend_root;
+		}
+		else {
+			backendPath = mount.backend_root / std::string(remainder);
+		}
+		dest.push_back({ &mount, std::move(backendPath) });
+	};
+
+	if (auto it = m_mounts.find(key); it != m_mounts.end()) {
+		for (auto& mount : it->second) {
+			match(*mount, 0);
+		}
+	}
+
+	if (uni[0] == '/') {
+		// mounts at the root cover every rooted path. The root itself is keyed as "/", with no components
+		// following, and so has already been matched above.
+		if (key != "/") {
+			if (auto it = m_mounts.find("/"); it != m_mounts.end()) {
+				rest.insert(rest.begin(), std::string_view(key).substr(1));
+				for (auto& mount : it->second) {
+					match(*mount, 0);
+				}
+				rest.erase(rest.begin());
+			}
+		}
+		elif (mountDirs) {
+			for (auto& [mountKey, bucket] : m_mounts) {
+				if (mountKey.size() > 1 && mountKey[0] == '/') {
+					mountDirs->emplace(mountKey.substr(1));
+				}
+			}
+		}
+	}
+
+	auto depth = [](const MountEntry& mount) {
+		return mount.prefix.size() + (mount.key == "/" ? 0 : 1);
+	};
+	std::sort(dest.begin(), dest.end(), [&](const Candidate& a, const Candidate& b) {
+		auto& ma = *a.mount;
+		auto& mb = *b.mount;
+		if (ma.options.priority != mb.options.priority) {
+			return ma.options.priority > mb.options.priority;
+		}
+		if (depth(ma) != depth(mb)) {
+			return depth(ma) > depth(mb);
+		}
+		return ma.id > mb.id;
+	});
+
+	return !dest.empty();
+}
+
+CStatInfo VirtualFileSystem::Stat(const fs::path& path) {
+	std::vector<Candidate> candidates;
+	VfsNameSet mountDirs;
+
+	std::shared_lock lock(m_mutex);
+	if (!_candidates(path, candidates, &mountDirs)) {
+		if (m_fallback) {
+			auto st = m_fallback->Stat(path);
+			if (st.Exists()) {
+				return st;
+			}
+		}
+	}
+
+	for (auto& candidate : candidates) {
+		auto st = candidate.mount->backend->Stat(candidate.backend_path);
+		if (st.Exists()) {
+			return st;
+		}
+		if (candidate.mount->options.exclusive) {
+			break;
+		}
+	}
+
+	return mountDirs.empty() ? CStatInfo{} : _virtualDirStat();
+}
+
+bool VirtualFileSystem::Exists(const fs::path& path) {
+	std::vector<Candidate> candidates;
+	VfsNameSet mountDirs;
+
+	std::shared_lock lock(m_mutex);
+	if (!_candidates(path, candidates, &mountDirs)) {
+		if (m_fallback && m_fallback->Exists(path)) {
+			return true;
+		}
+	}
+
+	for (auto& candidate : candidates) {
+		if (candidate.mount->backend->Exists(candidate.backend_path)) {
+			return true;
+		}
+		if (candidate.mount->options.exclusive) {
+			break;
+		}
+	}
+	return !mountDirs.empty();
+}
+
+void VirtualFileSystem::VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) {
+	std::vector<Candidate> candidates;
+	VfsNameSet mountDirs;
+	VfsNameSet seen;
+
+	// entries are reported relative to the virtual path, whichever backend they came from. Names provided by
+	// more than one mount are reported once.
+	auto visitName = [&](std::string_view name) {
+		if (seen.emplace(name).second) {
+			visitFunc(path / std::string(name));
+		}
+	};
+	auto visitBackendPath = [&](const fs::path& backendPath) {
+		visitName(backendPath.filename_view());
+	};
+
+	std::shared_lock lock(m_mutex);
+	if (!_candidates(path, candidates, &mountDirs)) {
+		if (m_fallback) {
+			m_fallback->VisitDirectoryContents(visitBackendPath, path);
+		}
+	}
+
+	for (auto& candidate : candidates) {
+		candidate.mount->backend->VisitDirectoryContents(visitBackendPath, candidate.backend_path);
+		if (candidate.mount->options.exclusive) {
+			break;
+		}
+	}
+
+	for (auto& name : mountDirs) {
+		visitName(name);
+	}
+}
+
+std::unique_ptr<fs::InputStream> VirtualFileSystem::Open(const fs::path& path) {
+	std::vector<Candidate> candidates;
+
+	std::shared_lock lock(m_mutex);
+	if (!_candidates(path, candidates)) {
+		return m_fallback ? m_fallback->Open(path) : nullptr;
+	}
+
+	for (auto& candidate : candidates) {
+		if (auto stream = candidate.mount->backend->Open(candidate.backend_path)) {
+			return stream;
+		}
+		if (candidate.mount->options.exclusive) {
+			break;
+		}
+	}
+	return nullptr;
+}
+
+bool VirtualFileSystem::Resolve(const fs::path& path, std::shared_ptr<FileSystemInterface>& backend, fs::path& backendPath) {
+	std::vector<Candidate> candidates;
+
+	std::shared_lock lock(m_mutex);
+	if (!_candidates(path, candidates)) {
+		if (m_fallback && m_fallback->Exists(path)) {
+			backend		= m_fallback;
+			backendPath	= path;
+			return true;
+		}
+		return false;
+	}
+
+	for (auto& candidate : candidates) {
+		if (candidate.mount->backend->Exists(candidate.backend_path)) {
+			backend		= candidate.mount->backend;
+			backendPath	= std::move(candidate.backend_path);
+			return true;
+		}
+		if (candidate.mount->options.exclusive) {
+			break;
+		}
+	}
+	return false;
+}
+
+// --------------------------------------------------------------------------------------------------------
+void BlobFileSystem::_addFile(std::string_view path, Blob&& blob) {
+	auto key = VfsRelativeKey(path);
+	if (key.empty()) {
+		log_error("BlobFileSystem: invalid file path '%.*s'", (int)path.size(), path.data());
+		return;
+	}
+
+	std::unique_lock lock(m_mutex);
+	m_files.insert_or_assign(key, std::move(blob));
+
+	// registers the file with its parent dir, and any new dirs with theirs.
+	std::string_view child = key;
+	for (;;) {
+		auto pos	= child.find_last_of('/');
+		auto dir	= (pos == child.npos) ? std::string_view{} : child.substr(0, pos);
+		auto name	= (pos == child.npos) ? child : child.substr(pos + 1);
+
+		auto it = m_dirs.find(dir);
+		if (it == m_dirs.end()) {
+			it = m_dirs.emplace(std::string(dir), VfsNameSet{}).first;
+		}
+		if (!it->second.emplace(name).second || dir.empty()) {
+			break;
+		}
+		child = dir;
+	}
+}
+
+void BlobFileSystem::AddFile(std::string_view path, std::span<const uint8_t> data) {
+	_addFile(path, { data, nullptr });
+}
+
+void BlobFileSystem::AddFile(std::string_view path, std::string data) {
+	auto owned = std::make_shared<const std::string>(std::move(data));
+	std::span<const uint8_t> span((const uint8_t*)owned->data(), owned->size());
+	_addFile(path, { span, std::move(owned) });
+}
+
+bool BlobFileSystem::RemoveFile(std::string_view path) {
+	auto key = VfsRelativeKey(path);
+
+	std::unique_lock lock(m_mutex);
+	if (!m_files.erase(key)) {
+		return false;
+	}
+
+	// unregisters the file from its parent dir, and removes dirs which are left empty.
+	std::string_view child = key;
+	for (;;) {
+		auto pos	= child.find_last_of('/');
+		auto dir	= (pos == child.npos) ? std::string_view{} : child.substr(0, pos);
+		auto name	= (pos == child.npos) ? child : child.substr(pos + 1);
+
+		auto it = m_dirs.find(dir);
+		if (it == m_dirs.end()) {
+			break;
+		}
+		it->second.erase(std::string(name));
+		if (!it->second.empty() || dir.empty()) {
+			break;
+		}
+		m_dirs.erase(it);
+		child = dir;
+	}
+	return true;
+}
+
+CStatInfo BlobFileSystem::Stat(const fs::path& path) {
+	auto key = VfsRelativeKey(path.uni_string());
+
+	std::shared_lock lock(m_mutex);
+	if (auto it = m_files.find(key); it != m_files.end()) {
+		CStatInfo st = {};
+		st.st_mode			= S_IFREG | 0444;
+		st.st_size			= (intmax_t)it->second.data.size();
+		st.time_accessed	= m_created;
+		st.time_modified	= m_created;
+		st.time_changed		= m_created;
+		return st;
+	}
+	if (key.empty() || m_dirs.count(key)) {
+		auto st = _virtualDirStat();
+		st.time_accessed	= m_created;
+		st.time_modified	= m_created;
+		st.time_changed		= m_created;
+		return st;
+	}
+	return {};
+}
+
+bool BlobFileSystem::Exists(const fs::path& path) {
+	auto key = VfsRelativeKey(path.uni_string());
+
+	std::shared_lock lock(m_mutex);
+	return key.empty() || m_files.count(key) || m_dirs.count(key);
+}
+
+void BlobFileSystem::VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) {
+	auto key = VfsRelativeKey(path.uni_string());
+
+	std::shared_lock lock(m_mutex);
+	auto it = m_dirs.find(key);
+	if (it == m_dirs.end()) {
+		return;
+	}
+	for (auto& name : it->second) {
+		visitFunc(path / name);
+	}
+}
+
+std::unique_ptr<fs::InputStream> BlobFileSystem::Open(const fs::path& path) {
+	auto key = VfsRelativeKey(path.uni_string());
+
+	std::shared_lock lock(m_mutex);
+	auto it = m_files.find(key);
+	if (it == m_files.end()) {
+		return nullptr;
+	}
+	return std::make_unique<fs::SharedMemoryStream>(it->second.owned, it->second.data.data(), it->second.data.size());
+}
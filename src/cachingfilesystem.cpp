@@ -0,0 +1,376 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+#include "cachingfilesystem.h"
+#include "standardfilesystem.h"
+#include "icy_assert.h"
+
+#if PLATFORM_LINUX
+#	include <sys/inotify.h>
+
+static constexpr uint32_t kCachingWatchMask =
+	IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+	IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+static constexpr uint32_t kCachingListingChangeMask =
+	IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+#endif
+
+CachingFileSystem::CachingFileSystem(FileSystemInterface* backing, size_t maxEntries, CacheInvalidation invalidation) {
+	if (!backing) {
+		m_owned_backing = std::make_unique<StandardFileSystem>();
+		backing = m_owned_backing.get();
+	}
+	m_backing		= backing;
+	m_max_entries	= std::max<size_t>(1, maxEntries);
+
+	if (invalidation == CacheInvalidation::Manual) {
+		m_manual	= true;
+		m_caching	= true;
+		return;
+	}
+
+	// without change notifications nothing is cached (open() logs why, where inotify exists but fails).
+	if (!m_inotify.open("CachingFileSystem")) {
+		return;
+	}
+	m_caching = true;
+	m_event_thread = std::thread([this] { _eventThread(); });
+}
+
+CachingFileSystem::~CachingFileSystem() {
+	if (m_event_thread.joinable()) {
+		m_inotify.wake();
+		m_event_thread.join();
+	}
+}
+
+std::string CachingFileSystem::_makeKey(const fs::path& path) const {
+	return path.lexically_normal().uni_string();
+}
+
+CachingFileSystem::Entry* CachingFileSystem::_touch(const std::string& key) {
+	auto it = m_entries.find(key);
+	if (it == m_entries.end()) {
+		return nullptr;
+	}
+	m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+	return &it->second;
+}
+
+CachingFileSystem::Entry& CachingFileSystem::_emplace(const std::string& key) {
+	if (auto* entry = _touch(key)) {
+		return *entry;
+	}
+	auto& entry = m_entries[key];
+	m_lru.push_front(key);
+	entry.lru = m_lru.begin();
+	return entry;
+}
+
+int CachingFileSystem::_acquireWatch(const std::string& dir) {
+#if PLATFORM_LINUX
+	if (auto it = m_watch_dirs.find(dir); it != m_watch_dirs.end()) {
+		if (auto wit = m_watches.find(it->second); wit != m_watches.end()) {
+			++wit->second.refs;
+			return it->second;
+		}
+		m_watch_dirs.erase(it);		// stale alias of a since-removed watch
+	}
+
+	int wd = m_inotify.addWatch(dir.c_str(), kCachingWatchMask);
+	if (wd < 0) {
+		return -1;
+	}
+
+	// the kernel returns the existing descriptor when the same directory is reached via another path
+	// (symlinks), in which case events must invalidate entries under every such path.
+	m_watch_dirs[dir] = wd;
+	auto& watch = m_watches[wd];
+	if (watch.dirs.empty()) {
+		// stamped so that a query still holding a removed watch whose descriptor was since reused sees a change.
+		watch.generation = ++m_generation;
+	}
+	watch.dirs.push_back(dir);
+	++watch.refs;
+	return wd;
+#else
+	return -1;
+#endif
+}
+
+void CachingFileSystem::_releaseWatch(int wd) {
+	auto it = m_watches.find(wd);
+	if (it == m_watches.end()) {
+		return;
+	}
+	if (--it->second.refs > 0) {
+		return;
+	}
+	m_inotify.removeWatch(wd);
+	for (const auto& dir : it->second.dirs) {
+		m_watch_dirs.erase(dir);
+	}
+	m_watches.erase(it);
+}
+
+// TRUE if the watch has received no events since the given generation. A watch which no longer exists has
+// lost events (IN_IGNORED, overflow), and is considered changed. -1 (no watch) is always unchanged.
+bool CachingFileSystem::_watchUnchanged(int wd, uint64_t generation) const {
+	if (wd < 0) {
+		return true;
+	}
+	auto it = m_watches.find(wd);
+	return it != m_watches.end() && it->second.generation <= generation;
+}
+
+void CachingFileSystem::_erase(const std::string& key) {
+	auto it = m_entries.find(key);
+	if (it == m_entries.end()) {
+		return;
+	}
+	auto& entry = it->second;
+	if (entry.stat_wd >= 0) {
+		_releaseWatch(entry.stat_wd);
+	}
+	if (entry.list_wd >= 0) {
+		_releaseWatch(entry.list_wd);
+	}
+	m_lru.erase(entry.lru);
+	m_entries.erase(it);
+}
+
+void CachingFileSystem::_eraseByWatch(int wd) {
+	// the watch is gone (directory deleted or unmounted), so nothing that depended on it can be trusted.
+	if (auto it = m_watches.find(wd); it != m_watches.end()) {
+		for (const auto& dir : it->second.dirs) {
+			m_watch_dirs.erase(dir);
+		}
+		m_watches.erase(it);
+	}
+
+	for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+		auto& entry = it->second;
+		if (entry.stat_wd == wd || entry.list_wd == wd) {
+			if (entry.stat_wd >= 0 && entry.stat_wd != wd) {
+				_releaseWatch(entry.stat_wd);
+			}
+			if (entry.list_wd >= 0 && entry.list_wd != wd) {
+				_releaseWatch(entry.list_wd);
+			}
+			m_lru.erase(entry.lru);
+			it = m_entries.erase(it);
+			++m_invalidations;
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void CachingFileSystem::_eraseAll() {
+	for (const auto& [wd, watch] : m_watches) {
+		m_inotify.removeWatch(wd);
+	}
+	m_invalidations += m_entries.size();
+	m_entries.clear();
+	m_lru.clear();
+	m_watches.clear();
+	m_watch_dirs.clear();
+	m_reset_generation = ++m_generation;
+}
+
+void CachingFileSystem::_evictExcess() {
+	while (m_entries.size() > m_max_entries) {
+		_erase(m_lru.back());
+		++m_evictions;
+	}
+}
+
+void CachingFileSystem::_handleEvent(int wd, uint32_t mask, const char* name) {
+#if PLATFORM_LINUX
+	if (mask & IN_Q_OVERFLOW) {
+		_eraseAll();
+		return;
+	}
+
+	auto it = m_watches.find(wd);
+	if (it == m_watches.end()) {
+		return;
+	}
+
+	// in-flight queries which depend on this watch, and started before this event, must not store their
+	// (possibly stale) results. Queries on other directories are unaffected.
+	it->second.generation = ++m_generation;
+
+	auto before = m_entries.size();
+	auto dirs = it->second.dirs;		// copied, since erasing entries may release the watch
+	for (const auto& dir : dirs) {
+		if (name && name[0]) {
+			_erase(native_child_path(dir, name));
+		}
+
+		// the directory's own stat (mtime) and listing change when entries are added or removed.
+		if (!(name && name[0]) || (mask & kCachingListingChangeMask)) {
+			_erase(dir);
+		}
+	}
+	m_invalidations += before - m_entries.size();
+
+	if (mask & IN_IGNORED) {
+		_eraseByWatch(wd);
+	}
+#endif
+}
+
+void CachingFileSystem::_eventThread() {
+	InotifyReady ready;
+	while (m_inotify.wait(-1, ready) && !ready.woken) {
+		std::lock_guard lock(m_mutex);
+		m_inotify.readEvents([&](int wd, uint32_t mask, const char* name) { _handleEvent(wd, mask, name); });
+	}
+
+	// stop caching: the cache can no longer be kept coherent.
+	std::lock_guard lock(m_mutex);
+	m_caching = false;
+	_eraseAll();
+}
+
+// watchParent: the result depends on the entry within its parent directory (stat, existence).
+// watchSelf:   returns TRUE if the result also depends on the contents of the path itself (listings, and
+//              the stat of a directory, whose mtime changes as entries are added or removed).
+template<typename T, typename WatchSelfFunc, typename ReadFunc, typename FetchFunc, typename StoreFunc>
+T CachingFileSystem::_cachedQuery(const fs::path& path, bool watchParent, WatchSelfFunc&& watchSelf, ReadFunc&& read, FetchFunc&& fetch, StoreFunc&& store) {
+	if (!IsCaching()) {
+		return fetch();
+	}
+
+	auto key = _makeKey(path);
+	int parentWd = -1, selfWd = -1;
+	uint64_t generation;
+	{
+		std::lock_guard lock(m_mutex);
+		if (auto* entry = _touch(key)) {
+			T result;
+			if (read(*entry, result)) {
+				++m_hits;
+				return result;
+			}
+		}
+		++m_misses;
+
+		// watches are established before querying the backing filesystem, so that no change can slip
+		// between the query and the watch. The self watch fails harmlessly for non-directories.
+		if (!m_manual) {
+			if (watchParent) {
+				parentWd = _acquireWatch(native_parent_dir(key));
+			}
+			selfWd = _acquireWatch(key);
+		}
+		generation = m_generation;
+	}
+
+	T result = fetch();
+
+	std::lock_guard lock(m_mutex);
+	bool needsSelf = watchSelf(result);
+	bool cacheable = (m_reset_generation <= generation)
+		&& _watchUnchanged(parentWd, generation)
+		&& _watchUnchanged(selfWd, generation)
+		&& (m_manual || (
+		   (!watchParent || parentWd >= 0)
+		&& (!needsSelf   || selfWd   >= 0)
+	));
+
+	if (!cacheable) {
+		_releaseWatch(parentWd);
+		_releaseWatch(selfWd);
+		return result;
+	}
+	if (!needsSelf) {
+		_releaseWatch(selfWd);
+		selfWd = -1;
+	}
+
+	auto& entry = _emplace(key);
+	for (auto [wd, entryWd] : { std::pair{ parentWd, &entry.stat_wd }, std::pair{ selfWd, &entry.list_wd } }) {
+		if (*entryWd < 0) {
+			*entryWd = wd;
+		}
+		else {
+			_releaseWatch(wd);
+		}
+	}
+	store(entry, result);
+	_evictExcess();
+	return result;
+}
+
+CStatInfo CachingFileSystem::Stat(const fs::path& path) {
+	return _cachedQuery<CStatInfo>(path, true,
+		[](const CStatInfo& st) { return st.IsDir(); },
+		[](Entry& entry, CStatInfo& dest) { dest = entry.stat; return entry.has_stat; },
+		[&] { return m_backing->Stat(path); },
+		[](Entry& entry, const CStatInfo& src) { entry.stat = src; entry.has_stat = true; }
+	);
+}
+
+bool CachingFileSystem::Exists(const fs::path& path) {
+	return _cachedQuery<bool>(path, true,
+		[](bool) { return false; },
+		[](Entry& entry, bool& dest) { dest = entry.exists; return entry.has_exists; },
+		[&] { return m_backing->Exists(path); },
+		[](Entry& entry, const bool& src) { entry.exists = src; entry.has_exists = true; }
+	);
+}
+
+void CachingFileSystem::VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) {
+	// the listing is copied out of the cache so that visitFunc runs without holding the lock.
+	auto listing = _cachedQuery<std::vector<fs::path>>(path, false,
+		[](const std::vector<fs::path>&) { return true; },
+		[](Entry& entry, std::vector<fs::path>& dest) {
+			if (entry.has_listing) {
+				dest = entry.listing;
+			}
+			return entry.has_listing;
+		},
+		[&] {
+			std::vector<fs::path> result;
+			m_backing->VisitDirectoryContents([&](const fs::path& item) { result.push_back(item); }, path);
+			return result;
+		},
+		[](Entry& entry, const std::vector<fs::path>& src) { entry.listing = src; entry.has_listing = true; }
+	);
+
+	for (const auto& item : listing) {
+		visitFunc(item);
+	}
+}
+
+std::unique_ptr<fs::InputStream> CachingFileSystem::Open(const fs::path& path) {
+	return m_backing->Open(path);
+}
+
+void CachingFileSystem::Invalidate(const fs::path& path) {
+	std::lock_guard lock(m_mutex);
+	m_reset_generation = ++m_generation;
+	auto before = m_entries.size();
+	_erase(_makeKey(path));
+	m_invalidations += before - m_entries.size();
+}
+
+void CachingFileSystem::InvalidateAll() {
+	std::lock_guard lock(m_mutex);
+	_eraseAll();
+}
+
+CachingFileSystem::CacheStats CachingFileSystem::GetCacheStats() const {
+	std::lock_guard lock(m_mutex);
+	return {
+		m_hits,
+		m_misses,
+		m_invalidations,
+		m_evictions,
+		m_entries.size(),
+		m_watches.size(),
+	};
+}
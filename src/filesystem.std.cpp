@@ -14,11 +14,16 @@
 
 namespace fs {
 
-bool path::operator == (const path& s) const { return strcasecmp(uni_path_.c_str(), s.uni_path_.c_str()) == 0; }
+// equality checks the cached hash first, so that mismatches (the common case in containers) cost a single
+// integer compare.
+bool path::operator == (const path& s) const {
+	return hash_ == s.hash_ && uni_path_.size() == s.uni_path_.size() && strcasecmp(uni_path_.c_str(), s.uni_path_.c_str()) == 0;
+}
+
 bool path::operator == (const char *s) const { return strcasecmp(uni_path_.c_str(), fs::PathFromString(s).c_str()) == 0; }
 
 #if !defined(__cpp_impl_three_way_comparison) || (__cpp_impl_three_way_comparison < 201907)
-bool path::operator != (const path& s) const { return strcasecmp(uni_path_.c_str(), s.uni_path_.c_str()) != 0; }
+bool path::operator != (const path& s) const { return !(*this == s); }
 bool path::operator != (const char *s) const { return strcasecmp(uni_path_.c_str(), fs::PathFromString(s).c_str()) != 0; }
 #endif
 
@@ -138,6 +143,7 @@ void path::update_native_path() {
 #if FILESYSTEM_NEEDS_OS_PATH
 	libc_path_ = ConvertToMsw(uni_path_);
 #endif
+	hash_ = PathHash(uni_path_);
 }
 
 bool stat(const path& fspath, struct ::stat& st) {
@@ -193,54 +193,79 @@ std::string ConvertFromMsw(const std::string& origPath, int maxMountLength)
 }
 
 // intended for use on fullpaths which have already had host prefixes removed.
+// src must be NUL-terminated. Writes a NUL-terminated result to dest and returns its length, or -1 if dest
+// is too small. Conversion never lengthens the path, except for prepending s_app0_dir to relative paths.
 template<bool MixedMode>
-std::string _tmpl_ConvertToMsw(const std::string& unix_path, int maxMountLength)
+intptr_t _tmpl_ConvertToMsw(const char* src, size_t srclen, int maxMountLength, char* dest, size_t destSize)
 {
-	if (unix_path.empty()) {
-		return {};
+	if (!destSize) {
+		return -1;
+	}
+
+	if (!srclen) {
+		dest[0] = 0;
+		return 0;
 	}
 
-	const char* src = unix_path.c_str();
+	std::string_view unix_path = { src, srclen };
+	auto beginsWith = [&](std::string_view prefix) {
+		return unix_path.size() >= prefix.size() && unix_path.compare(0, prefix.size(), prefix) == 0;
+	};
+
+	auto copyLiteral = [&](std::string_view literal) -> intptr_t {
+		if (literal.size() >= destSize) {
+			return -1;
+		}
+		memcpy(dest, literal.data(), literal.size());
+		dest[literal.size()] = 0;
+		return literal.size();
+	};
 
 	// null and tty automatically disregard subdirectories, as a convenience to programming paradigms.
 	// If a component sets a root dir to /dev/null then all files supposed to be created under that dir
 	// will become pipes in/out of /dev/null
 
-	bool append_approot = 1;
-	bool is_special_root = 0;
-
 	if (src[0] == '/') {
-		if (unix_path == "/dev/null" || StringUtil::BeginsWith(unix_path, "/dev/null/")) {
-			return "NUL";
+		if (unix_path == "/dev/null" || beginsWith("/dev/null/")) {
+			return copyLiteral("NUL");
 		}
 
-		if (unix_path == "/dev/tty" || StringUtil::BeginsWith(unix_path, "/dev/tty/")) {
-			return "CON";
+		if (unix_path == "/dev/tty" || beginsWith("/dev/tty/")) {
+			return copyLiteral("CON");
 		}
 	}
 
-	std::string result;
-	result.resize(unix_path.length());
-	char* dst = &result[0];
+	// only relative paths (including ./rel) get the app root, all forms of rooted path are exempt.
+	bool append_approot = (src[0] != '/');
+	bool is_special_root = 0;
+
+	auto maxlen = srclen + (append_approot ? s_app0_dir.length() : 0);
+	if (maxlen >= destSize) {
+		return -1;
+	}
+
+	char* dst = dest;
+	if (append_approot && !s_app0_dir.empty()) {
+		memcpy(dst, s_app0_dir.data(), s_app0_dir.length());
+		dst += s_app0_dir.length();
+	}
+
 	if (src[0] == '/' && isalnum((uint8_t)src[1]) && src[2] == '/') {
 		dst[0] = toupper(src[1]);
 		dst[1] = ':';
 		src  += 2;
 		dst  += 2;
-		append_approot = 0;
 	}
 	else if (src[0] == '.' && (src[1] == '/')) {
 		// relative to current dir, just strip the ".\"
 		src += 2;
 	}
 	else if (src[0] == '/') {
-		append_approot = 0;
-
 		// treat /cwd/ in a special way - it gets stripped and is -not- replaced with s_app0_dir
-		if (StringUtil::BeginsWith(unix_path, "/cwd/")) {
+		if (beginsWith("/cwd/")) {
 			src += 5;
 		}
-		elif (auto slash = unix_path.find_first_of('/', 1); slash < maxMountLength || unix_path.size() <= maxMountLength) {
+		elif (auto slash = unix_path.find_first_of('/', 1); slash < size_t(maxMountLength) || unix_path.size() <= size_t(maxMountLength)) {
 			// found a slash within the length limit.
 			// convert into a mount name prefix.
 			++src;
@@ -260,38 +285,122 @@ std::string _tmpl_ConvertToMsw(const std::string& unix_path, int maxMountLength)
 		}
 	}
 
-	if (is_special_root) {
+	if (is_special_root || MixedMode) {
+		// copy rest of the string char for char (mixed mode keeps forward slashes)
 		for(; src[0]; ++src, ++dst) {
 			dst[0] = src[0];
 		}
-		dst[0] = 0;
 	}
 	else {
-		if constexpr (MixedMode) {
-			// copy rest of the string char for char (mixed mode keeps forward slashes)
-			for(; src[0]; ++src, ++dst) {
-				dst[0] = src[0];
-			}
+		// copy rest of the string char for char, replacing '/' with '\\'
+		for(; src[0]; ++src, ++dst) {
+			dst[0] = (src[0] == '/') ? '\\' : src[0];
 		}
-		else {
-			// copy rest of the string char for char, replacing '/' with '\\'
-			for(; src[0]; ++src, ++dst) {
-				dst[0] = (src[0] == '/') ? '\\' : src[0];
+	}
+	dst[0] = 0;
+
+	ptrdiff_t newsize = dst - dest;
+	assertH(newsize <= ptrdiff_t(maxlen));
+	return newsize;
+}
+
+template<bool MixedMode>
+std::string _tmpl_ConvertToMsw(const std::string& unix_path, int maxMountLength)
+{
+	std::string result;
+	result.resize(unix_path.length() + s_app0_dir.length());
+	auto len = _tmpl_ConvertToMsw<MixedMode>(unix_path.c_str(), unix_path.length(), maxMountLength, result.data(), result.size() + 1);
+	assertH(len >= 0);
+	result.resize(len);
+	return result;
+}
+
+static bool _isNormalizeSep(char c) {
+	return c == '/' || (PLATFORM_MSW && c == '\\');
+}
+
+size_t LexicallyNormalize(char* uni_path, size_t length) {
+	if (!length) {
+		return 0;
+	}
+
+	// the output never grows ahead of the input, so the buffer can be rewritten front-to-back in-place.
+	size_t read = 0, write = 0;
+	bool absolute = _isNormalizeSep(uni_path[0]);
+
+	size_t rootLength = 0;
+	if (absolute) {
+		bool network = length >= 2 && _isNormalizeSep(uni_path[1]) && !(length >= 3 && _isNormalizeSep(uni_path[2]));
+		rootLength = network ? 2 : 1;
+		for (size_t i = 0; i < rootLength; ++i) {
+			uni_path[write++] = '/';
+		}
+	}
+	else {
+		// a leading mount name (see FILESYSTEM_MOUNT_NAME_LENGTH) is a root as well, so that '..' cannot
+		// pop it:  rom:/../x -> rom:/x
+		size_t nameEnd = 0;
+		while (nameEnd < length && !_isNormalizeSep(uni_path[nameEnd])) {
+			++nameEnd;
+		}
+		if (nameEnd >= 2 && uni_path[nameEnd - 1] == ':') {
+			absolute	= true;
+			write		= nameEnd;
+			read		= nameEnd;
+			if (nameEnd < length) {
+				uni_path[write++] = '/';
 			}
+			rootLength	= write;
 		}
-		dst[0] = 0;
 	}
 
-	ptrdiff_t newsize = dst - result.c_str();
-	assertH(newsize <= ptrdiff_t(unix_path.length()));
+	while (read < length) {
+		while (read < length && _isNormalizeSep(uni_path[read])) {
+			++read;
+		}
+		if (read >= length) {
+			break;
+		}
 
-	if (append_approot) {
-		return s_app0_dir + result;
+		auto start = read;
+		while (read < length && !_isNormalizeSep(uni_path[read])) {
+			++read;
+		}
+		std::string_view segment = { uni_path + start, read - start };
+
+		if (segment == ".") {
+			continue;
+		}
+
+		if (segment == "..") {
+			if (write > rootLength) {
+				auto lastStart = write;
+				while (lastStart > rootLength && uni_path[lastStart - 1] != '/') {
+					--lastStart;
+				}
+				if (std::string_view{ uni_path + lastStart, write - lastStart } != "..") {
+					write = (lastStart > rootLength) ? lastStart - 1 : rootLength;
+					continue;
+				}
+			}
+			elif (absolute) {
+				// '..' at the root refers to the root itself.
+				continue;
+			}
+			// relative path with nothing left to pop: keep the '..'
+		}
+
+		if (write > rootLength) {
+			uni_path[write++] = '/';
+		}
+		memmove(uni_path + write, segment.data(), segment.size());
+		write += segment.size();
 	}
-	else {
-		result.resize(newsize);
-		return result;
+
+	if (!write) {
+		uni_path[write++] = '.';
 	}
+	return write;
 }
 
 path& path::append(const std::string& comp)
@@ -324,6 +433,7 @@ path& path::concat(const std::string& src)
 #if FILESYSTEM_NEEDS_OS_PATH
 	libc_path_ += src;
 #endif
+	hash_ = PathHash(src, hash_);
 	return *this;
 }
 
@@ -360,4 +470,9 @@ std::string ConvertToMswMixed(const std::string& unix_path, int maxMountLength)
 	return _tmpl_ConvertToMsw<MIXED_MODE>(unix_path, maxMountLength);
 }
 
+intptr_t ConvertToMsw(const char* unix_path, size_t length, char* dest, size_t destSize) {
+	constexpr auto mode = FILESYSTEM_MSW_MIXED_MODE ? MIXED_MODE : NATIVE_MODE;
+	return _tmpl_ConvertToMsw<mode>(unix_path, length, FILESYSTEM_MOUNT_NAME_LENGTH, dest, destSize);
+}
+
 }
@@ -4,6 +4,15 @@
 #include "icy_log.h"
 #include "icy_assert.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if PLATFORM_LINUX
+#   include <sys/sysmacros.h>
+#endif
+
 #if PLATFORM_MSW
 
 #define NOMINMAX
@@ -38,6 +47,29 @@ size_t _pread(int fd, void* dest, size_t count, x_off_t pos)
     return orig_count;
 }
 
+size_t _pwrite(int fd, const void* src, size_t count, x_off_t pos)
+{
+    // same caveats as _pread: emulated via seek, so not atomic with respect to other users of the fd.
+    _lseeki64(fd, pos, SEEK_SET);
+    auto orig_count = count;
+
+    const auto int_max = 0x7fff'fffeULL;
+
+    while (count > 0) {
+        auto towrite = std::min(count, int_max);
+        auto amt = _write(fd, src, (int)towrite);
+        if (amt < 0) {
+            return (orig_count == count) ? (size_t)-1 : orig_count - count;
+        }
+        count -= amt;
+        src = (const uint8_t*)src + amt;
+        if ((size_t)amt != towrite) {
+            break;
+        }
+    }
+    return orig_count - count;
+}
+
 CStatInfo posix_fstat(int fd) {
     struct _stat64 sinfo;
     if (_fstat64 (fd, &sinfo) == -1) {
@@ -87,23 +119,118 @@ int posix_link(const char* existing_file, const char* link)
 #endif
 
 #if PLATFORM_POSIX
-CStatInfo posix_stat(const char* path) {
-    struct stat st;
-    if (stat(path, &st) != 0) {
-        return {};
-    }
+#if PLATFORM_MAC
+#   define _stat_nsec(st, field)    ((int32_t)(st).field##timespec.tv_nsec)
+#else
+#   define _stat_nsec(st, field)    ((int32_t)(st).field##tim.tv_nsec)
+#endif
 
-    return {
+static CStatInfo _CStatInfoFromStat(const struct stat& st) {
+    CStatInfo result = {
         st.st_mode,
         st.st_size,
         st.st_atime,
         st.st_mtime,
         st.st_ctime
     };
+    result.time_accessed_nsec   = _stat_nsec(st, st_a);
+    result.time_modified_nsec   = _stat_nsec(st, st_m);
+    result.time_changed_nsec    = _stat_nsec(st, st_c);
+    result.st_dev               = (uint64_t)st.st_dev;
+    result.st_ino               = (uint64_t)st.st_ino;
+    return result;
+}
+
+CStatInfo posix_stat(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return {};
+    }
+    return _CStatInfoFromStat(st);
+}
+
+CStatInfo posix_fstat(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return {};
+    }
+    return _CStatInfoFromStat(st);
+}
+
+#endif
+
+#if PLATFORM_LINUX
+CStatInfo posix_statx_to_info(const struct statx& stx) {
+    CStatInfo result = {
+        stx.stx_mode,
+        (intmax_t)stx.stx_size,
+        stx.stx_atime.tv_sec,
+        stx.stx_mtime.tv_sec,
+        stx.stx_ctime.tv_sec
+    };
+    result.time_accessed_nsec   = (int32_t)stx.stx_atime.tv_nsec;
+    result.time_modified_nsec   = (int32_t)stx.stx_mtime.tv_nsec;
+    result.time_changed_nsec    = (int32_t)stx.stx_ctime.tv_nsec;
+    result.st_dev               = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    result.st_ino               = stx.stx_ino;
+    return result;
 }
 
+// statx fetches only the requested fields, and on some filesystems (network, FUSE) skips work that stat
+// would otherwise do for fields we don't use (eg. st_blocks).
+static CStatInfo _posix_statx(const char* path) {
+    struct statx stx;
+    if (statx(AT_FDCWD, path, AT_STATX_SYNC_AS_STAT, kPosixStatxMask, &stx) != 0) {
+        return {};
+    }
+    return posix_statx_to_info(stx);
+}
+#else
+static CStatInfo _posix_statx(const char* path) {
+    return posix_stat(path);
+}
 #endif
 
+intmax_t posix_stat_batch(const char* const* paths, size_t count, CStatInfo* dest, int numThreads) {
+    // paths are claimed in chunks from a shared cursor, so that threads which hit slow paths (cold
+    // metadata, network mounts) don't hold up the rest of the batch.
+    static constexpr size_t kChunkSize = 64;
+
+    if (numThreads <= 0) {
+        auto wanted = (int)std::min<size_t>(count / (kChunkSize * 4), std::thread::hardware_concurrency());
+        numThreads  = std::max(1, wanted);
+    }
+
+    std::atomic<size_t> cursor = 0;
+    std::atomic<size_t> found  = 0;
+
+    auto worker = [&] {
+        size_t localFound = 0;
+        for (;;) {
+            auto start = cursor.fetch_add(kChunkSize, std::memory_order_relaxed);
+            if (start >= count) {
+                break;
+            }
+            auto end = std::min(count, start + kChunkSize);
+            for (auto i = start; i < end; ++i) {
+                dest[i] = _posix_statx(paths[i]);
+                localFound += dest[i].Exists();
+            }
+        }
+        found.fetch_add(localFound, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return (intmax_t)found.load();
+}
+
 bool CStatInfo::IsFile     () const { return (st_mode & S_IFREG) == S_IFREG  ;}
 bool CStatInfo::IsDir      () const { return (st_mode & S_IFDIR) == S_IFDIR  ;}
 bool CStatInfo::Exists     () const { return (st_mode & S_IFMT ) != 0        ;}
@@ -13,3 +13,21 @@ bool StandardFileSystem::Exists(const fs::path& path) {
 void StandardFileSystem::VisitDirectoryContents(const std::function<void(const fs::path& path)>& visitFunc, const fs::path& path) {
 	fs::directory_iterator(visitFunc, path);
 }
+
+std::unique_ptr<fs::InputStream> StandardFileSystem::Open(const fs::path& path) {
+	auto st = posix_stat(path);
+	if (!st.Exists() || st.IsDir()) {
+		return nullptr;
+	}
+	if (st.IsFile()) {
+		auto stream = std::make_unique<fs::MappedStream>(path);
+		if (stream->is_open()) {
+			return stream;
+		}
+	}
+	auto stream = std::make_unique<fs::FdStream>(path);
+	if (!stream->is_open()) {
+		return nullptr;
+	}
+	return stream;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2021-2025, Implicit Conversions, Inc. Subject to the MIT License. See LICENSE file.
+
+// packtool - creates and inspects pack archives, see PackArchive.h.
+//
+//   packtool <out.pack> <input-dir> [name-prefix]    packs all files beneath input-dir
+//   packtool --list <archive.pack>                   lists entries: offset, size, checksum, name
+//   packtool --verify <archive.pack>                 verifies all payload checksums
+
+#include "PackArchive.h"
+#include "StringUtil.h"
+
+#include "msw-app-console-init.h"
+
+#include <cstdio>
+
+static int usage() {
+	fprintf(stderr,
+		"usage:\n"
+		"  packtool <out.pack> <input-dir> [name-prefix]\n"
+		"  packtool --list <archive.pack>\n"
+		"  packtool --verify <archive.pack>\n"
+	);
+	return 1;
+}
+
+int main(int argc, char** argv) {
+
+#if PLATFORM_MSW
+	msw_AllocConsoleForWindowedApp();
+#endif
+
+	if (argc < 3) {
+		return usage();
+	}
+
+	if (strcasecmp(argv[1], "--list") == 0 || strcasecmp(argv[1], "--verify") == 0) {
+		bool verify = strcasecmp(argv[1], "--verify") == 0;
+		PackArchive pack;
+		if (!pack.open(argv[2], { .verify_payloads = verify })) {
+			return 1;
+		}
+		if (verify) {
+			printf("%s: %zu entries OK\n", argv[2], pack.entries().size());
+			return 0;
+		}
+		for (auto& ent : pack.entries()) {
+			auto name = pack.name(ent);
+			printf("%10llu %10llu %08x %.*s\n", (unsigned long long)ent.offset, (unsigned long long)ent.size,
+				ent.checksum, (int)name.size(), name.data());
+		}
+		return 0;
+	}
+
+	if (argv[1][0] == '-') {
+		return usage();
+	}
+
+	PackBuilder builder;
+	if (builder.addDirectory(argv[2], argc > 3 ? argv[3] : "") < 0) {
+		return 1;
+	}
+	if (!builder.write(argv[1])) {
+		return 1;
+	}
+	printf("%s: packed %zu files\n", argv[1], builder.size());
+	return 0;
+}